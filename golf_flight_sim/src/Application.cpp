@@ -3,9 +3,12 @@
 #include "../lib/imgui/imgui.h"
 #include "../lib/imgui/imgui_impl_sdl.h"
 #include "../lib/imgui/imgui_impl_sdlrenderer.h"
-#include "./Physics/coefficients.h"
 #include "./Physics/constants.h"
-#include "./Physics/force.h"
+#include "./Physics/launch.h"
+#include "./Physics/putting.h"
+#include "./Physics/sensitivity.h"
+#include "./Profiler/Profiler.h"
+#include "./Terrain/terrain_file.h"
 #include "./math/trig.h"
 #include "./math/unit_conversion.h"
 #include "./misc/colors.h"
@@ -14,7 +17,8 @@
 #include "Graphics.h"
 #include <SDL_image.h>
 #include <SDL_ttf.h>
-#include <chrono>
+#include <algorithm>
+#include <climits>
 #include <cmath>
 #include <iostream>
 #include <sstream>
@@ -24,14 +28,22 @@ Uint16 Application::window_height;
 
 bool Application::display_forces = false;
 bool Application::display_trajectories = false;
+bool Application::display_profiler = false;
+
+static bool is_same_request(const DiagnosticsRequest &a,
+                            const DiagnosticsRequest &b) {
+
+  return a.on_screen == b.on_screen && a.view.min_x == b.view.min_x
+         && a.view.max_x == b.view.max_x && a.view.max_z == b.view.max_z
+         && a.view.max_abs_y == b.view.max_abs_y && a.first_id == b.first_id
+         && a.last_id == b.last_id;
 
-float get_spin_rate(float spin_rate, float time) {
-  return spin_rate * std::expf(-time / SPIN_DECAY_RATE);
 }
 
-void Application::draw_primitives() {
+void Application::draw_primitives(const SimulationSnapshot &snapshot) {
 
   ZoneScoped; // for tracy
+  PROFILE_SCOPE(DRAW_PRIMITIVES);
 
   // WORLD COORDINATES SYSTEM SHOULD ALWAYS BE IN METERS!!! ONLY USE FEET AND
   // YARDS FOR IMGUI STUFF!!
@@ -77,6 +89,125 @@ void Application::draw_primitives() {
   boxColor(renderer, groundR_x1, groundR_y1, groundR_x2, groundR_y2,
            ground_color);
 
+  // World to screen coordinates, the same way as the balls below
+  auto side_x = [&](float x) {
+    return static_cast<Sint16>((x - windows_world_min_x)
+                               * windowL_pixels_per_meter);
+  };
+  auto side_y = [&](float z) {
+    return static_cast<Sint16>(static_cast<float>(groundL_y2)
+                               - z * windowL_pixels_per_meter);
+  };
+  auto top_x = [&](float y) {
+    return static_cast<Sint16>(static_cast<float>(windowR_center)
+                               - y * windowR_pixels_per_meter);
+  };
+  auto top_y = [&](float x) {
+    return static_cast<Sint16>(
+        static_cast<float>(windowR->height)
+        - (x - windows_world_min_x) * windowR_pixels_per_meter);
+  };
+
+  // The surface materials on the ground in the top view, a run of cells
+  // along x at a time
+  if (!surface_map->is_uniform()) {
+
+    // In the order of SurfaceMaterial: green, fairway, rough, bunker
+    const Uint32 surface_colors[NUM_SURFACE_MATERIALS] = {
+        0xFF4FA636, ground_color, 0xFF23400C, 0xFF8CD2E6};
+
+    const float origin_x = surface_map->get_origin_x();
+    const float origin_y = surface_map->get_origin_y();
+    const float spacing = surface_map->get_spacing();
+    const int cells_x = surface_map->get_cells_x();
+
+    for (int j = 0; j < surface_map->get_cells_y(); j++) {
+
+      Sint16 left = top_x(origin_y + static_cast<float>(j + 1) * spacing);
+      Sint16 right = top_x(origin_y + static_cast<float>(j) * spacing);
+
+      if (right <= windowborderR) {
+        continue;
+      }
+
+      left = std::max(left, windowborderR);
+
+      for (int i = 0; i < cells_x;) {
+
+        SurfaceMaterial material = surface_map->get_cell(i, j);
+        int end = i + 1;
+
+        while (end < cells_x && surface_map->get_cell(end, j) == material) {
+          end++;
+        }
+
+        boxColor(renderer, left,
+                 top_y(origin_x + static_cast<float>(end) * spacing), right,
+                 top_y(origin_x + static_cast<float>(i) * spacing),
+                 surface_colors[static_cast<int>(material)]);
+
+        i = end;
+
+      }
+
+    }
+
+  }
+
+  // The terrain along the target line, on top of the ground in the side view
+  if (!terrain->is_flat()) {
+
+    const Uint32 terrain_color = 0xFF52801A;
+    const int profile_step = 4; // in pixels
+
+    vec2 previous_point;
+
+    for (int x = 0; x <= windowborderL; x += profile_step) {
+
+      float world_x = windows_world_min_x
+                      + static_cast<float>(x) / windowL_pixels_per_meter;
+      float height = terrain->get_height(world_x, 0.0f);
+
+      vec2 point(static_cast<float>(x),
+                 static_cast<float>(groundL_y2)
+                     - height * windowL_pixels_per_meter);
+
+      if (x > 0) {
+        Graphics::draw_line(renderer, previous_point, point, terrain_color);
+      }
+
+      previous_point = point;
+
+    }
+
+  }
+
+  // Obstacles as their bounds, in both views
+  if (obstacles) {
+
+    const Uint32 obstacle_color = 0xFF1E4D14;
+
+    for (const ObstacleShape &shape : obstacles->get_shapes()) {
+
+      vec3 min, max;
+      get_shape_bounds(shape, min, max);
+
+      if (side_x(min.x) < windowborderL) {
+        rectangleColor(renderer, side_x(min.x), side_y(max.z),
+                       std::min(side_x(max.x), windowborderL), side_y(min.z),
+                       obstacle_color);
+      }
+
+      if (top_x(min.y) > windowborderR) {
+        rectangleColor(renderer, std::max(top_x(max.y), windowborderR),
+                       top_y(max.x), top_x(min.y), top_y(min.x),
+                       obstacle_color);
+      }
+
+    }
+
+  }
+
   // Draw the distance markers
 
   for (int i = 0; i < distance_markers->num_markers; i++) {
@@ -171,26 +302,35 @@ void Application::draw_primitives() {
   Graphics::draw_line(renderer, beginning_marker_start_point,
                       beginning_marker_end_point, colors::GREEN);
 
+  // The simulation only works out the forces for the balls in view
+  diagnostics_request.on_screen = display_forces;
+  diagnostics_request.view.min_x = windows_world_min_x;
+  diagnostics_request.view.max_x = windows_world_max_x;
+  diagnostics_request.view.max_z =
+      static_cast<float>(groundL_y2) / windowL_pixels_per_meter;
+  diagnostics_request.view.max_abs_y =
+      static_cast<float>(windowR->width / 2) / windowR_pixels_per_meter;
+
   // Draw all the balls in the scene
   const Uint32 ball_color = colors::WHITE;
   const Sint16 ball_radius = 4;
 
-  for (auto &ball : balls) {
+  for (const BallSnapshot &ball : snapshot.balls) {
 
     ZoneNamedN(ball_draw_scope, "Ball Draw Routine", true); // for tracy
 
     // Calculate the screen coordinates of the ball for both the left and right
     // windows
     vec2 windowL_ball_coordinates = vec2(
-        (ball->position.x - windows_world_min_x) * windowL_pixels_per_meter,
-        (ball->position.z * windowL_pixels_per_meter * -1.0f)
+        (ball.position.x - windows_world_min_x) * windowL_pixels_per_meter,
+        (ball.position.z * windowL_pixels_per_meter * -1.0f)
             + static_cast<float>(groundL_y2));
 
     vec2 windowR_ball_coordinates =
-        vec2(-(ball->position.y * windowR_pixels_per_meter)
+        vec2(-(ball.position.y * windowR_pixels_per_meter)
                  + static_cast<float>(windowR_center),
              static_cast<float>(windowR->height)
-                 - ((ball->position.x - windows_world_min_x)
+                 - ((ball.position.x - windows_world_min_x)
                     * windowR_pixels_per_meter));
 
     // Draw the trajectories of all balls to the trajectories texture
@@ -247,9 +387,14 @@ void Application::draw_primitives() {
                         ball_radius, ball_color);
     }
 
-    if (display_forces) {
+    // Balls whose diagnostics haven't come through yet, e.g. the first frame
+    // after the forces are turned on, are drawn without them
+    if (display_forces && ball.diagnostics >= 0) {
+
+      const BallDiagnostics &diagnostics =
+          snapshot.diagnostics[ball.diagnostics];
 
-      float velocity_squared = ball->velocity.dot(ball->velocity);
+      float velocity_squared = ball.velocity.dot(ball.velocity);
 
       // Only draw the forces when the ball is in motion.
       if (velocity_squared > MIN_ROLL_VELOCITY_SQUARED) {
@@ -258,14 +403,14 @@ void Application::draw_primitives() {
 
         // Velocity
         Graphics::draw_force_vector(
-            renderer, ball->velocity, windowL_ball_coordinates,
+            renderer, ball.velocity, windowL_ball_coordinates,
             windowR_ball_coordinates, windowL_pixels_per_meter,
             windowR_pixels_per_meter, ball_radius, windowborderL, windowborderR,
             colors::BLUE);
 
         // Acceleration
         Graphics::draw_force_vector(
-            renderer, ball->acceleration, windowL_ball_coordinates,
+            renderer, diagnostics.acceleration, windowL_ball_coordinates,
             windowR_ball_coordinates, windowL_pixels_per_meter,
             windowR_pixels_per_meter, ball_radius, windowborderL, windowborderR,
             colors::RED);
@@ -279,16 +424,16 @@ void Application::draw_primitives() {
 
       }
 
-      if (!ball->is_rolling) {
+      if (!ball.is_rolling) {
 
         // Wind
         Graphics::draw_force_vector(
-            renderer, ball->wind_force, windowL_ball_coordinates,
+            renderer, diagnostics.wind_velocity, windowL_ball_coordinates,
             windowR_ball_coordinates, windowL_pixels_per_meter,
             windowR_pixels_per_meter, ball_radius, windowborderL, windowborderR,
             colors::GREEN);
 
-        vec3 lift_force_ms = ball->lift_force * INV_BALL_MASS;
+        vec3 lift_force_ms = diagnostics.lift_force * INV_BALL_MASS;
 
         // Lift
         Graphics::draw_force_vector(
@@ -297,7 +442,7 @@ void Application::draw_primitives() {
             windowR_pixels_per_meter, ball_radius, windowborderL, windowborderR,
             colors::YELLOW);
 
-        vec3 drag_force_ms = ball->drag_force * INV_BALL_MASS;
+        vec3 drag_force_ms = diagnostics.drag_force * INV_BALL_MASS;
 
         // Drag
         Graphics::draw_force_vector(
@@ -329,20 +474,19 @@ void Application::draw_primitives() {
            static_cast<Sint16>(window_height), 0xFF183211);
 
   // Draw all the text labels
-  // Update the counters
-  text_strings[0]->text =
-      "FPS: " + string_ops::float_to_string_formatted(current_fps, 1);
-  text_strings[1]->text = "Number of balls: " + std::to_string(balls.size());
+  // Update the counters. These get rewritten every frame, so they're built
+  // in place without allocating.
+  text_strings[0]->text = "FPS: ";
+  text_strings[0]->text.append_fixed(current_fps, 1);
+
+  text_strings[1]->text = "Number of balls: ";
+  text_strings[1]->text.append_int(
+      static_cast<long long>(snapshot.balls.size()));
 
   // Add a space in front to keep the wind text offset and centered when the
   // counter goes below 10 mph.
-  if (wind->speed < 9.5f) {
-    text_strings[3]->text =
-        " " + string_ops::float_to_string_formatted(wind->speed, 0) + " MPH";
-  } else {
-    text_strings[3]->text =
-        string_ops::float_to_string_formatted(wind->speed, 0) + " MPH";
-  }
+  text_strings[3]->text = (wind->speed < 9.5f) ? " " : "";
+  text_strings[3]->text.append_fixed(wind->speed, 0).append(" MPH");
 
   for (auto &text : text_strings) {
 
@@ -378,9 +522,10 @@ void Application::draw_primitives() {
 
 }
 
-void Application::draw_imgui_gui() {
+void Application::draw_imgui_gui(const SimulationSnapshot &snapshot) {
 
   ZoneScoped; // for tracy
+  PROFILE_SCOPE(IMGUI);
 
   ImGui_ImplSDLRenderer_NewFrame();
   ImGui_ImplSDL2_NewFrame();
@@ -419,9 +564,152 @@ void Application::draw_imgui_gui() {
     ImGui::Spacing();
 
     // Adjust the wind vector in real time based on these fields
-    ImGui::SliderFloat("Wind Speed (mph)", &wind->speed, 0, 30);
-    ImGui::SliderAngle("Wind Heading (deg)", &wind->direction, 0, 360);
-    ImGui::Checkbox("Use logarithmic wind model", &wind->log_wind);
+    bool wind_changed = false;
+    wind_changed |=
+        ImGui::SliderFloat("Wind Speed (mph)", &wind->speed, 0, 30);
+    wind_changed |=
+        ImGui::SliderAngle("Wind Heading (deg)", &wind->direction, 0, 360);
+    wind_changed |=
+        ImGui::Checkbox("Use logarithmic wind model", &wind->log_wind);
+
+    if (wind_changed) {
+      simulation->set_wind(*wind);
+    }
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    ImGui::Text("Air Settings");
+    ImGui::Spacing();
+
+    // Sea level on a mild, dry day to start with, close to the air the
+    // coefficients were measured in
+    static float altitude_ft = 0.0f;
+    static float temperature_f = 68.0f;
+    static float humidity_percent = 0.0f;
+    static SiteConditions site = STANDARD_SITE;
+    static AirProperties air = get_air_properties(site);
+
+    bool air_changed = false;
+    air_changed |=
+        ImGui::SliderFloat("Altitude (ft)", &altitude_ft, 0, 10000, "%.0f");
+    air_changed |= ImGui::SliderFloat("Temperature (F)", &temperature_f, 20,
+                                      110, "%.0f");
+    air_changed |= ImGui::SliderFloat("Humidity (%)", &humidity_percent, 0,
+                                      100, "%.0f");
+
+    if (air_changed) {
+
+      site.altitude = ft_to_m(altitude_ft);
+      site.temperature = f_to_c(temperature_f);
+      site.relative_humidity = humidity_percent / 100.0f;
+      air = get_air_properties(site);
+
+      simulation->set_air(site);
+
+    }
+
+    ImGui::Text("Air density: %.3f kg/m^3", air.density);
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    ImGui::Text("Physics Settings");
+    ImGui::Spacing();
+
+    static int integrator =
+        static_cast<int>(IntegratorType::SEMI_IMPLICIT_EULER);
+    static int ground = static_cast<int>(GroundType::SLOW_GREEN);
+    static int aero_model = static_cast<int>(AeroModelType::TABLE);
+
+    bool models_changed = false;
+    models_changed |= ImGui::Combo("Integrator", &integrator,
+                                   "Semi-implicit Euler\0Midpoint\0");
+    models_changed |= ImGui::Combo("Green Speed", &ground,
+                                   "Slow (stimp 6)\0Fast (stimp 10)\0");
+    models_changed |= ImGui::Combo("Aerodynamics", &aero_model,
+                                   "Table\0Smooth fit\0");
+
+    if (models_changed) {
+      simulation->set_models(static_cast<IntegratorType>(integrator),
+                             static_cast<GroundType>(ground),
+                             static_cast<AeroModelType>(aero_model));
+    }
+
+    static int terrain_type = 0;
+    static bool terrain_failed = false;
+    bool terrain_changed = false;
+
+    if (ImGui::Combo("Terrain", &terrain_type,
+                     "Flat\0Rolling hills\0Streamed course\0")) {
+
+      terrain_failed = false;
+
+      if (terrain_type == 2) {
+
+        auto streamer = std::make_shared<TerrainStreamer>();
+
+        if (streamer->open(EXAMPLE_COURSE_PATH)) {
+          terrain = std::shared_ptr<const Terrain>(streamer,
+                                                   &streamer->get_overview());
+          simulation->set_terrain_streamer(std::move(streamer));
+          terrain_changed = true;
+        } else {
+          terrain_failed = true;
+        }
+
+      } else {
+
+        terrain = std::make_shared<const Terrain>(
+            terrain_type == 0 ? Terrain() : Terrain::rolling_hills());
+        simulation->set_terrain(terrain);
+        terrain_changed = true;
+
+      }
+
+    }
+
+    if (terrain_failed) {
+      ImGui::TextWrapped("Couldn't open %s. Run with --write-course to make "
+                         "one.",
+                         EXAMPLE_COURSE_PATH);
+    }
+
+    // Stood on the terrain, so they move with it
+    static bool use_obstacles = false;
+
+    if (ImGui::Checkbox("Trees, flagsticks and net", &use_obstacles)
+        || (terrain_changed && use_obstacles)) {
+
+      obstacles = nullptr;
+
+      if (use_obstacles) {
+        obstacles = std::make_shared<const Obstacles>(
+            Obstacles::driving_range(*terrain));
+      }
+
+      simulation->set_obstacles(obstacles);
+
+    }
+
+    static bool use_surfaces = false;
+
+    if (ImGui::Checkbox("Fairway, rough, greens and bunkers",
+                        &use_surfaces)) {
+
+      surface_map = std::make_shared<const SurfaceMap>(
+          use_surfaces ? SurfaceMap::driving_range() : SurfaceMap());
+      simulation->set_surface_map(surface_map);
+
+    }
+
+    static bool adaptive_stepping = true;
+
+    if (ImGui::Checkbox("Adaptive time steps", &adaptive_stepping)) {
+      simulation->set_adaptive_stepping(adaptive_stepping);
+    }
 
     ImGui::Spacing();
     ImGui::Separator();
@@ -436,10 +724,104 @@ void Application::draw_imgui_gui() {
 
     ImGui::Checkbox("Toggle ball trajectories", &display_trajectories);
 
+#ifdef PROFILER_ENABLE
+    ImGui::Checkbox("Show profiler", &display_profiler);
+#endif
+
+    int pacing_mode = static_cast<int>(frame_scheduler->get_mode());
+
+    if (ImGui::Combo("Frame Pacing", &pacing_mode,
+                     "Capped\0VSync\0Uncapped\0")) {
+      set_pacing_mode(static_cast<PacingMode>(pacing_mode));
+    }
+
+    if (ImGui::CollapsingHeader("Frame Timing")) {
+
+      const FrameTimeHistogram &histogram = frame_scheduler->get_histogram();
+
+      ImGui::Text("Average frame time: %.3f ms (%.1f FPS)",
+                  frame_scheduler->get_average_frame_time_ms(),
+                  frame_scheduler->get_fps());
+
+      ImGui::PlotLines("##frame_times",
+                       frame_scheduler->get_frame_time_history(),
+                       frame_scheduler->get_frame_time_history_size(),
+                       frame_scheduler->get_frame_time_history_offset(),
+                       "frame time (ms)", 0.0f, FLT_MAX, ImVec2(0, 40));
+
+      ImGui::PlotHistogram("##frame_time_histogram", histogram.bins,
+                           FrameTimeHistogram::NUM_BINS, 0,
+                           "frame time histogram (0-50 ms)", 0.0f, FLT_MAX,
+                           ImVec2(0, 40));
+
+    }
+
+    if (ImGui::CollapsingHeader("Simulation Phases")) {
+
+      static const char *PHASE_NAMES[NUM_BALL_PHASES] = {"Flight", "Impact",
+                                                         "Roll", "Rest"};
+
+      const SimulationPhaseStats &stats = snapshot.phase_stats;
+
+      if (ImGui::BeginTable("phase_stats", 3)) {
+
+        ImGui::TableSetupColumn("Phase");
+        ImGui::TableSetupColumn("Balls");
+        ImGui::TableSetupColumn("Time (us)");
+        ImGui::TableHeadersRow();
+
+        for (int i = 0; i < NUM_BALL_PHASES; i++) {
+
+          ImGui::TableNextRow();
+          ImGui::TableSetColumnIndex(0);
+          ImGui::TextUnformatted(PHASE_NAMES[i]);
+          ImGui::TableSetColumnIndex(1);
+          ImGui::Text("%d", stats.population[i]);
+          ImGui::TableSetColumnIndex(2);
+          ImGui::Text("%.2f", stats.time_us[i]);
+
+        }
+
+        ImGui::EndTable();
+
+      }
+
+      ImGui::Text("Flight steps: %d of %d balls", stats.flight_steps,
+                  stats.population[0]);
+      ImGui::Text("Partitioning: %.2f us", stats.partition_time_us);
+
+    }
+
+    if (snapshot.terrain_streamed
+        && ImGui::CollapsingHeader("Terrain Cache")) {
+
+      const TerrainCacheStats &cache = snapshot.terrain_cache;
+
+      ImGui::Text("Hit rate: %.2f%%", cache.get_hit_rate() * 100.0f);
+      ImGui::Text("Tiles: %d resident, %d loading, of %d",
+                  cache.resident_tiles, cache.loading_tiles, cache.capacity);
+      ImGui::Text("Loads: %llu, evictions: %llu",
+                  static_cast<unsigned long long>(cache.loads),
+                  static_cast<unsigned long long>(cache.evictions));
+
+    }
+
     ImGui::Spacing();
     ImGui::Separator();
     ImGui::Spacing();
 
+    // Convert the units of the launch parameters
+    LaunchConditions<float> launch;
+    launch.speed = mph_to_ms(launch_speed_mph);
+    launch.angle = deg_to_rad(launch_angle_deg);
+    launch.heading = deg_to_rad(launch_heading_deg);
+    launch.spin_rate = launch_spin_rate;
+    launch.spin_axis = deg_to_rad(spin_axis_deg);
+
+    // The tee sits on the terrain at the origin
+    vec3 tee_position(0.0f, 0.0f,
+                      terrain->get_height(0.0f, 0.0f) + TEE_HEIGHT);
+
     if (ImGui::Button("Launch Ball")) {
 
       /*
@@ -448,31 +830,11 @@ void Application::draw_imgui_gui() {
         so balls, so be careful!
       */
 
-      // Convert the units of the launch parameters
-      float launch_speed = mph_to_ms(launch_speed_mph);
-      float launch_angle = deg_to_rad(launch_angle_deg);
-      float launch_heading = deg_to_rad(launch_heading_deg) * -1.0f;
-      float spin_axis_2d = deg_to_rad(spin_axis_deg);
-
-      // Set the initial position and velocity vectors
-      float tee_height = 0.0381f; // in meters (1.5 inches)
-      auto ball_position = vec3(0.0, 0.0, tee_height);
-      auto ball_velocity =
-          vec3(launch_speed * cosf(launch_angle) * cosf(launch_heading),
-               launch_speed * cosf(launch_angle) * sinf(launch_heading),
-               launch_speed * sinf(launch_angle));
-
-      // Calculate the 3D axis of rotation based on the launch heading and the
-      // spin axis angle.
-      auto rotation_axis =
-          vec3(cosf(spin_axis_2d) * sinf(launch_heading),
-               -cosf(spin_axis_2d) * cosf(launch_heading), spin_axis_2d);
-
-      // Create a new ball and add it to the vector of balls
-      std::unique_ptr<Ball> ball = std::make_unique<Ball>(
-          ball_position, ball_velocity, rotation_axis, launch_spin_rate);
+      FlightState<float> state = get_launch_state(launch, tee_position);
 
-      balls.push_back(std::move(ball));
+      // Hand the new ball over to the simulation
+      simulation->launch_ball(state.position, state.velocity,
+                              state.rotation_axis, state.launch_spin_rate);
 
     }
 
@@ -482,48 +844,28 @@ void Application::draw_imgui_gui() {
 
       // Launches 11 balls instead of one
 
-      // Convert the units of the launch parameters
-      float launch_speed = mph_to_ms(launch_speed_mph);
-      float launch_angle = deg_to_rad(launch_angle_deg);
-      float launch_heading = deg_to_rad(launch_heading_deg) * -1.0f;
-      float spin_axis_2d = deg_to_rad(spin_axis_deg);
+      FlightState<float> state = get_launch_state(launch, tee_position);
 
-      // Set the initial position and velocity vectors
-      float tee_height = 0.0381f; // in meters (1.5 inches)
-      auto ball_position = vec3(0.0, 0.0, tee_height);
-      auto ball_velocity =
-          vec3(launch_speed * cosf(launch_angle) * cosf(launch_heading),
-               launch_speed * cosf(launch_angle) * sinf(launch_heading),
-               launch_speed * sinf(launch_angle));
+      // Hand the new ball over to the simulation
+      simulation->launch_ball(state.position, state.velocity,
+                              state.rotation_axis, state.launch_spin_rate);
 
-      // Calculate the 3D axis of rotation based on the launch heading and the
-      // spin axis angle.
-      auto rotation_axis =
-          vec3(cosf(spin_axis_2d) * sinf(launch_heading),
-               -cosf(spin_axis_2d) * cosf(launch_heading), spin_axis_2d);
-
-      // Create a new ball and add it to the vector of balls
-      std::unique_ptr<Ball> ball = std::make_unique<Ball>(
-          ball_position, ball_velocity, rotation_axis, launch_spin_rate);
-
-      balls.push_back(std::move(ball));
+      // The world heading is the negative of the UI's
+      float launch_heading = -launch.heading;
 
       for (int i = 1; i <= 5; i++) {
 
-        spin_axis_2d = deg_to_rad(10.0f * static_cast<float>(i));
-        rotation_axis =
+        float spin_axis_2d = deg_to_rad(10.0f * static_cast<float>(i));
+        auto rotation_axis =
             vec3(cosf(spin_axis_2d) * sinf(launch_heading),
                  -cosf(spin_axis_2d) * cosf(launch_heading), spin_axis_2d);
         auto rotation_axis_2 =
             vec3(rotation_axis.x, -rotation_axis.y, rotation_axis.z);
 
-        std::unique_ptr<Ball> ball1 = std::make_unique<Ball>(
-            ball_position, ball_velocity, rotation_axis, launch_spin_rate);
-        std::unique_ptr<Ball> ball2 = std::make_unique<Ball>(
-            ball_position, ball_velocity, -rotation_axis_2, launch_spin_rate);
-
-        balls.push_back(std::move(ball1));
-        balls.push_back(std::move(ball2));
+        simulation->launch_ball(state.position, state.velocity,
+                                rotation_axis, launch_spin_rate);
+        simulation->launch_ball(state.position, state.velocity,
+                                -rotation_axis_2, launch_spin_rate);
 
       }
 
@@ -534,7 +876,7 @@ void Application::draw_imgui_gui() {
     if (ImGui::Button("Clear Balls")) {
 
       // Delete all the balls from the scene and remove the trajectories if they exist
-      balls.clear();
+      simulation->clear_balls();
 
       if (trajectories_texture) {
 
@@ -550,6 +892,199 @@ void Application::draw_imgui_gui() {
 
     }
 
+    if (ImGui::CollapsingHeader("Launch Sensitivities")) {
+
+      static bool has_sensitivities = false;
+      static LaunchSensitivities sensitivities;
+
+      // One pass through the flight model with dual numbers, for the current
+      // launch, wind, air, integrator and aerodynamics
+      if (ImGui::Button("Compute")) {
+
+        float wind_speed_ms = mph_to_ms(wind->speed);
+        auto wind_velocity = vec3(wind_speed_ms * cosf(wind->direction),
+                                  wind_speed_ms * sinf(wind->direction), 0.0f);
+
+        WindModelType wind_model = wind->log_wind ? WindModelType::LOGARITHMIC
+                                                  : WindModelType::UNIFORM;
+
+        sensitivities = get_launch_sensitivities(
+            launch, vec3(0.0f, 0.0f, TEE_HEIGHT), wind_velocity,
+            get_air_constants(site), wind_model,
+            static_cast<IntegratorType>(integrator),
+            static_cast<AeroModelType>(aero_model),
+            1.0f / PHYSICS_STEPS_PER_SECOND);
+        has_sensitivities = true;
+
+      }
+
+      if (has_sensitivities) {
+
+        const Landing &landing = sensitivities.landing;
+
+        ImGui::Text("Carry: %.2f yds, offline: %.2f yds, flight time: %.2f s",
+                    m_to_yd(landing.carry), m_to_yd(landing.offline),
+                    landing.flight_time);
+
+        static const char *INPUT_NAMES[NUM_LAUNCH_INPUTS] = {
+            "Speed (per mph)", "Angle (per deg)", "Heading (per deg)",
+            "Spin Rate (per rpm)", "Spin Axis (per deg)"};
+
+        // The gradients are per m/s, radian and rpm
+        const float INPUT_UNITS[NUM_LAUNCH_INPUTS] = {
+            mph_to_ms(1.0f), deg_to_rad(1.0f), deg_to_rad(1.0f), 1.0f,
+            deg_to_rad(1.0f)};
+
+        if (ImGui::BeginTable("launch_sensitivities", 3)) {
+
+          ImGui::TableSetupColumn("Input");
+          ImGui::TableSetupColumn("Carry (yds)");
+          ImGui::TableSetupColumn("Offline (yds)");
+          ImGui::TableHeadersRow();
+
+          for (int i = 0; i < NUM_LAUNCH_INPUTS; i++) {
+
+            const Landing &gradient = sensitivities.gradient[i];
+
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            ImGui::TextUnformatted(INPUT_NAMES[i]);
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%.4f", m_to_yd(gradient.carry) * INPUT_UNITS[i]);
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%.4f", m_to_yd(gradient.offline) * INPUT_UNITS[i]);
+
+          }
+
+          ImGui::EndTable();
+
+        }
+
+      }
+
+    }
+
+    if (ImGui::CollapsingHeader("Putting")) {
+
+      static const Terrain green = Terrain::practice_green();
+
+      // From the ball at the origin to the hole
+      static float hole_distance = 6.0f;
+      static float hole_offset = 1.0f;
+      static int read_ground = -1;
+      static bool inputs_changed = true;
+      static GreenReading reading;
+      static std::vector<vec3> best_path;
+
+      inputs_changed |= ImGui::SliderFloat("Hole Distance (m)", &hole_distance,
+                                           1.0f, 20.0f, "%.1f");
+      inputs_changed |= ImGui::SliderFloat("Hole Offset (m)", &hole_offset,
+                                           -5.0f, 5.0f, "%.1f");
+      inputs_changed |= read_ground != ground;
+
+      vec3 start(0.0f, 0.0f, green.get_height(0.0f, 0.0f));
+      vec3 hole(hole_distance, hole_offset,
+                green.get_height(hole_distance, hole_offset));
+
+      const float deceleration =
+          get_surface_table(static_cast<GroundType>(ground))
+              .roll_deceleration[static_cast<int>(SurfaceMaterial::GREEN)];
+
+      // Only read again when something moved, it takes tens of milliseconds
+      if (inputs_changed) {
+
+        reading = read_green(green, start, hole, deceleration,
+                             get_default_sweep(start, hole, deceleration));
+
+        best_path.clear();
+        if (reading.num_holed > 0) {
+          roll_putt(green, start, hole, reading.best_speed, reading.best_aim,
+                    deceleration, &best_path);
+        }
+
+        read_ground = ground;
+        inputs_changed = false;
+
+      }
+
+      const PuttSweep &sweep = reading.sweep;
+
+      ImGui::Text("%d of %d putts drop, read in %.1f ms", reading.num_holed,
+                  sweep.num_speeds * sweep.num_aims, reading.time_ms);
+
+      if (reading.num_holed > 0) {
+        ImGui::Text("Best putt: %.2f m/s, %.1f deg %s of the hole",
+                    reading.best_speed, rad_to_deg(std::abs(reading.best_aim)),
+                    reading.best_aim < 0.0f ? "left" : "right");
+      }
+
+      ImDrawList *draw_list = ImGui::GetWindowDrawList();
+
+      // The make zone, aim across and speed up, green where the putt drops
+      // and darker the further from the hole it stops otherwise
+      const float cell_size = 3.0f;
+      ImVec2 zone_origin = ImGui::GetCursorScreenPos();
+
+      for (int speed = 0; speed < sweep.num_speeds; speed++) {
+        for (int aim = 0; aim < sweep.num_aims; aim++) {
+
+          size_t index = static_cast<size_t>(speed) * sweep.num_aims + aim;
+
+          ImU32 color = IM_COL32(80, 200, 60, 255);
+          if (!reading.holed[index]) {
+            int shade = static_cast<int>(
+                200.0f / (1.0f + 2.0f * reading.leave[index]));
+            color = IM_COL32(shade, shade, shade, 255);
+          }
+
+          float x = zone_origin.x + static_cast<float>(aim) * cell_size;
+          float y = zone_origin.y
+                    + static_cast<float>(sweep.num_speeds - 1 - speed)
+                          * cell_size;
+          draw_list->AddRectFilled(ImVec2(x, y),
+                                   ImVec2(x + cell_size, y + cell_size),
+                                   color);
+
+        }
+      }
+
+      // The best putt's line on the green, seen from above with the hole
+      // straight ahead
+      const float green_size = static_cast<float>(sweep.num_speeds)
+                               * cell_size;
+      const float pixels_per_meter = green_size / 24.0f;
+      ImVec2 green_origin(zone_origin.x
+                              + static_cast<float>(sweep.num_aims) * cell_size
+                              + 10.0f,
+                          zone_origin.y);
+
+      auto to_canvas = [&](vec3 position) {
+        return ImVec2(green_origin.x + green_size * 0.5f
+                          + position.y * pixels_per_meter,
+                      green_origin.y + green_size - 4.0f
+                          - position.x * pixels_per_meter);
+      };
+
+      draw_list->AddRectFilled(
+          green_origin,
+          ImVec2(green_origin.x + green_size, green_origin.y + green_size),
+          IM_COL32(79, 166, 54, 255));
+      draw_list->AddCircleFilled(to_canvas(hole), 3.0f,
+                                 IM_COL32(0, 0, 0, 255));
+      draw_list->AddCircleFilled(to_canvas(start), 2.0f,
+                                 IM_COL32(255, 255, 255, 255));
+
+      for (size_t i = 1; i < best_path.size(); i++) {
+        draw_list->AddLine(to_canvas(best_path[i - 1]),
+                           to_canvas(best_path[i]),
+                           IM_COL32(255, 255, 255, 255));
+      }
+
+      ImGui::Dummy(ImVec2(green_origin.x - zone_origin.x + green_size,
+                          green_size));
+
+    }
+
     //ImGui::Separator();
     //ImGui::Spacing();
     //ImGui::Separator();
@@ -578,50 +1113,74 @@ void Application::draw_imgui_gui() {
 
     if (ImGui::BeginTable("ball_info", 1)) {
 
-      for (int obj_i = 0; obj_i < balls.size(); obj_i++) {
+      // Only the rows that are actually visible get submitted, so the cost of
+      // this table scales with the window size instead of the number of
+      // balls. Every ball takes up exactly one row of the same height, which
+      // is what lets the clipper skip the ones that are scrolled out of view.
+      ImGuiListClipper clipper;
+      clipper.Begin(static_cast<int>(snapshot.balls.size()));
 
-        // Use object uid as identifier. Most commonly you could also use the
-        // object pointer as a base ID.
-        ImGui::PushID(obj_i);
+      // The rows shown, for their accelerations
+      diagnostics_request.first_id = INT_MAX;
+      diagnostics_request.last_id = 0;
 
-        // Text and Tree nodes are less high than framed widgets, using
-        // AlignTextToFramePadding() we add vertical spacing to make the tree
-        // lines equal high.
-        ImGui::TableNextRow();
-        ImGui::TableSetColumnIndex(0);
-        ImGui::AlignTextToFramePadding();
-        ImGui::SetNextItemOpen(true, ImGuiCond_Once);
-        bool node_open = ImGui::TreeNode("Ball", "%s %u", "Ball", obj_i + 1);
+      while (clipper.Step()) {
 
-        if (node_open) {
+        diagnostics_request.first_id =
+            std::min(diagnostics_request.first_id, clipper.DisplayStart);
+        diagnostics_request.last_id =
+            std::max(diagnostics_request.last_id, clipper.DisplayEnd);
 
-          ImGui::TableNextRow();
-          ImGui::TableSetColumnIndex(0);
-          ImGui::Text("Position (yds): %s",
-                      balls[obj_i]->position.to_str_in_yds().c_str());
+        for (int obj_i = clipper.DisplayStart; obj_i < clipper.DisplayEnd;
+             obj_i++) {
 
-          ImGui::TableNextRow();
-          ImGui::TableSetColumnIndex(0);
-          ImGui::Text("Velocity (ft/s): %s",
-                      balls[obj_i]->velocity.to_str_in_ft().c_str());
+          const BallSnapshot &ball = snapshot.balls[obj_i];
 
           ImGui::TableNextRow();
           ImGui::TableSetColumnIndex(0);
-          ImGui::Text("Acceleration (ft/s^2): %s",
-                      balls[obj_i]->acceleration.to_str_in_ft().c_str());
 
-          ImGui::TableNextRow();
-          ImGui::TableSetColumnIndex(0);
-          ImGui::Text("Spin Rate (rpm): %s",
-                      string_ops::float_to_string_formatted(
-                          balls[obj_i]->current_spin_rate, 2)
-                          .c_str());
+          ImGui::Text("Ball %d", obj_i + 1);
+          ImGui::Indent();
 
-          ImGui::TreePop();
+          // Format straight from the floats instead of building strings
+          ImGui::Text("Position (yds): (%.2f, %.2f, %.2f)",
+                      m_to_yd(ball.position.x), m_to_yd(ball.position.y),
+                      m_to_yd(ball.position.z));
 
-        }
+          ImGui::Text("Velocity (ft/s): (%.2f, %.2f, %.2f)",
+                      m_to_ft(ball.velocity.x), m_to_ft(ball.velocity.y),
+                      m_to_ft(ball.velocity.z));
+
+          if (ball.diagnostics >= 0) {
+
+            vec3 acceleration =
+                snapshot.diagnostics[ball.diagnostics].acceleration;
+
+            ImGui::Text("Acceleration (ft/s^2): (%.2f, %.2f, %.2f)",
+                        m_to_ft(acceleration.x), m_to_ft(acceleration.y),
+                        m_to_ft(acceleration.z));
+
+          } else {
+            ImGui::Text("Acceleration (ft/s^2): -");
+          }
+
+          ImGui::Text("Spin Rate (rpm): %.2f", ball.current_spin_rate);
+
+          // Every row has this line, known or not, so they all stay the
+          // same height for the clipper
+          if (std::isnan(ball.carry)) {
+            ImGui::Text("Carry / Total (yds): - / -");
+          } else if (std::isnan(ball.total)) {
+            ImGui::Text("Carry / Total (yds): %.2f / -",
+                        m_to_yd(ball.carry));
+          } else {
+            ImGui::Text("Carry / Total (yds): %.2f / %.2f",
+                        m_to_yd(ball.carry), m_to_yd(ball.total));
+          }
 
-        ImGui::PopID();
+          ImGui::Unindent();
+
+        }
 
       }
 
@@ -663,6 +1222,10 @@ void Application::draw_imgui_gui() {
 
   }
 
+  if (display_profiler) {
+    PROFILE_DRAW_OVERLAY();
+  }
+
   //ImGui::ShowDemoWindow();
 
   ImGui::Render();
@@ -678,6 +1241,8 @@ Application::Application() {
              << "\n";
   is_running = false;
   asset_store = std::make_unique<AssetStore>();
+  diagnostics_request = {};
+  sent_diagnostics_request = {};
 }
 
 Application::~Application() {
@@ -743,6 +1308,10 @@ void Application::initialize() {
 
   }
 
+  current_fps = 1.0f / seconds_per_frame;
+  frame_scheduler = std::make_unique<FrameScheduler>(current_fps,
+                                                     PacingMode::VSYNC);
+
   // Initialize the imgui context
   ImGui::CreateContext();
   ImGui_ImplSDL2_InitForSDLRenderer(window, renderer);
@@ -755,6 +1324,7 @@ void Application::initialize() {
 void Application::process_input() {
 
   ZoneScoped; // for tracy
+  PROFILE_SCOPE(INPUT);
 
   SDL_Event event;
 
@@ -814,6 +1384,15 @@ void Application::setup() {
 
   wind = std::make_unique<Wind>(wind_speed_mph, wind_heading, log_wind);
 
+  // Flat and all green, like the simulation's own defaults
+  terrain = std::make_shared<const Terrain>();
+  surface_map = std::make_shared<const SurfaceMap>();
+
+  // Start stepping the balls on the physics thread
+  simulation =
+      std::make_unique<Simulation>(1.0f / PHYSICS_STEPS_PER_SECOND, *wind);
+  simulation->start();
+
   int font_size_12 = 12;
   int font_size_5 = 5;
 
@@ -844,7 +1423,7 @@ void Application::setup() {
 
   std::unique_ptr<Text> num_balls_counter = std::make_unique<Text>(
       vec2(5.0, text_y - (font_size_12 + 5)),
-      "Number of balls: " + std::to_string(balls.size()), "pico8", green);
+      "Number of balls: 0", "pico8", green);
 
   std::unique_ptr<Text> program_title_label =
       std::make_unique<Text>(vec2((window_width / 2.0f) - 150, text_y),
@@ -892,300 +1471,26 @@ void Application::setup() {
 
 }
 
-void Application::update() {
+void Application::render() {
 
   ZoneScoped; // for tracy
 
-  // Update the position of all balls in the scene
-  for (auto &ball : balls) {
-
-    // TODO: Resolve the collision between the ball and the ground in a better
-    // way
-
-    /* 
-      Flight subroutine
-      Calculates the trajectory of the ball through the air
-    */
-
-    if ((ball->position.z >= 0.0f) && (ball->is_rolling == false)) {
-
-      // Calculates the wind force based off whether we are using the log wind
-      // model or not.
-      ball->wind_force = get_wind_force(wind, ball->position.z);
-
-      // The ball's effective velocity, or "air speed" vector is determined by
-      // taking the difference between the instantaneous velocity vector and the
-      // wind vector.
-      vec3 air_speed = ball->velocity - ball->wind_force;
-
-      ball->current_spin_rate =
-          get_spin_rate(ball->launch_spin_rate, ball->elapsed_time);
-
-      // The coefficients of lift and drag are determined by the ball's speed
-      // and spin rate. We take the square of the velocity vector here since we
-      // don't need to to get the raw speed, which would involve an expensive
-      // sqrt function.
-      float air_speed_squared = air_speed.dot(air_speed);
-      std::pair<float, float> coefficients = get_drag_and_lift_coefficients(
-          air_speed_squared, ball->current_spin_rate);
-
-      float drag_coefficient = coefficients.first;
-      float lift_coefficient = coefficients.second;
-
-      ball->lift_force =
-          get_lift_force(air_speed, ball->rotation_axis, lift_coefficient);
-      ball->drag_force = get_drag_force(air_speed, drag_coefficient);
-
-      ball->sum_forces = ball->lift_force + ball->drag_force + BALL_WEIGHT;
+  // Grab the newest state from the physics thread. Both passes read from the
+  // same snapshot so the UI and the scene always agree.
+  const SimulationSnapshot &snapshot = simulation->acquire_snapshot();
 
-      ball->integrate(seconds_per_frame);
-
-      if ((ball->velocity.z < 0.0f) && (ball->max_height_set == false)) {
-        ball->max_height = ball->position.z;
-        ball->max_height_set = true;
-      }
-
-      ball->elapsed_time += seconds_per_frame;
-
-    }
-
-    /*
-      Ground subroutine
-      Covers the interactions between the ball and the ground when bouncing and rolling.
-    */ 
-
-    if (ball->position.z <= 0.0f) {
-
-      ball->position.z = 0.0f;
-
-      // End the bounce subroutine and start the roll subroutine if the max
-      // height from the previous flight part was less than the specified
-      // minimum bounce height of 5 mm.
-      if (ball->max_height < MIN_BOUNCE_HEIGHT) {
-
-        ball->is_rolling = true;
-        ball->acceleration.zero();
-        ball->wind_force.zero();
-        ball->lift_force.zero();
-        ball->drag_force.zero();
-        ball->position.z = 0.0f;
-        ball->velocity.z = 0.0f;
-
-        // TODO: Compute the force of gravity tangential and normal to the local
-        // terrain surface.
-        // Calculate the friction on the ball from the surface of the green.
-        float velocity_squared = ball->velocity.dot(ball->velocity);
-
-        if (velocity_squared > MIN_ROLL_VELOCITY_SQUARED) {
-
-          vec3 friction = get_friction_force(ball->velocity);
-          ball->sum_forces = friction;
-
-          ball->integrate(seconds_per_frame);
-          velocity_squared = ball->velocity.dot(ball->velocity);
-
-        } else {
-
-          ball->velocity.zero();
-          ball->acceleration.zero();
-          ball->current_spin_rate = 0.0;
-
-        }
-
-      } else {
-
-        /*
-          We can simplify the collision of the ball bouncing against the ground
-          to a 2D equation by defining a new frame of reference upon ground
-          impact, where the x unit vector points along the direction of the
-          velocity vector, the y unit vector points along the normal vector of
-          the surface that the ball is colliding against, and the z vector
-          perpendicular to unit vectors x and y.
-        */
-
-        // Calculate the transformation matrix for the new ground frame of
-        // reference here.
-        auto y_unit = vec3(0.0, 0.0, 1.0);
-        y_unit /= norm(y_unit);
-        auto z_unit = vec3(ball->velocity.cross(y_unit));
-        z_unit /= norm(z_unit);
-        auto x_unit = vec3(y_unit.cross(z_unit));
-
-        // Calculate the new 2D velocity vector with respect to the local ground
-        // frame
-        float velocity_ground_x = ball->velocity.dot(x_unit);
-        float velocity_ground_y = ball->velocity.dot(y_unit);
-
-        // Gross but it works. TODO: Learn the minutae of floating point
-        // comparisons.
-        assert(static_cast<int>(ball->velocity.dot(z_unit)) == 0);
-
-        //float normal_force = std::abs(velocity_ground_y);
-
-        // Calculate the angular velocity of the ball with respect to the
-        // ground.
-        ball->current_spin_rate =
-            get_spin_rate(ball->launch_spin_rate, ball->elapsed_time);
-        float angular_velocity_ground_x = rpm_to_rad_s(ball->current_spin_rate)
-                                          * ball->rotation_axis.dot(x_unit);
-        float angular_velocity_ground_y = rpm_to_rad_s(ball->current_spin_rate)
-                                          * ball->rotation_axis.dot(y_unit);
-        float angular_velocity_ground_z = rpm_to_rad_s(ball->current_spin_rate)
-                                          * ball->rotation_axis.dot(z_unit);
-
-        /*
-          When the ball hits the ground, it tends to penetrate into the ground
-          and slip across it. These forces act as both a linear and angular
-          impulse on the ball, changing its linear and angular velocity
-          differently than how one would expect from a normal inelastic
-          collision. We can represent these interactions by thinking of the
-          collision as if the ball were colliding with a plane angled at an
-          angle theta_c above the angle of the surface the ball is colliding
-          against.
-        */
-
-        float ball_speed = norm(ball->velocity);
-        float ball_x_speed_ground = std::abs(velocity_ground_x);
-        float ball_y_speed_ground = std::abs(velocity_ground_y);
-
-        float theta_c;
-
-        // Get rid of these when you're done investigating this.
-        float angle =
-            rad_to_deg(fast_atan(ball_y_speed_ground / ball_x_speed_ground));
-        float angle2 =
-            rad_to_deg(fast_atan(ball_x_speed_ground / ball_y_speed_ground));
-
-        // I don't understand why I have to do this but it works. This seems to
-        // produce good results for both the ball coming in at a steep angle and
-        // a shallow one
-        if (ball_x_speed_ground > ball_y_speed_ground) {
-          theta_c =
-              GROUND_FIRMNESS * ball_speed
-              * fast_atan(ball_y_speed_ground / ball_x_speed_ground);
-        } else {
-          theta_c =
-              GROUND_FIRMNESS * ball_speed
-              * fast_atan(ball_x_speed_ground / ball_y_speed_ground);
-        }
-
-        // Use theta c to transform to the ball velocity vector components from
-        // the x-y frame to the x'-y' frame, where the x' axis is equal to a
-        // surface inclined at angle theta_c from the original surface.
-
-        float velocity_ground_x_transformed =
-            velocity_ground_x * cosf(theta_c)
-            + velocity_ground_y * sinf(theta_c);
-        float velocity_ground_y_transformed =
-            -(velocity_ground_x * sinf(theta_c))
-            + velocity_ground_y * cosf(theta_c);
-
-        float normal_force_transformed =
-            std::abs(velocity_ground_y_transformed);
-
-        float restitution =
-            get_coefficient_of_restitution(normal_force_transformed);
-
-        // Calculate the critical values of the coefficient of friction for the
-        // x'-y' and z-y' planes. If the coefficient of friction for the surface
-        // exceeds these values, the ball will roll instead of slide through
-        // impact for that particular plane.
-        float mu_cz = (-2.0f / 7.0f)
-                      * (velocity_ground_x_transformed
-                         + (RADIUS * angular_velocity_ground_z))
-                      / (velocity_ground_y_transformed * (1.0f + restitution));
-        float mu_cx = (2.0f / 7.0f) * (RADIUS * angular_velocity_ground_x)
-                      / (velocity_ground_y_transformed * (1.0f + restitution));
-
-        // Calculate the linear and angular velocity in the x'-y' plane.
-        if (FRICTION < mu_cz) {
-
-          // Linear and angular velocity in the x'-y' plane after sliding
-          velocity_ground_x_transformed -=
-              FRICTION * (normal_force_transformed * (1 + restitution));
-
-          velocity_ground_y_transformed =
-              restitution * normal_force_transformed;
-
-          angular_velocity_ground_z -=
-              ((5.0f * FRICTION) / (2.0f * RADIUS))
-              * (normal_force_transformed * (1.0f + restitution));
-
-        } else {
-
-          // Linear and angular velocity in the x'-y' plane after rolling
-          velocity_ground_x_transformed =
-              (1.0f / 7.0f)
-              * (5.0f * velocity_ground_x_transformed
-                 - (2.0f * RADIUS * angular_velocity_ground_z));
-          velocity_ground_y_transformed =
-              restitution * normal_force_transformed;
-
-          angular_velocity_ground_z = -(velocity_ground_x_transformed / RADIUS);
-
-        }
-
-        // Calculate the linear and angular velocity in the z-y' plane.
-        float velocity_ground_z;
-
-        if (FRICTION < mu_cx) {
-
-          // Linear and angular velocity in the z-y' plane after sliding
-          velocity_ground_z = FRICTION * (normal_force_transformed * (1 + restitution));
-
-          angular_velocity_ground_x -=
-              ((5.0f * FRICTION) / (2.0f * RADIUS))
-              * (normal_force_transformed * (1.0f + restitution));
-
-        } else {
-
-          // Linear and angular velocity in the z-y' plane after rolling
-          velocity_ground_z = (2.0f / 7.0f) * RADIUS * angular_velocity_ground_x;
-
-          angular_velocity_ground_x = -(velocity_ground_z / RADIUS);
-
-        }
-
-        // Transform the x and y components from the x'-y' frame back to the
-        // original ground frame.
-        velocity_ground_x = velocity_ground_x_transformed * cosf(theta_c)
-                            - velocity_ground_y_transformed * sinf(theta_c);
-        velocity_ground_y = velocity_ground_x_transformed * sinf(theta_c)
-                            + velocity_ground_y_transformed * cosf(theta_c);
-
-        // Convert the components for the ground frame back to the world frame.
-        // The flight subroutine will be called once again with these values as
-        // the new parameters.
-        ball->velocity = (velocity_ground_x * x_unit)
-                         + (velocity_ground_y * y_unit)
-                         + (velocity_ground_z * z_unit);
-
-        vec3 angular_velocity = (angular_velocity_ground_x * x_unit)
-                                + (angular_velocity_ground_y * y_unit)
-                                + (angular_velocity_ground_z * z_unit);
-
-        ball->launch_spin_rate = rad_s_to_rpm(norm(angular_velocity));
-
-        ball->rotation_axis = angular_velocity / norm(angular_velocity);
-
-        ball->max_height_set = false;
-
-      }
-
-    }
+  draw_primitives(snapshot);
+  draw_imgui_gui(snapshot);
 
+  // Ask for the diagnostics of what this frame showed. If the queue is full
+  // the request is retried next frame.
+  if (!is_same_request(diagnostics_request, sent_diagnostics_request)
+      && simulation->set_diagnostics(diagnostics_request)) {
+    sent_diagnostics_request = diagnostics_request;
   }
 
-}
-
-void Application::render() {
-
-  ZoneScoped; // for tracy
-
-  draw_primitives();
-  draw_imgui_gui();
-
   ZoneNamedN(SDL_RenderPresent_scope, "SDL_RenderPresent", true);
+  PROFILE_SCOPE(PRESENT);
   SDL_RenderPresent(renderer);
 
 }
@@ -1194,44 +1499,42 @@ void Application::run() {
 
   setup();
 
-  current_fps = 1.0f / seconds_per_frame;
-
   while (is_running) {
 
-    auto frame_start = std::chrono::high_resolution_clock::now();
+    frame_scheduler->begin_frame();
+    current_fps = frame_scheduler->get_fps();
 
-    // Main game loop is here
+    // Main game loop is here. The simulation steps on its own thread.
     process_input();
-    update();
     render();
 
     FrameMark; // for tracy
 
-    auto frame_end = std::chrono::high_resolution_clock::now();
-
-    std::chrono::duration<float> game_update_time = frame_end - frame_start;
-
-    if (game_update_time.count() < seconds_per_frame) {
-
+    {
       ZoneNamedN(sleep_scope, "Sleep", true); // for tracy
+      PROFILE_SCOPE(SLEEP);
+      frame_scheduler->wait_for_next_frame();
+    }
 
-      uint32_t ms_to_wait = static_cast<uint32_t>(
-          (seconds_per_frame - game_update_time.count()) * 1000.0f);
+    PROFILE_END_FRAME();
 
-      SDL_Delay(ms_to_wait);
+  }
 
-    }
+}
 
-    std::chrono::duration<float> elapsed_time_for_frame =
-        std::chrono::high_resolution_clock::now() - frame_start;
-    current_fps = 1.0f / elapsed_time_for_frame.count();
+void Application::set_pacing_mode(PacingMode mode) {
 
-  }
+  // Only let the renderer block on the display refresh in VSync mode, otherwise
+  // it'll double pace with the scheduler.
+  SDL_RenderSetVSync(renderer, mode == PacingMode::VSYNC ? 1 : 0);
+  frame_scheduler->set_mode(mode);
 
 }
 
 void Application::destroy() {
 
+  simulation->stop();
+
   ImGui_ImplSDLRenderer_Shutdown();
   ImGui_ImplSDL2_Shutdown();
   ImGui::DestroyContext();
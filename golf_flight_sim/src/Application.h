@@ -1,12 +1,13 @@
 #pragma once
 
 #include "./AssetStore/AssetStore.h"
-#include "./Components/Ball.h"
 #include "./Components/DistanceMarker.h"
 #include "./Components/GameWindow.h"
 #include "./Components/Text.h"
 #include "./Components/Texture.h"
 #include "./Components/Wind.h"
+#include "./FrameScheduler/FrameScheduler.h"
+#include "./Simulation/Simulation.h"
 #include <SDL.h>
 #include <memory>
 #include <vector>
@@ -26,18 +27,37 @@ private:
   std::unique_ptr<GameWindow> windowR;
 
   std::unique_ptr<AssetStore> asset_store;
+  std::unique_ptr<FrameScheduler> frame_scheduler;
 
   std::unique_ptr<DistanceMarker> distance_markers;
   std::vector<std::shared_ptr<Texture>> textures;
   std::vector<std::unique_ptr<Text>> text_strings;
   std::vector<std::unique_ptr<Text>> ui_text;
-  std::vector<std::unique_ptr<Ball>> balls;
   SDL_Texture *trajectories_texture;
 
+  // The wind settings as shown in the UI. Changes are forwarded to the
+  // simulation, which keeps its own copy.
   std::unique_ptr<Wind> wind;
+  std::unique_ptr<Simulation> simulation;
+
+  // The terrain the simulation was last given, kept for drawing it and for
+  // putting the tee on it. Just the overview when it's streamed.
+  std::shared_ptr<const Terrain> terrain;
+
+  // Likewise for drawing, or nullptr if there aren't any
+  std::shared_ptr<const Obstacles> obstacles;
+
+  // The surface materials the simulation was last given, for drawing
+  std::shared_ptr<const SurfaceMap> surface_map;
+
+  // The balls whose forces the current frame shows, built up while drawing,
+  // and the last request sent to the simulation
+  DiagnosticsRequest diagnostics_request;
+  DiagnosticsRequest sent_diagnostics_request;
 
   static bool display_forces;
   static bool display_trajectories;
+  static bool display_profiler;
 
 public:
   Application();
@@ -47,11 +67,11 @@ public:
   void run();
   void setup();
   void process_input();
-  void update();
   void render();
   void destroy();
-  void draw_primitives();
-  void draw_imgui_gui();
+  void draw_primitives(const SimulationSnapshot &snapshot);
+  void draw_imgui_gui(const SimulationSnapshot &snapshot);
+  void set_pacing_mode(PacingMode mode);
 
   static Uint16 window_width;
   static Uint16 window_height;
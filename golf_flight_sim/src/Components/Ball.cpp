@@ -3,42 +3,28 @@
 #include <iostream>
 
 Ball::Ball(vec3 ball_position, vec3 ball_velocity, vec3 rotation_axis,
-           float spin) {
+           float spin, float timestep) {
 
   this->position = ball_position;
   this->velocity = ball_velocity;
-  this->acceleration = vec3(0.0, 0.0, 0.0);
   this->rotation_axis = rotation_axis;
 
-  this->wind_force = vec3(0.0, 0.0, 0.0);
-  this->lift_force = vec3(0.0, 0.0, 0.0);
-  this->drag_force = vec3(0.0, 0.0, 0.0);
-
   this->current_spin_rate = spin;
   this->launch_spin_rate = spin;
   this->elapsed_time = 0.0f;
-
-  this->max_height = position.z;
-  this->max_height_set = false;
-
-  this->is_rolling = false;
-
-  this->sum_forces = vec3(0.0, 0.0, 0.0);
+  this->timestep = timestep;
 
 }
 
-void Ball::clear_forces() {
-  sum_forces = vec3(0.0, 0.0, 0.0);
-}
-
-void Ball::integrate(float dt) {
-
-  acceleration = sum_forces * INV_BALL_MASS;
+BallRecord::BallRecord(int id, vec3 ball_position) {
 
-  // Integrate acceleration to find velocity and position
-  velocity += acceleration * dt;
-  position += velocity * dt;
+  this->id = id;
+  this->phase = BallPhase::FLIGHT;
+  this->rate_level = 0;
+  this->max_height = ball_position.z;
+  this->roll = solve_roll(ball_position, vec3(0.0, 0.0, 0.0));
+  this->roll_start_time = 0.0;
 
-  clear_forces();
+  start_metrics(this->metrics, ball_position);
 
 }
@@ -1,34 +1,77 @@
 #pragma once
 
+#include "../Physics/metrics.h"
+#include "../Physics/roll.h"
 #include "../math/vec3.h"
+#include <cstdint>
 
-struct Ball {
+// What a ball is doing this step. The simulation keeps its balls sorted by
+// phase so each phase is processed as one contiguous range.
+enum class BallPhase : uint8_t {
+  FLIGHT,
+  IMPACT, // touched down this step and is about to bounce
+  ROLL,
+  REST,
+  NUM_PHASES
+};
+
+/*
+  A ball's state is split in two. Ball is the integrator state the flight and
+  impact kernels read and write every step, packed into exactly one cache
+  line. BallRecord is everything else, which is only touched on events: the
+  top of a flight, a landing, a change of step rate or coming to rest. The
+  simulation keeps the two in parallel arrays.
+
+  Forces and acceleration aren't stored at all. They're only ever displayed,
+  so the simulation works them out for the balls on screen when it publishes
+  a snapshot (see BallDiagnostics).
+*/
+
+struct alignas(64) Ball {
 
   vec3 position;
   vec3 velocity;
-  vec3 acceleration;
   vec3 rotation_axis;
 
-  vec3 wind_force;
-  vec3 lift_force;
-  vec3 drag_force;
-
   float current_spin_rate;
   float launch_spin_rate;
   float elapsed_time;
 
-  float max_height;
-  bool max_height_set;
+  // The ball's own step size in flight, the simulation's timestep times a
+  // power of two (see BallRecord::rate_level)
+  float timestep;
 
-  bool is_rolling;
+  Ball(vec3 ball_position, vec3 ball_velocity, vec3 rotation_axis, float spin,
+       float timestep);
+  ~Ball() = default;
 
-  vec3 sum_forces;
+};
 
-  Ball(vec3 ball_position, vec3 ball_velocity, vec3 rotation_axis, float spin);
-  ~Ball() = default;
+static_assert(sizeof(Ball) == 64, "Ball must fill exactly one cache line");
+
+struct BallRecord {
+
+  // Launch order, which stays the same while the ball moves between phases
+  int id;
+
+  BallPhase phase;
+
+  // Ball::timestep is 2^rate_level simulation timesteps
+  uint8_t rate_level;
+
+  // Height above the ground at the top of the current flight, which decides
+  // whether the ball bounces or rolls when it lands
+  float max_height;
+
+  // Valid once the ball has started rolling. The roll is evaluated in closed
+  // form from the simulation time it started at instead of being integrated.
+  RollSolution roll;
+  double roll_start_time;
 
-  void clear_forces();
+  // Updated on the same events as the rest of the record
+  ShotMetrics metrics;
 
-  void integrate(float dt);
+  BallRecord(int id, vec3 ball_position);
+  ~BallRecord() = default;
 
-};
\ No newline at end of file
+};
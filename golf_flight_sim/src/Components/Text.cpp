@@ -1,6 +1,6 @@
 #include "Text.h"
 
-Text::Text(vec2 position, const std::string &text, const std::string &asset_id,
+Text::Text(vec2 position, std::string_view text, const std::string &asset_id,
            const SDL_Color &color) {
 
   this->position = position;
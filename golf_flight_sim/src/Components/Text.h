@@ -1,17 +1,19 @@
 #pragma once
 
 #include "../math/vec2.h"
+#include "../misc/fixed_string.h"
 #include <SDL.h>
 #include <string>
+#include <string_view>
 
 struct Text {
 
   vec2 position;
-  std::string text;
+  FixedString<64> text;
   std::string asset_id;
   SDL_Color color;
 
-  Text(vec2 position, const std::string &text, const std::string &asset_id,
+  Text(vec2 position, std::string_view text, const std::string &asset_id,
        const SDL_Color &color);
   ~Text() = default;
 
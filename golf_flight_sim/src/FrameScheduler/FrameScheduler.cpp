@@ -0,0 +1,188 @@
+#include "FrameScheduler.h"
+#include "../tracy/tracy/Tracy.hpp"
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+void FrameTimeHistogram::add(float frame_time_ms) {
+
+  int bin = static_cast<int>(frame_time_ms / BIN_WIDTH_MS);
+  bin = std::clamp(bin, 0, NUM_BINS - 1);
+
+  bins[bin] += 1.0f;
+  num_samples++;
+
+}
+
+void FrameTimeHistogram::clear() {
+
+  std::fill(std::begin(bins), std::end(bins), 0.0f);
+  num_samples = 0;
+
+}
+
+FrameScheduler::FrameScheduler(float target_fps, PacingMode mode) {
+
+  this->mode = mode;
+  set_target_fps(target_fps);
+
+  // Start with a pessimistic guess for the sleep overshoot; it converges
+  // after a handful of frames.
+  sleep_estimate_ms = 5.0;
+  sleep_mean_ms = 5.0;
+  sleep_variance = 0.0;
+
+  clear_statistics();
+
+  last_frame_start = clock::now();
+  next_deadline = last_frame_start + target_frame_time;
+
+}
+
+void FrameScheduler::set_target_fps(float target_fps) {
+
+  target_frame_time = std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>(1.0 / static_cast<double>(target_fps)));
+
+}
+
+void FrameScheduler::set_mode(PacingMode mode) {
+
+  this->mode = mode;
+  next_deadline = clock::now() + target_frame_time;
+  clear_statistics();
+
+}
+
+PacingMode FrameScheduler::get_mode() const {
+  return mode;
+}
+
+float FrameScheduler::begin_frame() {
+
+  clock::time_point now = clock::now();
+  std::chrono::duration<float, std::milli> frame_time = now - last_frame_start;
+  last_frame_start = now;
+
+  float frame_time_ms = frame_time.count();
+
+  histogram.add(frame_time_ms);
+
+  // Replace the oldest entry in the rolling history and keep the running sum
+  // up to date so the average is O(1).
+  if (history_count == HISTORY_SIZE) {
+    history_sum_ms -= frame_time_history_ms[history_next];
+  } else {
+    history_count++;
+  }
+
+  frame_time_history_ms[history_next] = frame_time_ms;
+  history_sum_ms += frame_time_ms;
+  history_next = (history_next + 1) % HISTORY_SIZE;
+
+  return frame_time_ms / 1000.0f;
+
+}
+
+void FrameScheduler::precise_sleep(clock::time_point deadline) {
+
+  // Sleep in 1 ms slices while there's more time left than a slice is
+  // expected to take.
+  while (true) {
+
+    std::chrono::duration<double, std::milli> remaining =
+        deadline - clock::now();
+
+    if (remaining.count() <= sleep_estimate_ms) {
+      break;
+    }
+
+    clock::time_point sleep_start = clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::chrono::duration<double, std::milli> observed =
+        clock::now() - sleep_start;
+
+    // Update the overshoot estimate with an exponential moving mean and
+    // variance, so it keeps adapting if the OS timer resolution changes
+    // under us.
+    const double alpha = 0.05;
+    double delta = observed.count() - sleep_mean_ms;
+    sleep_mean_ms += alpha * delta;
+    sleep_variance = (1.0 - alpha) * (sleep_variance + alpha * delta * delta);
+    double stddev = std::sqrt(sleep_variance);
+    sleep_estimate_ms = sleep_mean_ms + stddev;
+
+  }
+
+  // Spin for the remainder
+  while (clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+
+}
+
+void FrameScheduler::wait_for_next_frame() {
+
+  ZoneScoped; // for tracy
+
+  if (mode != PacingMode::CAPPED) {
+    return;
+  }
+
+  clock::time_point now = clock::now();
+
+  // If we've fallen more than a frame behind, don't try to catch up with a
+  // burst of unpaced frames, just restart the schedule from now.
+  if (now > next_deadline + target_frame_time) {
+    next_deadline = now;
+  } else if (now < next_deadline) {
+    precise_sleep(next_deadline);
+  }
+
+  next_deadline += target_frame_time;
+
+}
+
+float FrameScheduler::get_fps() const {
+
+  float average = get_average_frame_time_ms();
+  return average > 0.0f ? 1000.0f / average : 0.0f;
+
+}
+
+float FrameScheduler::get_average_frame_time_ms() const {
+
+  if (history_count == 0) {
+    return 0.0f;
+  }
+
+  return static_cast<float>(history_sum_ms / history_count);
+
+}
+
+const FrameTimeHistogram &FrameScheduler::get_histogram() const {
+  return histogram;
+}
+
+const float *FrameScheduler::get_frame_time_history() const {
+  return frame_time_history_ms;
+}
+
+int FrameScheduler::get_frame_time_history_size() const {
+  return history_count;
+}
+
+int FrameScheduler::get_frame_time_history_offset() const {
+  return history_count == HISTORY_SIZE ? history_next : 0;
+}
+
+void FrameScheduler::clear_statistics() {
+
+  std::fill(std::begin(frame_time_history_ms),
+            std::end(frame_time_history_ms), 0.0f);
+  history_next = 0;
+  history_count = 0;
+  history_sum_ms = 0.0;
+  histogram.clear();
+
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <chrono>
+
+/*
+  Frame pacing against a monotonic clock.
+
+  CAPPED:   sleeps in 1 ms slices while there is comfortably more time left
+            than a sleep has been observed to take, then spins for the rest.
+            This hits the deadline to within a few microseconds without
+            burning a whole core.
+  VSYNC:    SDL_RenderPresent blocks on the display, so the scheduler only
+            measures.
+  UNCAPPED: no waiting at all.
+
+  Every frame's start-to-start time is recorded into a histogram and a rolling
+  history for the UI. The FPS counter is averaged over the rolling history
+  instead of being taken from a single frame.
+*/
+
+enum class PacingMode {
+  CAPPED,
+  VSYNC,
+  UNCAPPED
+};
+
+struct FrameTimeHistogram {
+
+  static const int NUM_BINS = 100;
+  static constexpr float BIN_WIDTH_MS = 0.5f;
+
+  // The last bin also collects everything above NUM_BINS * BIN_WIDTH_MS.
+  float bins[NUM_BINS] = {};
+  unsigned int num_samples = 0;
+
+  void add(float frame_time_ms);
+  void clear();
+
+};
+
+class FrameScheduler {
+private:
+  using clock = std::chrono::steady_clock;
+
+  static const int HISTORY_SIZE = 240;
+
+  PacingMode mode;
+  clock::duration target_frame_time;
+  clock::time_point next_deadline;
+  clock::time_point last_frame_start;
+
+  // Running estimate of how long a 1 ms sleep really takes. We stop sleeping
+  // once the time left drops below mean + 1 standard deviation and spin for
+  // the rest.
+  double sleep_estimate_ms;
+  double sleep_mean_ms;
+  double sleep_variance;
+
+  float frame_time_history_ms[HISTORY_SIZE];
+  int history_next;
+  int history_count;
+  double history_sum_ms;
+
+  FrameTimeHistogram histogram;
+
+  void precise_sleep(clock::time_point deadline);
+
+public:
+  FrameScheduler(float target_fps, PacingMode mode);
+  ~FrameScheduler() = default;
+
+  void set_target_fps(float target_fps);
+  void set_mode(PacingMode mode);
+  PacingMode get_mode() const;
+
+  // Marks the start of a frame. Returns the time since the previous frame
+  // started in seconds.
+  float begin_frame();
+
+  // Waits out whatever is left of the frame budget according to the pacing
+  // mode.
+  void wait_for_next_frame();
+
+  float get_fps() const;
+  float get_average_frame_time_ms() const;
+
+  const FrameTimeHistogram &get_histogram() const;
+  const float *get_frame_time_history() const;
+  int get_frame_time_history_size() const;
+  int get_frame_time_history_offset() const;
+
+  void clear_statistics();
+
+};
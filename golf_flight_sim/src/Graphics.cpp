@@ -1,6 +1,6 @@
 #include "Graphics.h"
 #include "./math/linear.h"
-#include "./math/trig.h"
+#include "./math/math_inline.h"
 #include "./tracy/tracy/Tracy.hpp"
 #include <cmath>
 
@@ -29,16 +29,27 @@ void Graphics::draw_arrow(SDL_Renderer *renderer, vec2 v1, vec2 v2,
   vec2 v1_local = (v1 - v2) * -1.0f;
   vec2 v2_local = vec2(0.0, 0.0);
 
-  // Get the angle of the arrow relative to the origin
-  float angle = fast_atan2(v1_local.y, v1_local.x);
+  // Get the direction of the arrow relative to the origin. The cosine and
+  // sine of its angle are just the components of the unit vector, so there's
+  // no need for any trig.
+  float length_squared = v1_local.x * v1_local.x + v1_local.y * v1_local.y;
+  float cos_angle = 1.0f;
+  float sin_angle = 0.0f;
+
+  if (length_squared > 0.0f) {
+    float inv_length = fast_rsqrt(length_squared);
+    cos_angle = v1_local.x * inv_length;
+    sin_angle = v1_local.y * inv_length;
+  }
 
   // Assuming a perfectly horizontal arrow, the end points of the arrowhead will
   // be 3 pixels to the right/left and 3 pixels above/below the main arrowhead.
   float offset = 3.0f;
 
   // Perform the 2d rotation about the origin
-  vec2 arrowhead_point_a = vec2(offset * cosf(angle) - offset * sinf(angle),
-                                offset * sinf(angle) + offset * cosf(angle));
+  vec2 arrowhead_point_a =
+      vec2(offset * cos_angle - offset * sin_angle,
+           offset * sin_angle + offset * cos_angle);
 
   // The second point on the arrowhead will always be perpendicular to the first
   // one.
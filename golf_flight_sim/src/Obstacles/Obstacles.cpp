@@ -0,0 +1,736 @@
+#include "Obstacles.h"
+#include "../Terrain/SurfaceMap.h"
+#include "../tracy/tracy/Tracy.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+vec3 min3(vec3 u, vec3 v) {
+  return vec3(std::min(u.x, v.x), std::min(u.y, v.y), std::min(u.z, v.z));
+}
+
+vec3 max3(vec3 u, vec3 v) {
+  return vec3(std::max(u.x, v.x), std::max(u.y, v.y), std::max(u.z, v.z));
+}
+
+float get_component(vec3 v, int axis) {
+  return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+}
+
+// From point to the nearest point on the segment from a to b
+float get_distance_squared(vec3 point, vec3 a, vec3 b) {
+
+  vec3 segment = b - a;
+  float length_squared = segment.dot(segment);
+  float t = 0.0f;
+
+  if (length_squared > 0.0f) {
+    t = std::clamp((point - a).dot(segment) / length_squared, 0.0f, 1.0f);
+  }
+
+  vec3 offset = point - (a + segment * t);
+
+  return offset.dot(offset);
+
+}
+
+// The swept segment, as a ray from its start along a unit direction
+struct Ray {
+
+  vec3 origin;
+  vec3 direction;
+  vec3 inv_direction;
+  float length;
+
+};
+
+/*
+  Swept sphere tests. A sphere of radius r moving along a ray touches a shape
+  when its center enters the shape grown by r, so each test is a ray against
+  the grown shape. They return the distance along the ray to where it goes
+  in, or -1 if it misses or starts inside, and the outward normal there.
+*/
+
+float intersect_sphere(const Ray &ray, vec3 center, float radius,
+                       vec3 &normal) {
+
+  vec3 offset = ray.origin - center;
+  float b = offset.dot(ray.direction);
+  float c = offset.dot(offset) - radius * radius;
+
+  // Inside, or outside and moving away
+  if (c < 0.0f || b > 0.0f) {
+    return -1.0f;
+  }
+
+  float discriminant = b * b - c;
+
+  if (discriminant < 0.0f) {
+    return -1.0f;
+  }
+
+  float t = -b - std::sqrt(discriminant);
+  normal = (offset + ray.direction * t) / radius;
+
+  return t;
+
+}
+
+// The axis from a to b grown by radius. After Inigo Quilez's ray-capsule
+// test: the infinite cylinder first, then the sphere on the end it's past
+// if it hits the cylinder beyond the axis.
+float intersect_capsule(const Ray &ray, vec3 a, vec3 b, float radius,
+                        vec3 &normal) {
+
+  vec3 axis = b - a;
+  float axis_squared = axis.dot(axis);
+
+  if (axis_squared == 0.0f) {
+    return intersect_sphere(ray, a, radius, normal);
+  }
+
+  vec3 offset = ray.origin - a;
+  float axis_direction = axis.dot(ray.direction);
+  float axis_offset = axis.dot(offset);
+
+  float qa = axis_squared - axis_direction * axis_direction;
+  float qb = axis_squared * offset.dot(ray.direction)
+             - axis_offset * axis_direction;
+  float qc = axis_squared * offset.dot(offset) - axis_offset * axis_offset
+             - radius * radius * axis_squared;
+
+  float discriminant = qb * qb - qa * qc;
+
+  if (discriminant < 0.0f) {
+    return -1.0f;
+  }
+
+  // Where along the axis it meets the cylinder. Running parallel to the
+  // axis it can only meet the end it's heading for.
+  float along = axis_direction > 0.0f ? 0.0f : axis_squared;
+
+  if (qa > 1e-6f * axis_squared) {
+
+    float t = (-qb - std::sqrt(discriminant)) / qa;
+    along = axis_offset + t * axis_direction;
+
+    if (along > 0.0f && along < axis_squared) {
+
+      if (t < 0.0f) {
+        return -1.0f;
+      }
+
+      normal = (offset + ray.direction * t - axis * (along / axis_squared))
+               / radius;
+      return t;
+
+    }
+
+  }
+
+  return intersect_sphere(ray, along <= 0.0f ? a : b, radius, normal);
+
+}
+
+float intersect_triangle(const Ray &ray, vec3 a, vec3 b, vec3 c, float radius,
+                         vec3 &normal) {
+
+  vec3 face_normal = (b - a).cross(c - a).unit_vector();
+
+  auto is_inside = [&](vec3 point) {
+    return (b - a).cross(point - a).dot(face_normal) >= 0.0f
+           && (c - b).cross(point - b).dot(face_normal) >= 0.0f
+           && (a - c).cross(point - c).dot(face_normal) >= 0.0f;
+  };
+
+  // Either side can be hit, so face the normal towards the ray
+  float signed_distance = face_normal.dot(ray.origin - a);
+  float distance = std::fabs(signed_distance);
+  vec3 facing = signed_distance < 0.0f ? -face_normal : face_normal;
+  float approach = -facing.dot(ray.direction);
+
+  // A degenerate triangle only has its edges
+  bool has_face = face_normal.dot(face_normal) > 0.0f;
+
+  if (has_face && distance < radius) {
+
+    // Already touching the face
+    if (is_inside(ray.origin - facing * distance)) {
+      return -1.0f;
+    }
+
+  } else if (has_face && approach > 0.0f) {
+
+    float t = (distance - radius) / approach;
+    vec3 contact = ray.origin + ray.direction * t - facing * radius;
+
+    // Touching the face before anything else
+    if (is_inside(contact)) {
+      normal = facing;
+      return t;
+    }
+
+  }
+
+  // Otherwise it can only touch an edge or a corner first, unless it's
+  // already touching one
+  const vec3 corners[4] = {a, b, c, a};
+
+  for (int i = 0; i < 3; i++) {
+    if (get_distance_squared(ray.origin, corners[i], corners[i + 1])
+        < radius * radius) {
+      return -1.0f;
+    }
+  }
+
+  float nearest = -1.0f;
+
+  for (int i = 0; i < 3; i++) {
+
+    vec3 edge_normal;
+    float t =
+        intersect_capsule(ray, corners[i], corners[i + 1], radius, edge_normal);
+
+    if (t >= 0.0f && (nearest < 0.0f || t < nearest)) {
+      nearest = t;
+      normal = edge_normal;
+    }
+
+  }
+
+  return nearest;
+
+}
+
+float intersect_box(const Ray &ray, const ObstacleShape &box, float radius,
+                    vec3 &normal) {
+
+  const vec3 axes[3] = {box.c, vec3(-box.c.y, box.c.x, 0.0f),
+                        vec3(0.0f, 0.0f, 1.0f)};
+  const float half[3] = {box.b.x, box.b.y, box.b.z};
+
+  vec3 offset = ray.origin - box.a;
+  float origin[3];
+  float direction[3];
+
+  for (int k = 0; k < 3; k++) {
+    origin[k] = offset.dot(axes[k]);
+    direction[k] = ray.direction.dot(axes[k]);
+  }
+
+  // The slabs of the box grown by the radius on every side
+  float enter = -INFINITY;
+  float exit = ray.length;
+  int enter_axis = 0;
+
+  for (int k = 0; k < 3; k++) {
+
+    float extent = half[k] + radius;
+
+    if (direction[k] == 0.0f) {
+
+      if (std::fabs(origin[k]) > extent) {
+        return -1.0f;
+      }
+
+      continue;
+
+    }
+
+    float t0 = (-extent - origin[k]) / direction[k];
+    float t1 = (extent - origin[k]) / direction[k];
+
+    if (std::min(t0, t1) > enter) {
+      enter = std::min(t0, t1);
+      enter_axis = k;
+    }
+
+    exit = std::min(exit, std::max(t0, t1));
+
+    if (enter > exit) {
+      return -1.0f;
+    }
+
+  }
+
+  // The grown box's edges and corners are really rounded. Where the ray
+  // goes in outside the box on two axes or more, it's at one of them, and
+  // the edges it might touch have to be looked at as capsules.
+  float t = std::max(enter, 0.0f);
+  int outside = 0;
+
+  for (int k = 0; k < 3; k++) {
+    outside += std::fabs(origin[k] + direction[k] * t) > half[k] ? 1 : 0;
+  }
+
+  if (outside <= 1) {
+
+    // Starting inside the rounded box
+    if (enter < 0.0f) {
+      return -1.0f;
+    }
+
+    float side = origin[enter_axis] + direction[enter_axis] * t > 0.0f
+                     ? 1.0f
+                     : -1.0f;
+    normal = axes[enter_axis] * side;
+
+    return enter;
+
+  }
+
+  vec3 corners[8];
+
+  for (int i = 0; i < 8; i++) {
+    corners[i] = box.a + axes[0] * (i & 1 ? half[0] : -half[0])
+                 + axes[1] * (i & 2 ? half[1] : -half[1])
+                 + axes[2] * (i & 4 ? half[2] : -half[2]);
+  }
+
+  float nearest = -1.0f;
+
+  for (int i = 0; i < 8; i++) {
+    for (int bit = 1; bit < 8; bit <<= 1) {
+
+      // Each edge once, from the corner with the bit clear
+      if (i & bit) {
+        continue;
+      }
+
+      vec3 edge_normal;
+      float edge_t = intersect_capsule(ray, corners[i], corners[i | bit],
+                                       radius, edge_normal);
+
+      if (edge_t >= 0.0f && (nearest < 0.0f || edge_t < nearest)) {
+        nearest = edge_t;
+        normal = edge_normal;
+      }
+
+    }
+  }
+
+  return nearest;
+
+}
+
+float intersect_shape(const Ray &ray, const ObstacleShape &shape,
+                      float radius, vec3 &normal) {
+
+  switch (shape.type) {
+  case ObstacleShape::Type::CAPSULE:
+    return intersect_capsule(ray, shape.a, shape.b, shape.radius + radius,
+                             normal);
+  case ObstacleShape::Type::BOX:
+    return intersect_box(ray, shape, radius, normal);
+  default:
+    return intersect_triangle(ray, shape.a, shape.b, shape.c, radius, normal);
+  }
+
+}
+
+// Distance along the ray to where it goes into the box from min to max grown
+// by radius, or INFINITY if that's not before max_t. Zero direction
+// components have infinite inverses, which give a NaN for a ray starting
+// right on a face. The comparisons are ordered so std::min and std::max drop
+// it.
+float enter_bounds(const Ray &ray, const float min[3], const float max[3],
+                   float radius, float max_t) {
+
+  const float origin[3] = {ray.origin.x, ray.origin.y, ray.origin.z};
+  const float inv_direction[3] = {ray.inv_direction.x, ray.inv_direction.y,
+                                  ray.inv_direction.z};
+
+  float enter = 0.0f;
+  float exit = max_t;
+
+  for (int k = 0; k < 3; k++) {
+
+    float t0 = (min[k] - radius - origin[k]) * inv_direction[k];
+    float t1 = (max[k] + radius - origin[k]) * inv_direction[k];
+
+    enter = std::max(enter, std::min(t0, t1));
+    exit = std::min(exit, std::max(t0, t1));
+
+  }
+
+  return enter <= exit ? enter : INFINITY;
+
+}
+
+} // namespace
+
+void get_shape_bounds(const ObstacleShape &shape, vec3 &min, vec3 &max) {
+
+  switch (shape.type) {
+
+  case ObstacleShape::Type::CAPSULE: {
+
+    vec3 grow(shape.radius, shape.radius, shape.radius);
+    min = min3(shape.a, shape.b) - grow;
+    max = max3(shape.a, shape.b) + grow;
+    break;
+
+  }
+
+  case ObstacleShape::Type::BOX: {
+
+    // Upright, so it only leans out in x and y
+    vec3 axis_x = shape.c;
+    vec3 extent(std::fabs(axis_x.x) * shape.b.x + std::fabs(axis_x.y)
+                                                      * shape.b.y,
+                std::fabs(axis_x.y) * shape.b.x + std::fabs(axis_x.x)
+                                                      * shape.b.y,
+                shape.b.z);
+    min = shape.a - extent;
+    max = shape.a + extent;
+    break;
+
+  }
+
+  default:
+    min = min3(min3(shape.a, shape.b), shape.c);
+    max = max3(max3(shape.a, shape.b), shape.c);
+    break;
+
+  }
+
+}
+
+Obstacles::Obstacles() {
+  this->is_built = false;
+}
+
+void Obstacles::add_capsule(vec3 a, vec3 b, float radius,
+                            ObstacleMaterial material) {
+
+  assert(!is_built);
+
+  ObstacleShape shape = {};
+  shape.type = ObstacleShape::Type::CAPSULE;
+  shape.material = material;
+  shape.a = a;
+  shape.b = b;
+  shape.radius = radius;
+
+  shapes.push_back(shape);
+
+}
+
+void Obstacles::add_box(vec3 center, vec3 half_extents, float yaw,
+                        ObstacleMaterial material) {
+
+  assert(!is_built);
+
+  ObstacleShape shape = {};
+  shape.type = ObstacleShape::Type::BOX;
+  shape.material = material;
+  shape.a = center;
+  shape.b = half_extents;
+  shape.c = vec3(std::cos(yaw), std::sin(yaw), 0.0f);
+
+  shapes.push_back(shape);
+
+}
+
+void Obstacles::add_mesh(const std::vector<vec3> &vertices,
+                         const std::vector<int> &indices,
+                         ObstacleMaterial material) {
+
+  assert(!is_built && indices.size() % 3 == 0);
+
+  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+
+    ObstacleShape shape = {};
+    shape.type = ObstacleShape::Type::TRIANGLE;
+    shape.material = material;
+    shape.a = vertices[indices[i]];
+    shape.b = vertices[indices[i + 1]];
+    shape.c = vertices[indices[i + 2]];
+
+    shapes.push_back(shape);
+
+  }
+
+}
+
+void Obstacles::build() {
+
+  assert(!is_built);
+
+  ZoneScoped; // for tracy
+
+  nodes.clear();
+
+  if (!shapes.empty()) {
+
+    // A binary tree with at least one shape per leaf has fewer than twice
+    // as many nodes as shapes
+    nodes.reserve(2 * shapes.size());
+    build_node(0, static_cast<int>(shapes.size()), 0);
+
+  }
+
+  is_built = true;
+
+}
+
+int Obstacles::build_node(int begin, int end, int depth) {
+
+  int index = static_cast<int>(nodes.size());
+  nodes.emplace_back();
+
+  vec3 min(INFINITY, INFINITY, INFINITY);
+  vec3 max(-INFINITY, -INFINITY, -INFINITY);
+  vec3 centroid_min = min;
+  vec3 centroid_max = max;
+
+  for (int i = begin; i < end; i++) {
+
+    vec3 shape_min, shape_max;
+    get_shape_bounds(shapes[i], shape_min, shape_max);
+    vec3 centroid = (shape_min + shape_max) * 0.5f;
+
+    min = min3(min, shape_min);
+    max = max3(max, shape_max);
+    centroid_min = min3(centroid_min, centroid);
+    centroid_max = max3(centroid_max, centroid);
+
+  }
+
+  Node &node = nodes[index];
+  node.min[0] = min.x;
+  node.min[1] = min.y;
+  node.min[2] = min.z;
+  node.max[0] = max.x;
+  node.max[1] = max.y;
+  node.max[2] = max.z;
+
+  if (end - begin <= MAX_LEAF_SHAPES || depth == MAX_DEPTH - 1) {
+    node.first = begin;
+    node.count = end - begin;
+    return index;
+  }
+
+  // Halved at the median centroid along the axis they're most spread out on
+  vec3 spread = centroid_max - centroid_min;
+  int axis = spread.x >= spread.y && spread.x >= spread.z ? 0
+             : spread.y >= spread.z                       ? 1
+                                                          : 2;
+  int middle = (begin + end) / 2;
+
+  // Twice the centroid, which sorts the same
+  auto get_centroid = [axis](const ObstacleShape &shape) {
+    vec3 shape_min, shape_max;
+    get_shape_bounds(shape, shape_min, shape_max);
+    return get_component(shape_min + shape_max, axis);
+  };
+
+  std::nth_element(shapes.begin() + begin, shapes.begin() + middle,
+                   shapes.begin() + end,
+                   [&](const ObstacleShape &a, const ObstacleShape &b) {
+                     return get_centroid(a) < get_centroid(b);
+                   });
+
+  // The first child always follows its parent. Taking the index of the
+  // second child after building both means node can't be used any more, as
+  // the vector may have grown.
+  build_node(begin, middle, depth + 1);
+  int second = build_node(middle, end, depth + 1);
+
+  nodes[index].first = second;
+  nodes[index].count = 0;
+
+  return index;
+
+}
+
+bool Obstacles::is_empty() const {
+  return shapes.empty();
+}
+
+const std::vector<ObstacleShape> &Obstacles::get_shapes() const {
+  return shapes;
+}
+
+bool Obstacles::sweep(vec3 start, vec3 end, float radius,
+                      ObstacleHit &hit) const {
+
+  assert(is_built);
+
+  if (nodes.empty()) {
+    return false;
+  }
+
+  vec3 segment = end - start;
+  float length = norm(segment);
+
+  if (length == 0.0f) {
+    return false;
+  }
+
+  Ray ray;
+  ray.origin = start;
+  ray.direction = segment / length;
+  ray.inv_direction = vec3(1.0f / ray.direction.x, 1.0f / ray.direction.y,
+                           1.0f / ray.direction.z);
+  ray.length = length;
+
+  // The nearest hit so far. Anything further along can be skipped.
+  float nearest = length;
+  int nearest_shape = -1;
+  vec3 nearest_normal;
+
+  int stack[MAX_DEPTH];
+  int stack_size = 0;
+
+  if (enter_bounds(ray, nodes[0].min, nodes[0].max, radius, nearest)
+      != INFINITY) {
+    stack[stack_size++] = 0;
+  }
+
+  while (stack_size > 0) {
+
+    int index = stack[--stack_size];
+    const Node &node = nodes[index];
+
+    if (node.count > 0) {
+
+      for (int i = node.first; i < node.first + node.count; i++) {
+
+        vec3 normal;
+        float t = intersect_shape(ray, shapes[i], radius, normal);
+
+        if (t >= 0.0f && t <= nearest) {
+          nearest = t;
+          nearest_shape = i;
+          nearest_normal = normal;
+        }
+
+      }
+
+      continue;
+
+    }
+
+    // Nearer child on top, so it's searched first and can rule out the
+    // other. Children are checked against the nearest hit when they're
+    // pushed, which is as good as when they're popped for the first one.
+    int first = index + 1;
+    int second = node.first;
+
+    float first_t = enter_bounds(ray, nodes[first].min, nodes[first].max,
+                                 radius, nearest);
+    float second_t = enter_bounds(ray, nodes[second].min, nodes[second].max,
+                                  radius, nearest);
+
+    if (first_t > second_t) {
+      std::swap(first, second);
+      std::swap(first_t, second_t);
+    }
+
+    if (second_t != INFINITY) {
+      stack[stack_size++] = second;
+    }
+
+    if (first_t != INFINITY) {
+      stack[stack_size++] = first;
+    }
+
+  }
+
+  if (nearest_shape < 0) {
+    return false;
+  }
+
+  hit.fraction = nearest / length;
+  hit.position = start + ray.direction * nearest;
+  // Worked out far from the origin, the normals can be a little off unit
+  // length
+  hit.normal = nearest_normal.unit_vector();
+  hit.material = shapes[nearest_shape].material;
+
+  return true;
+
+}
+
+Obstacles Obstacles::driving_range(const Terrain &terrain) {
+
+  Obstacles obstacles;
+
+  auto ground = [&terrain](float x, float y) {
+    return vec3(x, y, terrain.get_height(x, y));
+  };
+
+  // Trees down both sides, staggered a little: a trunk and a round canopy
+  const float tree_offsets[4] = {0.0f, 6.0f, -4.0f, 9.0f};
+
+  for (int i = 0; i < 10; i++) {
+    for (int side = -1; side <= 1; side += 2) {
+
+      float x = 30.0f + 30.0f * static_cast<float>(i)
+                + 7.0f * static_cast<float>(side);
+      float y = static_cast<float>(side) * (38.0f + tree_offsets[i % 4]);
+
+      vec3 base = ground(x, y);
+
+      // Sunk into the ground a little so there's no gap under it on a slope
+      obstacles.add_capsule(base - vec3(0.0f, 0.0f, 0.5f),
+                            base + vec3(0.0f, 0.0f, 5.0f), 0.25f,
+                            ObstacleMaterial::TREE);
+      obstacles.add_capsule(base + vec3(0.0f, 0.0f, 8.0f),
+                            base + vec3(0.0f, 0.0f, 8.0f), 3.5f,
+                            ObstacleMaterial::TREE);
+
+    }
+  }
+
+  // Flagsticks on the target greens, 7 feet tall
+  for (int i = 0; i < NUM_RANGE_GREENS; i++) {
+
+    vec3 base = ground(RANGE_GREEN_X[i], RANGE_GREEN_Y[i]);
+    obstacles.add_capsule(base, base + vec3(0.0f, 0.0f, 2.13f), 0.0125f,
+                          ObstacleMaterial::FLAGSTICK);
+
+  }
+
+  // A ball collection hut off to one side
+  obstacles.add_box(ground(160.0f, 24.0f) + vec3(0.0f, 0.0f, 1.5f),
+                    vec3(3.0f, 2.0f, 1.5f), 0.5f, ObstacleMaterial::TREE);
+
+  // The net across the far end, as a mesh hung between posts 20 m apart
+  const float net_x = 330.0f;
+  const float net_height = 30.0f;
+  const int num_posts = 7;
+
+  std::vector<vec3> vertices;
+  std::vector<int> indices;
+
+  for (int i = 0; i < num_posts; i++) {
+
+    vec3 base = ground(net_x, -60.0f + 20.0f * static_cast<float>(i));
+    vec3 top = base + vec3(0.0f, 0.0f, net_height);
+
+    obstacles.add_capsule(base, top, 0.15f, ObstacleMaterial::TREE);
+
+    vertices.push_back(base);
+    vertices.push_back(top);
+
+    if (i > 0) {
+
+      int v = 2 * i;
+      const int quad[6] = {v - 2, v, v - 1, v - 1, v, v + 1};
+      indices.insert(indices.end(), quad, quad + 6);
+
+    }
+
+  }
+
+  obstacles.add_mesh(vertices, indices, ObstacleMaterial::NET);
+
+  obstacles.build();
+
+  return obstacles;
+
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "../Terrain/Terrain.h"
+#include "../math/vec3.h"
+#include <cstdint>
+#include <vector>
+
+// What an obstacle is made of, which decides how a ball comes off it
+enum class ObstacleMaterial : uint8_t {
+  TREE,
+  FLAGSTICK,
+  NET,
+  NUM_MATERIALS
+};
+
+// The fraction of the ball's speed into the surface it keeps after hitting
+// it, and of its speed and spin along it
+struct ObstacleResponse {
+
+  float restitution;
+  float tangential_retention;
+
+};
+
+const ObstacleResponse OBSTACLE_RESPONSES[] = {
+    {0.45f, 0.7f}, // TREE
+    {0.6f, 0.9f},  // FLAGSTICK
+    {0.05f, 0.2f}, // NET, which soaks up nearly all of it
+};
+
+static_assert(sizeof(OBSTACLE_RESPONSES) / sizeof(OBSTACLE_RESPONSES[0])
+                  == static_cast<size_t>(ObstacleMaterial::NUM_MATERIALS),
+              "Every obstacle material needs a response");
+
+// One piece of obstacle geometry. Meshes are added as their triangles.
+struct ObstacleShape {
+
+  enum class Type : uint8_t { CAPSULE, BOX, TRIANGLE };
+
+  Type type;
+  ObstacleMaterial material;
+
+  // CAPSULE: the ends of its axis in a and b, and its radius. A sphere has
+  // a == b.
+  // BOX: the center in a, the half extents along its own x, y and z axes in
+  // b, and its x axis in c. Boxes stand upright, so they only turn about the
+  // vertical.
+  // TRIANGLE: the corners in a, b and c.
+  vec3 a;
+  vec3 b;
+  vec3 c;
+  float radius;
+
+};
+
+// Where a moving ball first touches an obstacle
+struct ObstacleHit {
+
+  // How far along the swept segment, from 0 to 1
+  float fraction;
+
+  // The ball's center when it touches, and the surface normal there,
+  // pointing out of the obstacle towards the ball
+  vec3 position;
+  vec3 normal;
+
+  ObstacleMaterial material;
+
+};
+
+/*
+  Static obstacles a ball in flight can hit: trees, flagsticks, nets and the
+  like, made up of capsules, upright boxes and triangle meshes.
+
+  The shapes are put into a bounding volume hierarchy once by build(), after
+  which the set doesn't change. A query sweeps a sphere along a ball's
+  segment for a step and walks the tree with a fixed size stack, so it never
+  allocates and only looks at the shapes whose bounds the segment passes
+  through.
+*/
+class Obstacles {
+private:
+  // Two to a cache line. An interior node's first child is the next node
+  // and its second is at first. A leaf holds count shapes from first.
+  struct alignas(32) Node {
+
+    float min[3];
+    int32_t first;
+    float max[3];
+    int32_t count;
+
+  };
+
+  static_assert(sizeof(Node) == 32, "Obstacle BVH nodes must be 32 bytes");
+
+  // Leaves are split until they hold this many shapes or fewer
+  static const int MAX_LEAF_SHAPES = 4;
+
+  // Deep enough for a tree over far more shapes than will ever be added,
+  // as build() splits at the median
+  static const int MAX_DEPTH = 64;
+
+  // In leaf order once built
+  std::vector<ObstacleShape> shapes;
+  std::vector<Node> nodes;
+  bool is_built;
+
+  // Builds the subtree over shapes [begin, end) and returns its index
+  int build_node(int begin, int end, int depth);
+
+public:
+  Obstacles();
+
+  void add_capsule(vec3 a, vec3 b, float radius, ObstacleMaterial material);
+
+  // yaw turns the box's x axis from the world's about the vertical, in
+  // radians
+  void add_box(vec3 center, vec3 half_extents, float yaw,
+               ObstacleMaterial material);
+
+  // Three indices into vertices per triangle
+  void add_mesh(const std::vector<vec3> &vertices,
+                const std::vector<int> &indices, ObstacleMaterial material);
+
+  // Builds the hierarchy. Nothing can be added afterwards.
+  void build();
+
+  // A few trees down either side of a driving range, flagsticks on the
+  // target greens and a net at the far end, standing on the terrain and
+  // already built
+  static Obstacles driving_range(const Terrain &terrain);
+
+  bool is_empty() const;
+  const std::vector<ObstacleShape> &get_shapes() const;
+
+  // Sweeps a sphere of the given radius from start to end and finds the
+  // first shape it runs into. Shapes it starts out touching are passed
+  // through, so a ball that's just bounced off one can leave. Only once
+  // built.
+  bool sweep(vec3 start, vec3 end, float radius, ObstacleHit &hit) const;
+
+};
+
+// The smallest axis aligned box holding the shape
+void get_shape_bounds(const ObstacleShape &shape, vec3 &min, vec3 &max);
@@ -0,0 +1,214 @@
+#include "aero.h"
+#include "../math/linear.h"
+#include "coefficients.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Printed by --fit-aero
+const AeroFit AERO_FIT = {
+    // drag
+    {0.25499585f, -0.0061937696f, -0.076414376f, 0.064249232f,
+     -0.056195915f, 0.69542331f, -0.6111182f, 0.15052788f,
+     1.5540391f, -2.2353117f},
+    // lift
+    {0.068236656f, 0.025671789f, -0.009908665f, -0.02627016f,
+     0.85773754f, 0.6400032f, -0.15526022f, -1.9893966f,
+     0.51074314f, 0.026550656f},
+    0.37336302f,
+    2.3646324f,
+    1.0124897f};
+
+namespace {
+
+// Where the table's open bands are closed off for sampling. Below 15 m/s a
+// ball is about to land, and the slowest band's odd negative lifts would
+// pull the whole fit towards them.
+const float MIN_SAMPLE_SPEED = 15.0f;       // in m/s
+const float MAX_SAMPLE_SPEED = 95.0f;       // in m/s
+const float MAX_SAMPLE_SPIN_RATE = 7000.0f; // in rpm
+
+const int NUM_ROWS = 10;
+const int NUM_COLUMNS = 7;
+
+struct AeroSample {
+
+  double u;
+  double s;
+  double drag;
+  double lift;
+  int row;
+
+  // By the square of the speed, since an error in a coefficient matters as
+  // much as the force it scales
+  double weight;
+
+};
+
+// The terms of the fit at u and s, in the order of AeroFit
+void get_terms(double u, double s, double *terms) {
+
+  terms[0] = 1.0;
+  terms[1] = u;
+  terms[2] = u * u;
+  terms[3] = u * u * u;
+  terms[4] = s;
+  terms[5] = s * u;
+  terms[6] = s * u * u;
+  terms[7] = s * s;
+  terms[8] = s * s * u;
+  terms[9] = s * s * s;
+
+}
+
+// Weighted least squares over the samples, through the normal equations, of
+// the drag (coefficient 0) or the lift (1)
+void fit_coefficient(const std::vector<AeroSample> &samples, int coefficient,
+                     float *fit) {
+
+  const int n = NUM_AERO_TERMS;
+
+  std::vector<double> normal(n * n, 0.0);
+  std::vector<double> rhs(n, 0.0);
+  double terms[NUM_AERO_TERMS];
+
+  for (const AeroSample &sample : samples) {
+
+    double value = coefficient == 0 ? sample.drag : sample.lift;
+    get_terms(sample.u, sample.s, terms);
+
+    for (int i = 0; i < n; i++) {
+
+      rhs[i] += sample.weight * terms[i] * value;
+
+      for (int j = 0; j < n; j++) {
+        normal[i * n + j] += sample.weight * terms[i] * terms[j];
+      }
+
+    }
+
+  }
+
+  solve_linear_system(normal, rhs, n);
+
+  for (int i = 0; i < n; i++) {
+    fit[i] = static_cast<float>(rhs[i]);
+  }
+
+}
+
+} // namespace
+
+AeroFitReport fit_aero_table(const float (&table)[10][7][2],
+                             int samples_per_side) {
+
+  // The band edges, with the open ends closed off
+  float speed_edges[NUM_ROWS + 1];
+  float spin_edges[NUM_COLUMNS + 1];
+
+  speed_edges[0] = MIN_SAMPLE_SPEED;
+  speed_edges[NUM_ROWS] = MAX_SAMPLE_SPEED;
+  for (int i = 1; i < NUM_ROWS; i++) {
+    speed_edges[i] = std::sqrt(AIR_SPEED_SQUARED_BANDS[i - 1]);
+  }
+
+  spin_edges[0] = 0.0f;
+  spin_edges[NUM_COLUMNS] = MAX_SAMPLE_SPIN_RATE;
+  for (int i = 1; i < NUM_COLUMNS; i++) {
+    spin_edges[i] = SPIN_RATE_BANDS[i - 1];
+  }
+
+  // Evenly through every cell, at the middles of a grid over it
+  std::vector<AeroSample> samples;
+
+  for (int row = 0; row < NUM_ROWS; row++) {
+    for (int column = 0; column < NUM_COLUMNS; column++) {
+      for (int i = 0; i < samples_per_side; i++) {
+        for (int j = 0; j < samples_per_side; j++) {
+
+          double fraction_i = (i + 0.5) / samples_per_side;
+          double fraction_j = (j + 0.5) / samples_per_side;
+
+          double speed =
+              speed_edges[row]
+              + (speed_edges[row + 1] - speed_edges[row]) * fraction_i;
+          double spin_rate =
+              spin_edges[column]
+              + (spin_edges[column + 1] - spin_edges[column]) * fraction_j;
+
+          AeroSample sample;
+          sample.u = AERO_U_PER_SPEED / speed;
+          sample.s = spin_rate * AERO_SPIN_RATIO_PER_RPM / speed;
+          sample.drag = table[row][column][0];
+          sample.lift = table[row][column][1];
+          sample.row = row;
+          sample.weight = speed * speed;
+
+          samples.push_back(sample);
+
+        }
+      }
+    }
+  }
+
+  AeroFitReport report = {};
+  AeroFit &fit = report.fit;
+
+  fit_coefficient(samples, 0, fit.drag);
+  fit_coefficient(samples, 1, fit.lift);
+
+  fit.min_u = AERO_U_PER_SPEED / MAX_SAMPLE_SPEED;
+  fit.max_u = AERO_U_PER_SPEED / MIN_SAMPLE_SPEED;
+  fit.max_spin_ratio = 0.0f;
+
+  for (const AeroSample &sample : samples) {
+    fit.max_spin_ratio =
+        std::max(fit.max_spin_ratio, static_cast<float>(sample.s));
+  }
+
+  // The errors of the fit as it's evaluated in flight, in floats
+  double drag_squared[NUM_ROWS + 1] = {};
+  double lift_squared[NUM_ROWS + 1] = {};
+  int counts[NUM_ROWS + 1] = {};
+
+  for (const AeroSample &sample : samples) {
+
+    float u = static_cast<float>(sample.u);
+    float s = static_cast<float>(sample.s);
+
+    double drag_error =
+        std::fabs(evaluate_aero_fit(fit.drag, u, s) - sample.drag);
+    double lift_error =
+        std::fabs(evaluate_aero_fit(fit.lift, u, s) - sample.lift);
+
+    for (int k : {sample.row, NUM_ROWS}) {
+
+      AeroFitError &error = k == NUM_ROWS ? report.total : report.rows[k];
+
+      drag_squared[k] += drag_error * drag_error;
+      lift_squared[k] += lift_error * lift_error;
+      counts[k]++;
+
+      error.drag_max =
+          std::max(error.drag_max, static_cast<float>(drag_error));
+      error.lift_max =
+          std::max(error.lift_max, static_cast<float>(lift_error));
+
+    }
+
+  }
+
+  for (int k = 0; k <= NUM_ROWS; k++) {
+
+    AeroFitError &error = k == NUM_ROWS ? report.total : report.rows[k];
+
+    error.drag_rms = static_cast<float>(std::sqrt(drag_squared[k] / counts[k]));
+    error.lift_rms = static_cast<float>(std::sqrt(lift_squared[k] / counts[k]));
+
+  }
+
+  report.num_samples = static_cast<int>(samples.size());
+
+  return report;
+
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "../math/generic.h"
+#include "atmosphere.h"
+#include "constants.h"
+#include <utility>
+
+/*
+  Smooth aerodynamic coefficients. The drag and lift coefficients as
+  functions of the Reynolds number and the spin ratio (the speed of the
+  ball's surface over its air speed), rather than the table's bands of air
+  speed and spin rate (see coefficients.h), so they change continuously
+  along a flight instead of jumping at every band edge.
+
+  Each coefficient is a cubic in u = 10^5 / Re and the spin ratio s,
+
+        c0 + c1 u + c2 u^2 + c3 u^3 + c4 s + c5 s u + c6 s u^2
+           + c7 s^2 + c8 s^2 u + c9 s^3,
+
+  which is a rational function of the Reynolds number. Evaluated in Horner
+  form it's nine FMAs on top of the speed's square root and reciprocal, the
+  same for every lane, so it vectorizes with no gathers.
+
+  The coefficients are fitted to the table by least squares (see
+  fit_aero_table()), and u and s are clamped to the ranges the table
+  covers, since a cubic runs away outside the data it was fitted to.
+*/
+
+const int NUM_AERO_TERMS = 10;
+
+struct AeroFit {
+
+  // In the order of the terms above
+  float drag[NUM_AERO_TERMS];
+  float lift[NUM_AERO_TERMS];
+
+  // The ranges the table covers
+  float min_u;
+  float max_u;
+  float max_spin_ratio;
+
+};
+
+// Fitted with fit_aero_table() on DRAG_AND_LIFT_COEFFICIENTS_ARR
+extern const AeroFit AERO_FIT;
+
+// u at an air speed of 1 m/s in the reference air (see atmosphere.h), i.e.
+// 10^5 * nu / D
+constexpr float AERO_U_PER_SPEED =
+    1e5f * REFERENCE_KINEMATIC_VISCOSITY / (2.0f * RADIUS);
+
+// The spin ratio at an air speed of 1 m/s, per rpm: (2 pi / 60) * r
+constexpr float AERO_SPIN_RATIO_PER_RPM = 0.10471975511965977f * RADIUS;
+
+template <typename T>
+MATH_INLINE T evaluate_aero_fit(const float *c, T u, T s) {
+
+  T a = T(c[0]) + u * (T(c[1]) + u * (T(c[2]) + u * T(c[3])));
+  T b = T(c[4]) + u * (T(c[5]) + u * T(c[6]));
+  T d = T(c[7]) + u * T(c[8]);
+
+  return a + s * (b + s * (d + s * T(c[9])));
+
+}
+
+// air_speed_squared is the ball's own, and speed_squared_scale turns it into
+// the one with the same Reynolds number in the reference air (see
+// AirConstants). The spin ratio doesn't depend on the air.
+template <typename T>
+MATH_INLINE std::pair<T, T>
+get_smooth_drag_and_lift_coefficients(T air_speed_squared, T spin_rate,
+                                      T speed_squared_scale) {
+
+  using std::max;
+  using std::min;
+  using std::sqrt;
+
+  const AeroFit &fit = AERO_FIT;
+
+  // A ball that's barely moving clamps to the slowest band, so the
+  // reciprocals stay finite
+  T speed = max(sqrt(air_speed_squared), T(1e-3f));
+  T reynolds_speed = speed * sqrt(speed_squared_scale);
+
+  T u = min(max(T(AERO_U_PER_SPEED) / reynolds_speed, T(fit.min_u)),
+            T(fit.max_u));
+  T s = min(max(spin_rate * T(AERO_SPIN_RATIO_PER_RPM) / speed, T(0.0f)),
+            T(fit.max_spin_ratio));
+
+  return std::make_pair(evaluate_aero_fit(fit.drag, u, s),
+                        evaluate_aero_fit(fit.lift, u, s));
+
+}
+
+// How far the fit is from the table, over points spread evenly through
+// every cell, in coefficient units (unweighted)
+struct AeroFitError {
+
+  float drag_rms;
+  float drag_max;
+  float lift_rms;
+  float lift_max;
+
+};
+
+struct AeroFitReport {
+
+  AeroFit fit;
+
+  int num_samples;
+
+  // Over the whole table, and by the table's rows of air speed
+  AeroFitError total;
+  AeroFitError rows[10];
+
+};
+
+// Fits both coefficients to a table laid out like
+// DRAG_AND_LIFT_COEFFICIENTS_ARR, from samples_per_side^2 points in every
+// cell. The open bands at the top of the table are closed at 95 m/s and
+// 7000 rpm, and the slowest starts at 15 m/s, where a ball is about to land.
+AeroFitReport fit_aero_table(const float (&table)[10][7][2],
+                             int samples_per_side);
@@ -0,0 +1,71 @@
+#include "atmosphere.h"
+#include <cmath>
+
+namespace {
+
+// Specific gas constants, in J/(kg K)
+const float DRY_AIR_GAS_CONSTANT = 287.058f;
+const float WATER_VAPOR_GAS_CONSTANT = 461.495f;
+
+const float SEA_LEVEL_PRESSURE = 101325.0f; // in pascals
+const float ZERO_CELSIUS = 273.15f;         // in kelvin
+
+// Sutherland's law for air
+const float SUTHERLAND_REFERENCE_VISCOSITY = 1.716e-5f; // in Pa s at 0 C
+const float SUTHERLAND_CONSTANT = 110.4f;               // in kelvin
+
+// The standard atmosphere's pressure up to 11 km, where the temperature
+// falls 6.5 degrees a kilometer
+float get_standard_pressure(float altitude) {
+  return SEA_LEVEL_PRESSURE
+         * std::pow(1.0f - 2.25577e-5f * altitude, 5.25588f);
+}
+
+// Over water, in pascals (the Magnus formula, with Alduchov and Eskridge's
+// coefficients)
+float get_saturation_vapor_pressure(float temperature) {
+  return 610.94f * std::exp(17.625f * temperature / (temperature + 243.04f));
+}
+
+} // namespace
+
+AirProperties get_air_properties(const SiteConditions &site) {
+
+  float pressure = site.pressure > 0.0f ? site.pressure
+                                        : get_standard_pressure(site.altitude);
+  float kelvin = site.temperature + ZERO_CELSIUS;
+
+  float vapor_pressure = site.relative_humidity
+                         * get_saturation_vapor_pressure(site.temperature);
+  float dry_pressure = pressure - vapor_pressure;
+
+  AirProperties air;
+
+  air.density = dry_pressure / (DRY_AIR_GAS_CONSTANT * kelvin)
+                + vapor_pressure / (WATER_VAPOR_GAS_CONSTANT * kelvin);
+
+  air.dynamic_viscosity =
+      SUTHERLAND_REFERENCE_VISCOSITY * std::pow(kelvin / ZERO_CELSIUS, 1.5f)
+      * (ZERO_CELSIUS + SUTHERLAND_CONSTANT) / (kelvin + SUTHERLAND_CONSTANT);
+
+  air.kinematic_viscosity = air.dynamic_viscosity / air.density;
+
+  return air;
+
+}
+
+AirConstants<float> get_air_constants(const AirProperties &air) {
+
+  float density_ratio = air.density / REFERENCE_AIR_DENSITY;
+  float viscosity_ratio =
+      REFERENCE_KINEMATIC_VISCOSITY / air.kinematic_viscosity;
+
+  return AirConstants<float>(LIFT_CONST * density_ratio,
+                             DRAG_CONST * density_ratio,
+                             viscosity_ratio * viscosity_ratio);
+
+}
+
+AirConstants<float> get_air_constants(const SiteConditions &site) {
+  return get_air_constants(get_air_properties(site));
+}
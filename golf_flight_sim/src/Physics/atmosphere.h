@@ -0,0 +1,81 @@
+#pragma once
+
+#include "constants.h"
+
+/*
+  Atmosphere model. The air's density scales lift and drag directly, and its
+  viscosity sets the Reynolds number the ball flies at for a given air
+  speed, which picks the drag and lift coefficients. Both follow from the
+  conditions at the site: thin air at altitude or on a hot day carries a
+  ball further, and humid air is slightly thinner than dry air at the same
+  pressure, since water vapor is lighter.
+
+  The flight model never sees the conditions themselves, only AirConstants,
+  which fold everything it needs into three numbers worked out once per
+  environment. Templated on the scalar type like the force functions, so a
+  vector can hold a different environment in every lane.
+*/
+
+// The air the lift and drag constants and the coefficient table's speed
+// bands were worked out for
+constexpr float REFERENCE_AIR_DENSITY = 1.2f; // in kg/m^3
+constexpr float REFERENCE_KINEMATIC_VISCOSITY = 1.511e-5f; // in m^2/s
+
+struct SiteConditions {
+
+  float altitude;          // above sea level, in meters
+  float temperature;       // in degrees Celsius
+  float relative_humidity; // from 0 to 1
+
+  // Station pressure, in pascals, or 0 to take the standard atmosphere's
+  // pressure at the altitude
+  float pressure;
+
+};
+
+// Sea level on a mild, dry day, close to the reference air
+constexpr SiteConditions STANDARD_SITE = {0.0f, 20.0f, 0.0f, 0.0f};
+
+struct AirProperties {
+
+  float density;             // in kg/m^3
+  float dynamic_viscosity;   // in Pa s
+  float kinematic_viscosity; // in m^2/s
+
+};
+
+template <typename T> struct AirConstants {
+
+  // LIFT_CONST and DRAG_CONST (see constants.h) in this air
+  T lift_const;
+  T drag_const;
+
+  // Scales the square of the air speed to the one giving the same Reynolds
+  // number in the reference air, which is what the coefficient table is
+  // looked up by: (REFERENCE_KINEMATIC_VISCOSITY / kinematic viscosity)^2
+  T speed_squared_scale;
+
+  AirConstants() = default;
+
+  constexpr AirConstants(T lift_const, T drag_const, T speed_squared_scale)
+      : lift_const(lift_const), drag_const(drag_const),
+        speed_squared_scale(speed_squared_scale) {}
+
+  // From the scalar constants, the same in every lane
+  template <typename U>
+  explicit constexpr AirConstants(const AirConstants<U> &air)
+      : lift_const(T(air.lift_const)), drag_const(T(air.drag_const)),
+        speed_squared_scale(T(air.speed_squared_scale)) {}
+
+};
+
+// The reference air exactly, which the simulation has always flown in
+constexpr AirConstants<float> REFERENCE_AIR(LIFT_CONST, DRAG_CONST, 1.0f);
+
+// The moist air's density from the partial pressures of dry air and water
+// vapor, and its viscosity from Sutherland's law for dry air (humidity
+// changes it by well under a percent)
+AirProperties get_air_properties(const SiteConditions &site);
+
+AirConstants<float> get_air_constants(const AirProperties &air);
+AirConstants<float> get_air_constants(const SiteConditions &site);
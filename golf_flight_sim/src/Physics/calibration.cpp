@@ -0,0 +1,793 @@
+#include "calibration.h"
+#include "../Simulation/Simulation.h"
+#include "../math/linear.h"
+#include "../math/unit_conversion.h"
+#include "../tracy/tracy/Tracy.hpp"
+#include "surfaces.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+
+const char *const CALIBRATION_PARAMETER_NAMES[NUM_CALIBRATION_PARAMETERS] = {
+    "drag_scale", "lift_scale", "spin_decay_rate",
+    "firmness",   "friction",   "roll_friction"};
+
+namespace {
+
+// Long enough for any real shot, bounces included
+const float MAX_SHOT_TIME = 30.0f; // in seconds
+
+const int NUM_OUTCOMES = 3;
+
+// Central differences step each parameter by this fraction of its default,
+// far enough that the float arithmetic of a whole flight doesn't swamp the
+// change
+const float DIFFERENCE_STEP = 5e-3f;
+
+// The trial dampings of each iteration, as multiples of the current one
+const float TRIAL_DAMPINGS[] = {0.1f, 1.0f, 10.0f, 100.0f};
+const int NUM_TRIALS = sizeof(TRIAL_DAMPINGS) / sizeof(TRIAL_DAMPINGS[0]);
+
+const float INITIAL_DAMPING = 1e-3f;
+
+// Parameters stay within these multiples of their defaults, all of which are
+// positive
+const float MIN_PARAMETER_SCALE = 0.1f;
+const float MAX_PARAMETER_SCALE = 10.0f;
+
+// The fit has converged once an iteration improves the cost by less than
+// this fraction
+const double MIN_IMPROVEMENT = 1e-6;
+
+// A parameter counts as identified by the shots if they'd narrow its prior
+// down to less than this fraction of its spread. At half of it the prior
+// still has a say, and the linearized uncertainty is too optimistic over
+// that range to trust.
+const float MAX_UNCERTAINTY_FRACTION = 0.25f;
+
+// Shots a thread takes from the batch at a time. They fly side by side
+// through its simulation, which shares out the cost of every step.
+const int SHOTS_PER_TASK = 32;
+
+float parse_field(const std::string &field) {
+
+  char *end = nullptr;
+  float value = std::strtof(field.c_str(), &end);
+
+  if (end == field.c_str()) {
+    return std::numeric_limits<float>::quiet_NaN();
+  }
+
+  return value;
+
+}
+
+// Flies every shot with every candidate, into outcomes[candidate * num_shots
+// + shot]. Every thread takes the next few shots nobody has flown yet, since
+// drives take several times as long as wedges.
+void simulate_batch(const std::vector<MeasuredShot> &shots,
+                    const std::vector<PhysicsParameters> &candidates,
+                    int num_threads, std::vector<ShotOutcome> &outcomes) {
+
+  ZoneScoped; // for tracy
+
+  int num_shots = static_cast<int>(shots.size());
+  int num_tasks = static_cast<int>(candidates.size())
+                  * ((num_shots + SHOTS_PER_TASK - 1) / SHOTS_PER_TASK);
+  int tasks_per_candidate = num_tasks / static_cast<int>(candidates.size());
+
+  outcomes.resize(candidates.size() * shots.size());
+
+  std::atomic<int> next_task(0);
+
+  auto simulate_tasks = [&]() {
+
+    // Every thread flies its tasks through a simulation of its own
+    auto simulation = std::make_unique<Simulation>(
+        1.0f / PHYSICS_STEPS_PER_SECOND, Wind(0.0f, 0.0f, false));
+
+    LaunchConditions<float> launches[SHOTS_PER_TASK];
+    std::vector<ShotMetrics> metrics;
+
+    for (int task = next_task++; task < num_tasks; task = next_task++) {
+
+      int candidate = task / tasks_per_candidate;
+      int first = (task % tasks_per_candidate) * SHOTS_PER_TASK;
+      int count = std::min(SHOTS_PER_TASK, num_shots - first);
+
+      for (int i = 0; i < count; i++) {
+        launches[i] = shots[first + i].launch;
+      }
+
+      simulate_shots(*simulation, launches, count,
+                     vec3(0.0f, 0.0f, TEE_HEIGHT), candidates[candidate],
+                     AeroModelType::TABLE, metrics);
+
+      for (int i = 0; i < count; i++) {
+        outcomes[candidate * num_shots + first + i] =
+            get_shot_outcome(metrics[i]);
+      }
+
+    }
+
+  };
+
+  num_threads = std::max(1, std::min(num_threads, num_tasks));
+
+  // This thread flies its share as well
+  std::vector<std::thread> threads;
+
+  for (int i = 1; i < num_threads; i++) {
+    threads.emplace_back(simulate_tasks);
+  }
+
+  simulate_tasks();
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+}
+
+// Three per shot, in the order of ShotOutcome, and zero where nothing was
+// observed. Returns the sum of their squares.
+double get_residuals(const std::vector<MeasuredShot> &shots,
+                     const ShotOutcome *outcomes,
+                     const CalibrationSettings &settings,
+                     std::vector<double> &residuals) {
+
+  residuals.assign(shots.size() * NUM_OUTCOMES, 0.0);
+
+  const float tolerances[NUM_OUTCOMES] = {settings.carry_tolerance,
+                                          settings.total_tolerance,
+                                          settings.apex_tolerance};
+
+  double cost = 0.0;
+
+  for (size_t i = 0; i < shots.size(); i++) {
+
+    const float observed[NUM_OUTCOMES] = {shots[i].observed.carry,
+                                          shots[i].observed.total,
+                                          shots[i].observed.apex};
+    const float simulated[NUM_OUTCOMES] = {
+        outcomes[i].carry, outcomes[i].total, outcomes[i].apex};
+
+    for (int k = 0; k < NUM_OUTCOMES; k++) {
+
+      if (std::isnan(observed[k])) {
+        continue;
+      }
+
+      double residual = (static_cast<double>(simulated[k]) - observed[k])
+                        / tolerances[k];
+
+      residuals[i * NUM_OUTCOMES + k] = residual;
+      cost += residual * residual;
+
+    }
+
+  }
+
+  return cost;
+
+}
+
+// Root mean square errors in meters, by the order of ShotOutcome
+void get_outcome_errors(const std::vector<MeasuredShot> &shots,
+                        const ShotOutcome *outcomes, float *errors) {
+
+  double squared[NUM_OUTCOMES] = {};
+  int counts[NUM_OUTCOMES] = {};
+
+  for (size_t i = 0; i < shots.size(); i++) {
+
+    const float observed[NUM_OUTCOMES] = {shots[i].observed.carry,
+                                          shots[i].observed.total,
+                                          shots[i].observed.apex};
+    const float simulated[NUM_OUTCOMES] = {
+        outcomes[i].carry, outcomes[i].total, outcomes[i].apex};
+
+    for (int k = 0; k < NUM_OUTCOMES; k++) {
+
+      if (!std::isnan(observed[k])) {
+        double error = simulated[k] - observed[k];
+        squared[k] += error * error;
+        counts[k]++;
+      }
+
+    }
+
+  }
+
+  for (int k = 0; k < NUM_OUTCOMES; k++) {
+    errors[k] = counts[k] > 0 ? static_cast<float>(
+                                    std::sqrt(squared[k] / counts[k]))
+                              : 0.0f;
+  }
+
+}
+
+// In the parameter's own units
+float get_prior_spread(int parameter, const CalibrationSettings &settings) {
+
+  return settings.prior_spread[parameter]
+         * DEFAULT_PHYSICS_PARAMETERS.values[parameter];
+
+}
+
+float clamp_parameter(float value, int parameter) {
+
+  float scale = DEFAULT_PHYSICS_PARAMETERS.values[parameter];
+
+  return std::min(std::max(value, MIN_PARAMETER_SCALE * scale),
+                  MAX_PARAMETER_SCALE * scale);
+
+}
+
+// The prior's rows, one per tuned parameter, after the observations'.
+// Returns the sum of their squares.
+double add_prior_residuals(const PhysicsParameters &parameters,
+                           const PhysicsParameters &initial,
+                           const std::vector<int> &tuned,
+                           const CalibrationSettings &settings,
+                           std::vector<double> &residuals) {
+
+  double cost = 0.0;
+
+  for (int parameter : tuned) {
+
+    double residual = (parameters.values[parameter]
+                       - initial.values[parameter])
+                      / get_prior_spread(parameter, settings);
+
+    residuals.push_back(residual);
+    cost += residual * residual;
+
+  }
+
+  return cost;
+
+}
+
+// The observations' residuals and then the priors'. Returns the sum of
+// their squares.
+double get_cost(const std::vector<MeasuredShot> &shots,
+                const ShotOutcome *outcomes,
+                const PhysicsParameters &parameters,
+                const std::vector<int> &tuned,
+                const CalibrationSettings &settings,
+                const CalibrationResult &result,
+                std::vector<double> &residuals) {
+
+  return get_residuals(shots, outcomes, settings, residuals)
+         + add_prior_residuals(parameters, result.initial, tuned, settings,
+                               residuals);
+
+}
+
+/*
+  The normal equations J^T J and the gradient J^T r of the cost's residuals
+  at current, by tuned parameter, from central differences. The priors'
+  rows are linear in the parameters, so those are exact.
+*/
+void get_normal_equations(const std::vector<MeasuredShot> &shots,
+                          const std::vector<int> &tuned,
+                          const PhysicsParameters &current,
+                          const std::vector<double> &residuals,
+                          const CalibrationSettings &settings,
+                          int num_threads, CalibrationResult &result,
+                          std::vector<double> &normal,
+                          std::vector<double> &gradient) {
+
+  ZoneScoped; // for tracy
+
+  int num_shots = static_cast<int>(shots.size());
+  int num_tuned = static_cast<int>(tuned.size());
+  int num_residuals = static_cast<int>(residuals.size());
+
+  // Both sides of every tuned parameter in one batch
+  std::vector<PhysicsParameters> candidates(2 * num_tuned, current);
+  std::vector<ShotOutcome> outcomes;
+  float steps[NUM_CALIBRATION_PARAMETERS];
+
+  for (int j = 0; j < num_tuned; j++) {
+
+    int parameter = tuned[j];
+
+    steps[j] = DIFFERENCE_STEP * DEFAULT_PHYSICS_PARAMETERS.values[parameter];
+    candidates[2 * j].values[parameter] += steps[j];
+    candidates[2 * j + 1].values[parameter] -= steps[j];
+
+  }
+
+  simulate_batch(shots, candidates, num_threads, outcomes);
+  result.num_simulations += 2 * num_tuned * num_shots;
+
+  std::vector<double> jacobian(num_residuals * num_tuned);
+  std::vector<double> forward_residuals;
+  std::vector<double> backward_residuals;
+
+  for (int j = 0; j < num_tuned; j++) {
+
+    get_cost(shots, &outcomes[2 * j * num_shots], candidates[2 * j], tuned,
+             settings, result, forward_residuals);
+    get_cost(shots, &outcomes[(2 * j + 1) * num_shots],
+             candidates[2 * j + 1], tuned, settings, result,
+             backward_residuals);
+
+    for (int m = 0; m < num_residuals; m++) {
+      jacobian[m * num_tuned + j] =
+          (forward_residuals[m] - backward_residuals[m]) / (2.0 * steps[j]);
+    }
+
+  }
+
+  normal.assign(num_tuned * num_tuned, 0.0);
+  gradient.assign(num_tuned, 0.0);
+
+  for (int m = 0; m < num_residuals; m++) {
+
+    const double *row = &jacobian[m * num_tuned];
+
+    for (int a = 0; a < num_tuned; a++) {
+
+      gradient[a] += row[a] * residuals[m];
+
+      for (int b = 0; b < num_tuned; b++) {
+        normal[a * num_tuned + b] += row[a] * row[b];
+      }
+
+    }
+
+  }
+
+}
+
+/*
+  Levenberg-Marquardt over the parameters in tuned, from result.parameters,
+  whose outcomes come in best_outcomes. Leaves the fitted parameters and
+  their outcomes there, adds to the iterations and simulations, and puts the
+  last iteration's normal equations in normal.
+*/
+void fit_parameters(const std::vector<MeasuredShot> &shots,
+                    const std::vector<int> &tuned,
+                    const CalibrationSettings &settings, int num_threads,
+                    CalibrationResult &result,
+                    std::vector<ShotOutcome> &best_outcomes,
+                    std::vector<double> &normal) {
+
+  ZoneScoped; // for tracy
+
+  int num_shots = static_cast<int>(shots.size());
+  int num_tuned = static_cast<int>(tuned.size());
+
+  std::vector<PhysicsParameters> candidates;
+  std::vector<ShotOutcome> outcomes;
+
+  std::vector<double> residuals;
+  std::vector<double> candidate_residuals;
+  double cost = get_cost(shots, best_outcomes.data(), result.parameters,
+                         tuned, settings, result, residuals);
+
+  std::vector<double> gradient;
+  std::vector<double> system;
+  std::vector<double> step;
+
+  double damping = INITIAL_DAMPING;
+
+  for (int iteration = 0;
+       iteration < settings.max_iterations && num_tuned > 0 && num_shots > 0;
+       iteration++) {
+
+    result.iterations++;
+
+    const PhysicsParameters &current = result.parameters;
+
+    get_normal_equations(shots, tuned, current, residuals, settings,
+                         num_threads, result, normal, gradient);
+
+    // Several dampings at once, from nearly Gauss-Newton to nearly gradient
+    // descent, so a bad guess at the damping doesn't cost an iteration
+    candidates.assign(NUM_TRIALS, current);
+
+    for (int t = 0; t < NUM_TRIALS; t++) {
+
+      system = normal;
+      step.assign(gradient.begin(), gradient.end());
+
+      double trial_damping = damping * TRIAL_DAMPINGS[t];
+
+      // Scaled by the diagonal, with a floor for parameters the shots
+      // barely constrain
+      for (int a = 0; a < num_tuned; a++) {
+        system[a * num_tuned + a] +=
+            trial_damping * std::max(normal[a * num_tuned + a], 1e-9);
+      }
+
+      solve_linear_system(system, step, num_tuned);
+
+      for (int j = 0; j < num_tuned; j++) {
+
+        int parameter = tuned[j];
+        float value = current.values[parameter]
+                      - static_cast<float>(step[j]);
+
+        candidates[t].values[parameter] = clamp_parameter(value, parameter);
+
+      }
+
+    }
+
+    simulate_batch(shots, candidates, num_threads, outcomes);
+    result.num_simulations += NUM_TRIALS * num_shots;
+
+    int best = -1;
+    double best_cost = cost;
+
+    for (int t = 0; t < NUM_TRIALS; t++) {
+
+      double trial_cost =
+          get_cost(shots, &outcomes[t * num_shots], candidates[t], tuned,
+                   settings, result, candidate_residuals);
+
+      if (trial_cost < best_cost) {
+        best = t;
+        best_cost = trial_cost;
+      }
+
+    }
+
+    // Nothing helped, so back off towards gradient descent
+    if (best < 0) {
+      damping *= TRIAL_DAMPINGS[NUM_TRIALS - 1];
+      continue;
+    }
+
+    double improvement = (cost - best_cost) / cost;
+
+    result.parameters = candidates[best];
+    cost = get_cost(shots, &outcomes[best * num_shots], result.parameters,
+                    tuned, settings, result, residuals);
+    best_outcomes.assign(outcomes.begin() + best * num_shots,
+                         outcomes.begin() + (best + 1) * num_shots);
+
+    // Lean further towards Gauss-Newton while it keeps working
+    damping = std::max(damping * TRIAL_DAMPINGS[best] * 0.3, 1e-9);
+
+    if (improvement < MIN_IMPROVEMENT) {
+      break;
+    }
+
+  }
+
+}
+
+/*
+  The standard deviation of every tuned parameter after the fit, from the
+  diagonal of the inverse of the normal equations. The residuals are over
+  their tolerances, so that's the covariance of the parameters if the
+  tolerances are the observations' real errors. NaN if nothing was fitted.
+*/
+void get_uncertainties(const std::vector<double> &normal,
+                       const std::vector<int> &tuned, float *uncertainties) {
+
+  int num_tuned = static_cast<int>(tuned.size());
+
+  std::vector<double> system;
+  std::vector<double> column;
+
+  for (int j = 0; j < num_tuned; j++) {
+
+    // The jth column of the inverse
+    system = normal;
+    column.assign(num_tuned, 0.0);
+    column[j] = 1.0;
+
+    solve_linear_system(system, column, num_tuned);
+
+    float variance = static_cast<float>(column[j]);
+
+    uncertainties[tuned[j]] = variance > 0.0f
+                                  ? std::sqrt(variance)
+                                  : std::numeric_limits<float>::quiet_NaN();
+
+  }
+
+}
+
+} // namespace
+
+void simulate_shots(Simulation &simulation,
+                    const LaunchConditions<float> *launches, int count,
+                    vec3 position, const PhysicsParameters &parameters,
+                    AeroModelType aero_model,
+                    std::vector<ShotMetrics> &metrics) {
+
+  ZoneScoped; // for tracy
+
+  const int green = static_cast<int>(SurfaceMaterial::GREEN);
+
+  SurfaceTable surfaces = get_surface_table(GroundType::SLOW_GREEN);
+  surfaces.firmness[green] = parameters.get(CalibrationParameter::FIRMNESS);
+  surfaces.friction[green] = parameters.get(CalibrationParameter::FRICTION);
+  surfaces.roll_deceleration[green] = get_roll_deceleration(
+      parameters.get(CalibrationParameter::ROLL_FRICTION));
+
+  simulation.clear_balls();
+  simulation.set_wind(Wind(0.0f, 0.0f, false));
+  simulation.set_air(AirConstants<float>(
+      LIFT_CONST * parameters.get(CalibrationParameter::LIFT_SCALE),
+      DRAG_CONST * parameters.get(CalibrationParameter::DRAG_SCALE), 1.0f));
+  simulation.set_models(IntegratorType::SEMI_IMPLICIT_EULER,
+                        GroundType::SLOW_GREEN, aero_model);
+  simulation.set_spin_decay_rate(
+      parameters.get(CalibrationParameter::SPIN_DECAY_RATE));
+  simulation.set_surface_table(surfaces);
+
+  for (int i = 0; i < count; i++) {
+
+    FlightState<float> state = get_launch_state(launches[i], position);
+    simulation.launch_ball(state.position, state.velocity,
+                           state.rotation_axis, state.launch_spin_rate);
+
+  }
+
+  simulation.run_until_resting(MAX_SHOT_TIME);
+  simulation.get_shot_metrics(metrics);
+
+}
+
+ShotOutcome get_shot_outcome(const ShotMetrics &metrics) {
+
+  ShotOutcome outcome;
+
+  outcome.carry = metrics.carry;
+
+  // A ball still going after MAX_SHOT_TIME, which no real shot is, counts as
+  // stopping where it landed
+  outcome.total = metrics.at_rest ? metrics.total : metrics.carry;
+
+  // The launch monitor's apex is above the ground, which is at height 0
+  outcome.apex = metrics.apex + metrics.launch_position.z;
+
+  return outcome;
+
+}
+
+ShotOutcome simulate_shot(const LaunchConditions<float> &launch,
+                          const PhysicsParameters &parameters) {
+
+  auto simulation = std::make_unique<Simulation>(
+      1.0f / PHYSICS_STEPS_PER_SECOND, Wind(0.0f, 0.0f, false));
+  std::vector<ShotMetrics> metrics;
+
+  simulate_shots(*simulation, &launch, 1, vec3(0.0f, 0.0f, TEE_HEIGHT),
+                 parameters, AeroModelType::TABLE, metrics);
+
+  return get_shot_outcome(metrics[0]);
+
+}
+
+bool load_measured_shots(const char *path, std::vector<MeasuredShot> &shots) {
+
+  std::ifstream file(path);
+
+  if (!file) {
+    return false;
+  }
+
+  std::string line;
+
+  while (std::getline(file, line)) {
+
+    size_t first = line.find_first_not_of(" \t");
+
+    if (first == std::string::npos
+        || !(std::isdigit(static_cast<unsigned char>(line[first]))
+             || line[first] == '.' || line[first] == '-')) {
+      continue;
+    }
+
+    std::stringstream row(line);
+    std::string field;
+    float fields[8];
+    int num_fields = 0;
+
+    while (num_fields < 8 && std::getline(row, field, ',')) {
+      fields[num_fields++] = parse_field(field);
+    }
+
+    for (int i = num_fields; i < 8; i++) {
+      fields[i] = std::numeric_limits<float>::quiet_NaN();
+    }
+
+    for (int i = 0; i < 5; i++) {
+      if (std::isnan(fields[i])) {
+        return false;
+      }
+    }
+
+    MeasuredShot shot;
+
+    shot.launch.speed = mph_to_ms(fields[0]);
+    shot.launch.angle = deg_to_rad(fields[1]);
+    shot.launch.heading = deg_to_rad(fields[2]);
+    shot.launch.spin_rate = fields[3];
+    shot.launch.spin_axis = deg_to_rad(fields[4]);
+
+    // NaNs stay NaNs
+    shot.observed.carry = yd_to_m(fields[5]);
+    shot.observed.total = yd_to_m(fields[6]);
+    shot.observed.apex = ft_to_m(fields[7]);
+
+    shots.push_back(shot);
+
+  }
+
+  return true;
+
+}
+
+CalibrationResult calibrate(const std::vector<MeasuredShot> &shots,
+                            const PhysicsParameters &initial,
+                            const CalibrationSettings &settings) {
+
+  ZoneScoped; // for tracy
+
+  auto start_time = std::chrono::steady_clock::now();
+
+  int num_threads = settings.num_threads;
+
+  if (num_threads <= 0) {
+    num_threads = static_cast<int>(std::thread::hardware_concurrency());
+  }
+
+  CalibrationResult result;
+  result.initial = initial;
+  result.parameters = initial;
+  result.iterations = 0;
+  result.num_simulations = 0;
+  result.num_observations = 0;
+
+  for (const MeasuredShot &shot : shots) {
+    result.num_observations += !std::isnan(shot.observed.carry)
+                               + !std::isnan(shot.observed.total)
+                               + !std::isnan(shot.observed.apex);
+  }
+
+  std::vector<int> tuned;
+
+  for (int i = 0; i < NUM_CALIBRATION_PARAMETERS; i++) {
+
+    result.identified[i] = false;
+    result.uncertainties[i] = std::numeric_limits<float>::quiet_NaN();
+
+    if (settings.tuned[i]) {
+      tuned.push_back(i);
+    }
+
+  }
+
+  int num_shots = static_cast<int>(shots.size());
+
+  std::vector<PhysicsParameters> candidates(1, initial);
+  std::vector<ShotOutcome> outcomes;
+  std::vector<double> residuals;
+
+  simulate_batch(shots, candidates, num_threads, outcomes);
+  result.num_simulations += num_shots;
+
+  result.initial_rms = static_cast<float>(
+      std::sqrt(get_residuals(shots, outcomes.data(), settings, residuals)
+                / std::max(result.num_observations, 1)));
+
+  // Whether the shots can tell a parameter apart from its prior is judged
+  // at the initial values, before the fit. Far along a trade-off with the
+  // others, where the noise can take it, the shots may well be a lot more
+  // sensitive to it than anywhere near where it really is.
+  std::vector<double> normal;
+  std::vector<double> gradient;
+  std::vector<int> identified;
+
+  if (num_shots > 0 && !tuned.empty()) {
+
+    get_cost(shots, outcomes.data(), initial, tuned, settings, result,
+             residuals);
+    get_normal_equations(shots, tuned, initial, residuals, settings,
+                         num_threads, result, normal, gradient);
+    get_uncertainties(normal, tuned, result.uncertainties);
+
+  }
+
+  for (int parameter : tuned) {
+
+    // The rest keep their initial values
+    if (result.uncertainties[parameter]
+        < MAX_UNCERTAINTY_FRACTION * get_prior_spread(parameter, settings)) {
+      identified.push_back(parameter);
+      result.identified[parameter] = true;
+    }
+
+  }
+
+  fit_parameters(shots, identified, settings, num_threads, result, outcomes,
+                 normal);
+
+  if (result.iterations > 0) {
+    get_uncertainties(normal, identified, result.uncertainties);
+  }
+
+  result.rms = static_cast<float>(
+      std::sqrt(get_residuals(shots, outcomes.data(), settings, residuals)
+                / std::max(result.num_observations, 1)));
+
+  float errors[NUM_OUTCOMES];
+  get_outcome_errors(shots, outcomes.data(), errors);
+
+  result.carry_rms = errors[0];
+  result.total_rms = errors[1];
+  result.apex_rms = errors[2];
+
+  result.time_ms = std::chrono::duration<float, std::milli>(
+                       std::chrono::steady_clock::now() - start_time)
+                       .count();
+
+  return result;
+
+}
+
+bool write_calibration(const char *path, const CalibrationResult &result,
+                       const CalibrationSettings &settings) {
+
+  std::ofstream file(path);
+
+  if (!file) {
+    return false;
+  }
+
+  char line[128];
+
+  std::snprintf(line, sizeof(line),
+                "# %d observations, %d iterations, rms %.3f -> %.3f\n",
+                result.num_observations, result.iterations,
+                result.initial_rms, result.rms);
+  file << line;
+
+  std::snprintf(line, sizeof(line),
+                "# rms error carry %.2f m, total %.2f m, apex %.2f m\n",
+                result.carry_rms, result.total_rms, result.apex_rms);
+  file << line;
+
+  for (int i = 0; i < NUM_CALIBRATION_PARAMETERS; i++) {
+
+    const char *name = CALIBRATION_PARAMETER_NAMES[i];
+    float value = result.parameters.values[i];
+
+    if (!settings.tuned[i]) {
+      std::snprintf(line, sizeof(line), "%s = %.8g # fixed\n", name, value);
+    } else if (!result.identified[i]) {
+      std::snprintf(line, sizeof(line),
+                    "%s = %.8g # not identified by the shots\n", name,
+                    value);
+    } else {
+      std::snprintf(line, sizeof(line), "%s = %.8g # +- %.2g\n", name,
+                    value, result.uncertainties[i]);
+    }
+
+    file << line;
+
+  }
+
+  return static_cast<bool>(file);
+
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "constants.h"
+#include "launch.h"
+#include "metrics.h"
+#include "models.h"
+#include <cstdint>
+#include <vector>
+
+class Simulation;
+
+/*
+  Calibration against launch monitor data. Given shots with their measured
+  launch and their observed carry, total distance and apex, finds the physics
+  parameters that make the simulation land them where they really landed.
+
+  Every shot is flown from a tee on level green in calm air at the reference
+  conditions, the way a launch monitor session on a range is. The shots go
+  through a headless Simulation, so they fly, bounce and roll through the
+  same kernels as the simulation's balls (see stepper.h), with the
+  parameters in place of the air, spin decay and green it would otherwise
+  use. The coefficient table's shape is kept and tuned through an overall
+  scale on drag and on lift, since the shots can't pin down 140 entries on
+  their own.
+
+  The fit is Levenberg-Marquardt over whichever parameters are chosen, on the
+  residuals of every observation over its tolerance, with a weak prior
+  holding each parameter near its initial value. Carries, totals and apexes
+  can't tell every parameter apart, the bounce and roll ones especially, and
+  without the prior those would wander off along whatever trade-off fits the
+  noise best. Before the fit, any parameter the shots would barely narrow
+  down from its prior is left at its initial value, and only the rest are
+  fitted.
+
+  Each iteration flies all the shots once per central difference of every
+  parameter, then once per trial damping, and each of those sets of
+  candidates goes out as one batch of (candidate, shot) pairs spread over
+  every core.
+*/
+
+enum class CalibrationParameter : uint8_t {
+  DRAG_SCALE,
+  LIFT_SCALE,
+  SPIN_DECAY_RATE,
+  FIRMNESS,
+  FRICTION,
+  ROLL_FRICTION,
+  NUM_PARAMETERS
+};
+
+const int NUM_CALIBRATION_PARAMETERS =
+    static_cast<int>(CalibrationParameter::NUM_PARAMETERS);
+
+// As written by write_calibration()
+extern const char *const CALIBRATION_PARAMETER_NAMES
+    [NUM_CALIBRATION_PARAMETERS];
+
+struct PhysicsParameters {
+
+  // By CalibrationParameter: the scales on DRAG_CONST and LIFT_CONST, then
+  // SPIN_DECAY_RATE, GROUND_FIRMNESS, FRICTION and FRICTION_ROLL on the
+  // green (see constants.h)
+  float values[NUM_CALIBRATION_PARAMETERS];
+
+  float get(CalibrationParameter parameter) const {
+    return values[static_cast<int>(parameter)];
+  }
+
+};
+
+// The simulation's own values
+constexpr PhysicsParameters DEFAULT_PHYSICS_PARAMETERS = {
+    {1.0f, 1.0f, SPIN_DECAY_RATE, GROUND_FIRMNESS, FRICTION, FRICTION_ROLL}};
+
+// In meters. Anything the launch monitor didn't measure is NaN and left out
+// of the fit.
+struct ShotOutcome {
+
+  float carry;
+  float total;
+  float apex;
+
+};
+
+struct MeasuredShot {
+
+  LaunchConditions<float> launch;
+  ShotOutcome observed;
+
+};
+
+/*
+  Flies, bounces and rolls count shots from position (its height is above the
+  ground) through simulation, which has to be headless, with the given
+  parameters and either aerodynamic model. The simulation is cleared first
+  and keeps its terrain and surface map, which are level green unless they've
+  been set. Its commands go through a fixed size queue, so count should stay
+  in the hundreds. metrics gets every shot's, in order.
+*/
+void simulate_shots(Simulation &simulation,
+                    const LaunchConditions<float> *launches, int count,
+                    vec3 position, const PhysicsParameters &parameters,
+                    AeroModelType aero_model,
+                    std::vector<ShotMetrics> &metrics);
+
+// What a launch monitor would have measured of a shot
+ShotOutcome get_shot_outcome(const ShotMetrics &metrics);
+
+// Flies, bounces and rolls a single shot from a tee with the given
+// parameters, in a simulation of its own
+ShotOutcome simulate_shot(const LaunchConditions<float> &launch,
+                          const PhysicsParameters &parameters);
+
+/*
+  Reads shots from a CSV file with a row per shot, in launch monitor units:
+
+    ball speed (mph), launch angle (degrees), launch direction (degrees,
+    positive right), spin rate (rpm), spin axis (degrees), carry (yd),
+    total (yd), apex (ft)
+
+  Lines that don't start with a number, like a header, are skipped, and any
+  of the last three fields can be left empty. Returns false if the file
+  can't be read or a row is missing part of its launch.
+*/
+bool load_measured_shots(const char *path, std::vector<MeasuredShot> &shots);
+
+struct CalibrationSettings {
+
+  // Which parameters to fit. The rest keep their initial values.
+  bool tuned[NUM_CALIBRATION_PARAMETERS] = {true, true, true,
+                                            true, true, true};
+
+  // How closely each observation is expected to match, in meters. Residuals
+  // are divided by these, so a launch monitor's noisier totals count for
+  // less than its carries.
+  float carry_tolerance = 1.0f;
+  float total_tolerance = 2.5f;
+  float apex_tolerance = 1.0f;
+
+  // The spread of each parameter's prior, around its initial value, as a
+  // fraction of its default
+  float prior_spread[NUM_CALIBRATION_PARAMETERS] = {0.5f, 0.5f, 0.5f,
+                                                    0.5f, 0.5f, 0.5f};
+
+  int max_iterations = 30;
+
+  // One per core if it's 0
+  int num_threads = 0;
+
+};
+
+struct CalibrationResult {
+
+  PhysicsParameters initial;
+  PhysicsParameters parameters;
+
+  // Whether the shots, around the initial values, narrow each tuned
+  // parameter down to less than a quarter of its prior's spread. Those they
+  // don't keep their initial values.
+  bool identified[NUM_CALIBRATION_PARAMETERS];
+
+  // The standard deviation of each tuned parameter after the fit, or around
+  // the initial values for those that weren't identified, if the tolerances
+  // are the observations' real errors
+  float uncertainties[NUM_CALIBRATION_PARAMETERS];
+
+  // Root mean square of the residuals over their tolerances, before and
+  // after
+  float initial_rms;
+  float rms;
+
+  // Root mean square errors after, in meters
+  float carry_rms;
+  float total_rms;
+  float apex_rms;
+
+  int num_observations;
+  int iterations;
+
+  // Shots flown, over every candidate
+  int num_simulations;
+
+  float time_ms;
+
+};
+
+CalibrationResult calibrate(const std::vector<MeasuredShot> &shots,
+                            const PhysicsParameters &initial,
+                            const CalibrationSettings &settings);
+
+// Writes the parameters as "name = value" lines, with the fit's statistics
+// and each parameter's uncertainty, or why it wasn't fitted, in comments.
+// Returns false if the file can't be written.
+bool write_calibration(const char *path, const CalibrationResult &result,
+                       const CalibrationSettings &settings);
@@ -1,7 +1,87 @@
 #pragma once
 
+#include "../math/generic.h"
+#include <type_traits>
 #include <utility>
 
-std::pair<float, float> get_drag_and_lift_coefficients(float air_speed_squared,
-                                                       float spin_rate);
-float get_coefficient_of_restitution(float velocity_along_normal);
\ No newline at end of file
+/*
+  Coefficient lookups, templated on the scalar type (float, double or a SIMD
+  vector; see math/generic.h) so the same model runs at every precision and
+  width.
+*/
+
+// Drag and lift coefficients by air speed band (rows) and spin rate band
+// (columns)
+extern const float DRAG_AND_LIFT_COEFFICIENTS_ARR[10][7][2];
+
+// Lower edges of the bands above the first. We use the square of the air
+// speed so we don't have to take the square root of the air speed vec to
+// find the magnitude.
+constexpr float AIR_SPEED_SQUARED_BANDS[9] = {
+    338.0f, 705.0f, 1226.0f, 1874.0f, 2654.0f,
+    3588.0f, 4698.0f, 5939.0f, 7249.0f};
+constexpr float SPIN_RATE_BANDS[6] = {
+    500.0f, 1433.0f, 2340.0f, 3283.0f, 4223.0f, 5478.0f};
+
+template <typename T>
+MATH_INLINE std::pair<T, T>
+get_drag_and_lift_coefficients(T air_speed_squared, T spin_rate) {
+
+  const float *coefficients = &DRAG_AND_LIFT_COEFFICIENTS_ARR[0][0][0];
+
+  // The bands are sorted, so the row and column are the number of band edges
+  // the value is above. A scalar walks down from the top band, like the
+  // original chain of ifs, which is cheaper than testing every edge.
+  if constexpr (std::is_floating_point_v<T>) {
+
+    int row = 9;
+    int col = 6;
+
+    while (row > 0 && !(air_speed_squared > AIR_SPEED_SQUARED_BANDS[row - 1])) {
+      row--;
+    }
+
+    while (col > 0 && !(spin_rate > SPIN_RATE_BANDS[col - 1])) {
+      col--;
+    }
+
+    int index = (row * 7 + col) * 2;
+
+    return std::make_pair(T(coefficients[index]), T(coefficients[index + 1]));
+
+  }
+
+  // A vector tests every edge and counts with masks, then looks the lanes up
+  // one by one
+  const T zero(0.0f);
+  const T one(1.0f);
+
+  T row = zero;
+  T col = zero;
+
+  for (float band : AIR_SPEED_SQUARED_BANDS) {
+    row = row + select(air_speed_squared > T(band), one, zero);
+  }
+
+  for (float band : SPIN_RATE_BANDS) {
+    col = col + select(spin_rate > T(band), one, zero);
+  }
+
+  T index = (row * T(7.0f) + col) * T(2.0f);
+
+  T drag_coefficient = gather(coefficients, index);
+  T lift_coefficient = gather(coefficients + 1, index);
+
+  return std::make_pair(drag_coefficient, lift_coefficient);
+
+}
+
+template <typename T>
+T get_coefficient_of_restitution(T velocity_along_normal) {
+
+  T v = velocity_along_normal;
+  T restitution = T(0.51f) - (T(0.0375f) * v) + (T(0.000903f) * (v * v));
+
+  return select(v <= T(20.0f), restitution, T(0.12f));
+
+}
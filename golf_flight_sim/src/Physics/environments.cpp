@@ -0,0 +1,180 @@
+#include "environments.h"
+#include "../math/simd.h"
+#include "../tracy/tracy/Tracy.hpp"
+#include "flight.h"
+#include <algorithm>
+
+namespace {
+
+// Long enough for any real shot, as for get_landing()
+const float MAX_FLIGHT_TIME = 30.0f; // in seconds
+
+/*
+  Flies one shot through up to float8::LANES environments, from
+  environments[0] on, and writes count landings. Lanes past count repeat the
+  last environment so their arithmetic stays finite.
+*/
+template <typename WindModel, typename Integrator>
+void fly_shot_lanes(const LaunchConditions<float> &shot,
+                    const AirConstants<float> *environments, int count,
+                    vec3 position, vec3 wind_velocity, float timestep,
+                    Landing *landings) {
+
+  const int lanes = float8::LANES;
+
+  float lift_const[lanes];
+  float drag_const[lanes];
+  float speed_squared_scale[lanes];
+
+  for (int i = 0; i < lanes; i++) {
+
+    const AirConstants<float> &air = environments[std::min(i, count - 1)];
+    lift_const[i] = air.lift_const;
+    drag_const[i] = air.drag_const;
+    speed_squared_scale[i] = air.speed_squared_scale;
+
+  }
+
+  const AirConstants<float8> air(float8::load(lift_const),
+                                 float8::load(drag_const),
+                                 float8::load(speed_squared_scale));
+
+  // The launch is the same in every lane
+  FlightState<float> launch = get_launch_state(shot, position);
+
+  FlightState<float8> state;
+  state.position = vec3_t<float8>(launch.position);
+  state.velocity = vec3_t<float8>(launch.velocity);
+  state.acceleration = vec3_t<float8>();
+  state.rotation_axis = vec3_t<float8>(launch.rotation_axis);
+  state.launch_spin_rate = float8(launch.launch_spin_rate);
+  state.elapsed_time = float8(launch.elapsed_time);
+
+  FlightState<float8> previous = state;
+
+  const vec3_t<float8> wind(wind_velocity);
+  const float8 dt(timestep);
+  const float8 zero(0.0f);
+
+  int max_steps = static_cast<int>(MAX_FLIGHT_TIME / timestep);
+
+  // The ball starts above the ground, so the first step always happens
+  step_flight_state<WindModel, Integrator>(state, wind, air, dt);
+
+  for (int i = 1; i < max_steps; i++) {
+
+    auto in_flight = state.position.z > zero;
+
+    if (!any(in_flight)) {
+      break;
+    }
+
+    FlightState<float8> next = state;
+    step_flight_state<WindModel, Integrator>(next, wind, air, dt);
+
+    // Landed lanes keep the steps either side of the ground
+    previous.position = select(in_flight, state.position, previous.position);
+    previous.elapsed_time =
+        select(in_flight, state.elapsed_time, previous.elapsed_time);
+    state.position = select(in_flight, next.position, state.position);
+    state.velocity = select(in_flight, next.velocity, state.velocity);
+    state.elapsed_time =
+        select(in_flight, next.elapsed_time, state.elapsed_time);
+
+  }
+
+  // Fraction of the last step taken before the ball reached the ground, or
+  // all of it for a ball still in the air
+  float8 fraction = select(state.position.z > zero, float8(1.0f),
+                           previous.position.z
+                               / (previous.position.z - state.position.z));
+
+  vec3_t<float8> landing_position =
+      previous.position + (state.position - previous.position) * fraction;
+  float8 flight_time = previous.elapsed_time + dt * fraction;
+
+  float x[lanes];
+  float y[lanes];
+  float z[lanes];
+  float time[lanes];
+
+  landing_position.x.store(x);
+  landing_position.y.store(y);
+  landing_position.z.store(z);
+  flight_time.store(time);
+
+  for (int i = 0; i < count; i++) {
+
+    float dx = x[i] - position.x;
+    float dy = y[i] - position.y;
+
+    Landing &landing = landings[i];
+    landing.position = vec3(x[i], y[i], z[i]);
+    landing.carry = std::sqrt(dx * dx + dy * dy);
+
+    // The world y axis points left of the target line
+    landing.offline = -dy;
+    landing.flight_time = time[i];
+
+  }
+
+}
+
+template <typename WindModel, typename Integrator>
+void fly_across(const std::vector<LaunchConditions<float>> &shots,
+                const std::vector<AirConstants<float>> &environments,
+                vec3 position, vec3 wind_velocity, float timestep,
+                Landing *landings) {
+
+  const int num_environments = static_cast<int>(environments.size());
+
+  for (size_t shot = 0; shot < shots.size(); shot++) {
+    for (int first = 0; first < num_environments; first += float8::LANES) {
+
+      int count = std::min(float8::LANES, num_environments - first);
+
+      fly_shot_lanes<WindModel, Integrator>(
+          shots[shot], &environments[first], count, position, wind_velocity,
+          timestep, &landings[shot * num_environments + first]);
+
+    }
+  }
+
+}
+
+using SweepFunction = void (*)(const std::vector<LaunchConditions<float>> &,
+                               const std::vector<AirConstants<float>> &, vec3,
+                               vec3, float, Landing *);
+
+// Indexed by the policy enums in the order they're declared in models.h
+const SweepFunction
+    SWEEP_FUNCTIONS[NUM_WIND_MODEL_TYPES][NUM_INTEGRATOR_TYPES] = {
+        {fly_across<UniformWind, SemiImplicitEuler>,
+         fly_across<UniformWind, Midpoint>},
+        {fly_across<LogWind, SemiImplicitEuler>,
+         fly_across<LogWind, Midpoint>}};
+
+} // namespace
+
+std::vector<Landing>
+fly_across_environments(const std::vector<LaunchConditions<float>> &shots,
+                        const std::vector<AirConstants<float>> &environments,
+                        vec3 position, vec3 wind_velocity,
+                        WindModelType wind_model, IntegratorType integrator,
+                        float timestep) {
+
+  ZoneScoped; // for tracy
+
+  std::vector<Landing> landings(shots.size() * environments.size());
+
+  if (landings.empty()) {
+    return landings;
+  }
+
+  SWEEP_FUNCTIONS[static_cast<int>(wind_model)][static_cast<int>(integrator)](
+      shots, environments, position, wind_velocity, timestep,
+      landings.data());
+
+  return landings;
+
+}
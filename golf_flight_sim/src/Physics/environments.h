@@ -0,0 +1,31 @@
+#pragma once
+
+#include "../math/vec3.h"
+#include "atmosphere.h"
+#include "launch.h"
+#include "models.h"
+#include "sensitivity.h"
+#include <vector>
+
+/*
+  Environment sweeps. Flies the same set of shots through many environments
+  (sites, seasons, weather) at once, for comparing how far a shot carries at
+  altitude and at the coast, or on a cold morning and a hot afternoon.
+
+  Every environment's air is folded into its AirConstants before any ball
+  moves, and each vector lane holds one environment, so a float8 flies a
+  shot through eight environments in one pass with no per-lane branching.
+  A shot lands at about the same time in every environment, so the lanes
+  finish together.
+*/
+
+// Landings of every shot in every environment, in
+// landings[shot * environments.size() + environment]. Each landing is
+// interpolated between the steps either side of the ground, like
+// get_landing().
+std::vector<Landing>
+fly_across_environments(const std::vector<LaunchConditions<float>> &shots,
+                        const std::vector<AirConstants<float>> &environments,
+                        vec3 position, vec3 wind_velocity,
+                        WindModelType wind_model, IntegratorType integrator,
+                        float timestep);
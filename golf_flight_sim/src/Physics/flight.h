@@ -0,0 +1,149 @@
+#pragma once
+
+#include "../math/generic.h"
+#include "constants.h"
+#include "force.h"
+#include "models.h"
+#include <cmath>
+#include <utility>
+
+/*
+  The flight model, written once over the scalar type T: float, double or one
+  of the SIMD vectors, where every lane is a separate ball (see
+  math/generic.h).
+
+  The simulation's flight kernel runs the float version on its Balls. The
+  double version gives a reference to check float runs against, and the
+  vector versions fly a whole batch of balls at once. All of them share the
+  force functions, coefficient lookups, wind models and integrators.
+*/
+
+// The part of a ball's state that flight needs
+template <typename T> struct FlightState {
+
+  vec3_t<T> position;
+  vec3_t<T> velocity;
+  vec3_t<T> acceleration;
+  vec3_t<T> rotation_axis;
+
+  T launch_spin_rate;
+  T elapsed_time;
+
+};
+
+template <typename T> struct FlightForces {
+
+  // Wind velocity at the ball's height
+  vec3_t<T> wind_velocity;
+
+  vec3_t<T> lift_force;
+  vec3_t<T> drag_force;
+
+  vec3_t<T> get_sum() const {
+    return lift_force + drag_force + vec3_t<T>(BALL_WEIGHT);
+  }
+
+};
+
+template <typename T> T get_spin_rate(T launch_spin_rate, T time) {
+
+  using std::exp;
+
+  return launch_spin_rate * exp(-(time / T(SPIN_DECAY_RATE)));
+
+}
+
+// Forces on a ball in flight. wind_velocity is the wind at the reference
+// height, which WindModel adjusts for the ball's height, and air holds the
+// constants for the air it's flying through (see atmosphere.h). AeroModel
+// gives the drag and lift coefficients.
+template <typename WindModel, typename AeroModel = TableAero, typename T>
+MATH_INLINE FlightForces<T>
+get_flight_forces(vec3_t<T> position, vec3_t<T> velocity,
+                  vec3_t<T> rotation_axis, T spin_rate,
+                  vec3_t<T> wind_velocity, const AirConstants<T> &air) {
+
+  FlightForces<T> forces;
+
+  forces.wind_velocity =
+      WindModel::template get_velocity<T>(wind_velocity, position.z);
+
+  // The ball's effective velocity, or "air speed" vector is determined by
+  // taking the difference between the instantaneous velocity vector and the
+  // wind vector.
+  vec3_t<T> air_speed = velocity - forces.wind_velocity;
+
+  // The coefficients of lift and drag are determined by the ball's speed and
+  // spin rate. We take the square of the velocity vector here since we don't
+  // need to to get the raw speed, which would involve an expensive sqrt
+  // function.
+  T air_speed_squared = air_speed.dot(air_speed);
+  std::pair<T, T> coefficients =
+      AeroModel::get_coefficients(air_speed_squared, spin_rate, air);
+
+  T drag_coefficient = coefficients.first;
+  T lift_coefficient = coefficients.second;
+
+  forces.lift_force = get_lift_force(air_speed, rotation_axis,
+                                     lift_coefficient, air.lift_const);
+  forces.drag_force =
+      get_drag_force(air_speed, drag_coefficient, air.drag_const);
+
+  return forces;
+
+}
+
+template <typename WindModel, typename Integrator,
+          typename AeroModel = TableAero, typename T>
+void step_flight_state(FlightState<T> &state, vec3_t<T> wind_velocity,
+                       const AirConstants<T> &air, T dt) {
+
+  T spin_rate = get_spin_rate(state.launch_spin_rate, state.elapsed_time);
+
+  auto get_sum_forces = [&](vec3_t<T> position, vec3_t<T> velocity) {
+    return get_flight_forces<WindModel, AeroModel>(
+               position, velocity, state.rotation_axis, spin_rate,
+               wind_velocity, air)
+        .get_sum();
+  };
+
+  Integrator::integrate(state, dt, get_sum_forces);
+
+  state.elapsed_time = state.elapsed_time + dt;
+
+}
+
+// Flies the ball (every lane, for the vectors) from its launch until it
+// reaches the ground, and leaves it where it landed. Lanes that land early
+// stay put while the rest finish. Gives up after max_steps.
+template <typename WindModel, typename Integrator,
+          typename AeroModel = TableAero, typename T>
+void fly_to_landing(FlightState<T> &state, vec3_t<T> wind_velocity,
+                    const AirConstants<T> &air, T dt, int max_steps) {
+
+  // The ball starts on the ground, so the first step always happens
+  step_flight_state<WindModel, Integrator, AeroModel>(state, wind_velocity,
+                                                      air, dt);
+
+  for (int i = 1; i < max_steps; i++) {
+
+    auto in_flight = state.position.z > T(0.0f);
+
+    if (!any(in_flight)) {
+      break;
+    }
+
+    FlightState<T> next = state;
+    step_flight_state<WindModel, Integrator, AeroModel>(next, wind_velocity,
+                                                        air, dt);
+
+    state.position = select(in_flight, next.position, state.position);
+    state.velocity = select(in_flight, next.velocity, state.velocity);
+    state.acceleration =
+        select(in_flight, next.acceleration, state.acceleration);
+    state.elapsed_time =
+        select(in_flight, next.elapsed_time, state.elapsed_time);
+
+  }
+
+}
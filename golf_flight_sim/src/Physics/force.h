@@ -1,10 +1,59 @@
 #pragma once
 
-#include "../Components/Wind.h"
-#include "../math/vec3.h"
-#include <memory>
-
-vec3 get_wind_force(std::unique_ptr<Wind> &wind, float ball_height);
-vec3 get_lift_force(vec3 velocity, vec3 rotation_axis, float lift_coefficient);
-vec3 get_drag_force(vec3 velocity, float drag_coefficient);
-vec3 get_friction_force(vec3 velocity);
\ No newline at end of file
+#include "../math/generic.h"
+#include "atmosphere.h"
+#include "constants.h"
+#include <cmath>
+
+/*
+  Force functions, templated on the scalar type (float, double or a SIMD
+  vector; see math/generic.h) so the same model runs at every precision and
+  width. The float versions take and return plain vec3s. They run in every
+  integrator stage, so they're force inlined like the vec3 operators.
+
+  The wind is the wind models' (UniformWind and LogWind in models.h).
+*/
+
+// lift_const and drag_const are LIFT_CONST and DRAG_CONST in the air the
+// ball is flying through (see AirConstants)
+template <typename T>
+MATH_INLINE vec3_t<T> get_lift_force(vec3_t<T> velocity,
+                                     vec3_t<T> rotation_axis,
+                                     T lift_coefficient, T lift_const) {
+
+  vec3_t<T> lift_force = rotation_axis.cross(velocity)
+                         * (lift_const * lift_coefficient
+                            * norm(rotation_axis.cross(velocity)));
+
+  return lift_force;
+
+}
+
+template <typename T>
+MATH_INLINE vec3_t<T> get_drag_force(vec3_t<T> velocity, T drag_coefficient,
+                                     T drag_const) {
+
+  vec3_t<T> drag_force =
+      velocity * (drag_const * drag_coefficient * norm(velocity));
+
+  return drag_force;
+
+}
+
+// T can't be deduced from a vec3_t<T>, so call as get_friction_force<T>(v).
+// A ball that isn't moving gets no friction. The magnitude is that of
+// FRICTION_ROLL on level ground unless it's given.
+template <typename T>
+vec3_t<T> get_friction_force(vec3_t<T> velocity,
+                             T friction_magnitude =
+                                 T((5.0f / 7.0f) * FRICTION_ROLL
+                                   * BALL_WEIGHT_MAGNITUDE)) {
+
+  T speed = norm(velocity);
+
+  vec3_t<T> friction =
+      velocity * select(speed > T(0.0f), -friction_magnitude / speed, T(0.0f));
+
+  return friction;
+
+}
@@ -0,0 +1,277 @@
+#include "impact.h"
+#include "../math/generic.h"
+#include "../math/simd_math.h"
+#include "../tracy/tracy/Tracy.hpp"
+#include "coefficients.h"
+#include "constants.h"
+#include "models.h"
+
+void ImpactBatch::clear() {
+
+  count = 0;
+
+  // clear() keeps the capacity, so a batch that's reused every step stops
+  // allocating once it has seen the largest number of simultaneous impacts.
+  velocity_x.clear();
+  velocity_y.clear();
+  velocity_z.clear();
+  rotation_axis_x.clear();
+  rotation_axis_y.clear();
+  rotation_axis_z.clear();
+  spin_rate.clear();
+  normal_x.clear();
+  normal_y.clear();
+  normal_z.clear();
+  material.clear();
+
+}
+
+void ImpactBatch::add(vec3 velocity, vec3 rotation_axis, float spin_rate,
+                      vec3 normal, SurfaceMaterial material) {
+
+  velocity_x.push_back(velocity.x);
+  velocity_y.push_back(velocity.y);
+  velocity_z.push_back(velocity.z);
+  rotation_axis_x.push_back(rotation_axis.x);
+  rotation_axis_y.push_back(rotation_axis.y);
+  rotation_axis_z.push_back(rotation_axis.z);
+  this->spin_rate.push_back(spin_rate);
+  normal_x.push_back(normal.x);
+  normal_y.push_back(normal.y);
+  normal_z.push_back(normal.z);
+  this->material.push_back(static_cast<float>(material));
+
+  count++;
+
+}
+
+vec3 ImpactBatch::get_velocity(int i) const {
+  return vec3(velocity_x[i], velocity_y[i], velocity_z[i]);
+}
+
+vec3 ImpactBatch::get_rotation_axis(int i) const {
+  return vec3(rotation_axis_x[i], rotation_axis_y[i], rotation_axis_z[i]);
+}
+
+// Pads the arrays up to a whole number of SIMD lanes with a ball that's
+// moving and spinning onto level ground, so the padding lanes don't produce
+// NaNs.
+static void pad_to_lanes(ImpactBatch &batch) {
+
+  int padded_count = (batch.count + float4::LANES - 1) / float4::LANES
+                     * float4::LANES;
+
+  batch.velocity_x.resize(padded_count, 1.0f);
+  batch.velocity_y.resize(padded_count, 0.0f);
+  batch.velocity_z.resize(padded_count, -1.0f);
+  batch.rotation_axis_x.resize(padded_count, 0.0f);
+  batch.rotation_axis_y.resize(padded_count, 1.0f);
+  batch.rotation_axis_z.resize(padded_count, 0.0f);
+  batch.spin_rate.resize(padded_count, 1.0f);
+  batch.normal_x.resize(padded_count, 0.0f);
+  batch.normal_y.resize(padded_count, 0.0f);
+  batch.normal_z.resize(padded_count, 1.0f);
+  batch.material.resize(padded_count, 0.0f);
+
+}
+
+void resolve_impacts(ImpactBatch &batch, const SurfaceTable &surfaces) {
+
+  ZoneScoped; // for tracy
+
+  if (batch.count == 0) {
+    return;
+  }
+
+  pad_to_lanes(batch);
+
+  const float4 one(1.0f);
+  const float4 radius(RADIUS);
+  const float4 two_radius(2.0f * RADIUS);
+  const float4 rpm_to_rad_s(0.10471975511965977f);
+  const float4 rad_s_to_rpm(9.549296585513720146f);
+
+  // Keeps a ball landing perfectly vertically from dividing by zero when
+  // building the ground frame.
+  const float4 min_horizontal_speed(1e-6f);
+
+  for (int i = 0; i < batch.count; i += float4::LANES) {
+
+    float4 velocity_x = float4::load(&batch.velocity_x[i]);
+    float4 velocity_y = float4::load(&batch.velocity_y[i]);
+    float4 velocity_z = float4::load(&batch.velocity_z[i]);
+    float4 axis_x = float4::load(&batch.rotation_axis_x[i]);
+    float4 axis_y = float4::load(&batch.rotation_axis_y[i]);
+    float4 axis_z = float4::load(&batch.rotation_axis_z[i]);
+    float4 spin = float4::load(&batch.spin_rate[i]) * rpm_to_rad_s;
+    float4 normal_x = float4::load(&batch.normal_x[i]);
+    float4 normal_y = float4::load(&batch.normal_y[i]);
+    float4 normal_z = float4::load(&batch.normal_z[i]);
+
+    // The coefficients of the material each ball lands on
+    float4 material = float4::load(&batch.material[i]);
+    float4 restitution_scale = gather(surfaces.restitution, material);
+    float4 firmness = gather(surfaces.firmness, material);
+    float4 friction = gather(surfaces.friction, material);
+    float4 spin_slide_factor = (float4(5.0f) * friction) / two_radius;
+
+    /*
+      Ground frame of reference: the y unit vector is the ground normal n,
+      the x unit vector points along the part of the velocity tangent to the
+      ground and the z unit vector is x cross y:
+
+            x_unit = (v - (v . n) n) / h
+            z_unit = x_unit x n
+
+      where h is the tangential speed, so the velocity in the ground frame is
+      simply (h, v . n, 0). On level ground, n = (0, 0, 1), these are the
+      horizontal speed and vz.
+    */
+    float4 normal_speed =
+        velocity_x * normal_x + velocity_y * normal_y + velocity_z * normal_z;
+    float4 tangent_x = velocity_x - normal_x * normal_speed;
+    float4 tangent_y = velocity_y - normal_y * normal_speed;
+    float4 tangent_z = velocity_z - normal_z * normal_speed;
+
+    float4 horizontal_speed =
+        max(sqrt(tangent_x * tangent_x + tangent_y * tangent_y
+                 + tangent_z * tangent_z),
+            min_horizontal_speed);
+    float4 inv_horizontal_speed = one / horizontal_speed;
+    float4 x_unit_x = tangent_x * inv_horizontal_speed;
+    float4 x_unit_y = tangent_y * inv_horizontal_speed;
+    float4 x_unit_z = tangent_z * inv_horizontal_speed;
+
+    float4 z_unit_x = x_unit_y * normal_z - x_unit_z * normal_y;
+    float4 z_unit_y = x_unit_z * normal_x - x_unit_x * normal_z;
+    float4 z_unit_z = x_unit_x * normal_y - x_unit_y * normal_x;
+
+    float4 velocity_ground_x = horizontal_speed;
+    float4 velocity_ground_y = normal_speed;
+
+    float4 angular_velocity_ground_x =
+        spin * (axis_x * x_unit_x + axis_y * x_unit_y + axis_z * x_unit_z);
+    float4 angular_velocity_ground_y =
+        spin * (axis_x * normal_x + axis_y * normal_y + axis_z * normal_z);
+    float4 angular_velocity_ground_z =
+        spin * (axis_x * z_unit_x + axis_y * z_unit_y + axis_z * z_unit_z);
+
+    /*
+      theta_c is proportional to the speed and to the impact angle measured
+      from whichever ground axis the velocity is closest to, which is the
+      arctangent of the smaller speed component over the larger one.
+    */
+    float4 ball_speed = sqrt(horizontal_speed * horizontal_speed
+                             + normal_speed * normal_speed);
+    float4 ball_x_speed_ground = horizontal_speed;
+    float4 ball_y_speed_ground = abs(normal_speed);
+
+    float4 theta_c =
+        firmness * ball_speed
+        * simd_atan(min(ball_x_speed_ground, ball_y_speed_ground)
+                    / max(ball_x_speed_ground, ball_y_speed_ground));
+
+    float4 sin_theta_c;
+    float4 cos_theta_c;
+    simd_sincos(theta_c, sin_theta_c, cos_theta_c);
+
+    // Transform into the x'-y' frame, inclined at theta_c to the ground
+    float4 velocity_ground_x_transformed =
+        velocity_ground_x * cos_theta_c + velocity_ground_y * sin_theta_c;
+    float4 velocity_ground_y_transformed =
+        velocity_ground_y * cos_theta_c - velocity_ground_x * sin_theta_c;
+
+    float4 normal_force_transformed = abs(velocity_ground_y_transformed);
+    float4 restitution =
+        get_coefficient_of_restitution(normal_force_transformed)
+        * restitution_scale;
+    float4 normal_impulse = normal_force_transformed * (one + restitution);
+
+    // Critical coefficients of friction for the x'-y' and z-y' planes. Above
+    // them the ball rolls through the impact instead of sliding.
+    float4 denominator = velocity_ground_y_transformed * (one + restitution);
+    float4 mu_cz = float4(-2.0f / 7.0f)
+                   * (velocity_ground_x_transformed
+                      + radius * angular_velocity_ground_z)
+                   / denominator;
+    float4 mu_cx = float4(2.0f / 7.0f) * (radius * angular_velocity_ground_x)
+                   / denominator;
+
+    float4 slides_z = friction < mu_cz;
+    float4 slides_x = friction < mu_cx;
+
+    // x'-y' plane, after sliding or rolling
+    float4 slide_velocity_x =
+        velocity_ground_x_transformed - friction * normal_impulse;
+    float4 slide_angular_velocity_z =
+        angular_velocity_ground_z - spin_slide_factor * normal_impulse;
+
+    float4 roll_velocity_x =
+        float4(1.0f / 7.0f)
+        * (float4(5.0f) * velocity_ground_x_transformed
+           - float4(2.0f) * radius * angular_velocity_ground_z);
+    float4 roll_angular_velocity_z = -(roll_velocity_x / radius);
+
+    velocity_ground_x_transformed =
+        select(slides_z, slide_velocity_x, roll_velocity_x);
+    angular_velocity_ground_z =
+        select(slides_z, slide_angular_velocity_z, roll_angular_velocity_z);
+    velocity_ground_y_transformed = restitution * normal_force_transformed;
+
+    // z-y' plane, after sliding or rolling
+    float4 slide_velocity_z = friction * normal_impulse;
+    float4 slide_angular_velocity_x =
+        angular_velocity_ground_x - spin_slide_factor * normal_impulse;
+
+    float4 roll_velocity_z =
+        float4(2.0f / 7.0f) * radius * angular_velocity_ground_x;
+    float4 roll_angular_velocity_x = -(roll_velocity_z / radius);
+
+    float4 velocity_ground_z =
+        select(slides_x, slide_velocity_z, roll_velocity_z);
+    angular_velocity_ground_x =
+        select(slides_x, slide_angular_velocity_x, roll_angular_velocity_x);
+
+    // Back to the ground frame...
+    velocity_ground_x = velocity_ground_x_transformed * cos_theta_c
+                        - velocity_ground_y_transformed * sin_theta_c;
+    velocity_ground_y = velocity_ground_x_transformed * sin_theta_c
+                        + velocity_ground_y_transformed * cos_theta_c;
+
+    // ...and to the world frame
+    float4 velocity_x_out = velocity_ground_x * x_unit_x
+                            + velocity_ground_y * normal_x
+                            + velocity_ground_z * z_unit_x;
+    float4 velocity_y_out = velocity_ground_x * x_unit_y
+                            + velocity_ground_y * normal_y
+                            + velocity_ground_z * z_unit_y;
+    float4 velocity_z_out = velocity_ground_x * x_unit_z
+                            + velocity_ground_y * normal_z
+                            + velocity_ground_z * z_unit_z;
+    velocity_x_out.store(&batch.velocity_x[i]);
+    velocity_y_out.store(&batch.velocity_y[i]);
+    velocity_z_out.store(&batch.velocity_z[i]);
+
+    float4 angular_velocity_x = angular_velocity_ground_x * x_unit_x
+                                + angular_velocity_ground_y * normal_x
+                                + angular_velocity_ground_z * z_unit_x;
+    float4 angular_velocity_y = angular_velocity_ground_x * x_unit_y
+                                + angular_velocity_ground_y * normal_y
+                                + angular_velocity_ground_z * z_unit_y;
+    float4 angular_velocity_z = angular_velocity_ground_x * x_unit_z
+                                + angular_velocity_ground_y * normal_z
+                                + angular_velocity_ground_z * z_unit_z;
+
+    float4 angular_speed = sqrt(angular_velocity_x * angular_velocity_x
+                                + angular_velocity_y * angular_velocity_y
+                                + angular_velocity_z * angular_velocity_z);
+    float4 inv_angular_speed = one / angular_speed;
+
+    (angular_velocity_x * inv_angular_speed).store(&batch.rotation_axis_x[i]);
+    (angular_velocity_y * inv_angular_speed).store(&batch.rotation_axis_y[i]);
+    (angular_velocity_z * inv_angular_speed).store(&batch.rotation_axis_z[i]);
+    (angular_speed * rad_s_to_rpm).store(&batch.spin_rate[i]);
+
+  }
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../math/vec3.h"
+#include "surfaces.h"
+#include <vector>
+
+/*
+  Batched ground impact.
+
+  Every ball that touches down in a step is gathered into an ImpactBatch,
+  stored as structure of arrays so the bounce can be resolved four balls at a
+  time. resolve_impacts() overwrites the velocity, rotation axis and spin rate
+  of each entry with its state after the bounce, on the material it lands on.
+*/
+
+struct ImpactBatch {
+
+  // Number of real entries. The arrays are padded up to a multiple of the
+  // SIMD width with harmless values.
+  int count = 0;
+
+  std::vector<float> velocity_x;
+  std::vector<float> velocity_y;
+  std::vector<float> velocity_z;
+
+  std::vector<float> rotation_axis_x;
+  std::vector<float> rotation_axis_y;
+  std::vector<float> rotation_axis_z;
+
+  // In rpm
+  std::vector<float> spin_rate;
+
+  // Unit normal of the ground where the ball lands. Only read.
+  std::vector<float> normal_x;
+  std::vector<float> normal_y;
+  std::vector<float> normal_z;
+
+  // The SurfaceMaterial of the ground there, as a float so the coefficients
+  // can be gathered by it. Only read.
+  std::vector<float> material;
+
+  void clear();
+  void add(vec3 velocity, vec3 rotation_axis, float spin_rate, vec3 normal,
+           SurfaceMaterial material);
+
+  vec3 get_velocity(int i) const;
+  vec3 get_rotation_axis(int i) const;
+
+};
+
+// With the coefficients from the given table (see surfaces.h), whose green row
+// comes from the ground model or the calibration
+void resolve_impacts(ImpactBatch &batch, const SurfaceTable &surfaces);
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../math/generic.h"
+#include "flight.h"
+#include <cmath>
+
+/*
+  The launch conditions set in the UI, and the initial flight state they give.
+  Templated on the scalar type like the rest of the flight model, so the same
+  conversion serves the simulation (float) and the sensitivity mode (duals,
+  see sensitivity.h).
+*/
+
+// The ball sits on a tee 1.5 inches high
+constexpr float TEE_HEIGHT = 0.0381f; // in meters
+
+template <typename T> struct LaunchConditions {
+
+  T speed;     // in m/s
+  T angle;     // above the horizontal, in radians
+  T heading;   // in radians, positive to the right of the target line
+  T spin_rate; // in rpm
+  T spin_axis; // tilt of the spin axis, in radians
+
+};
+
+template <typename T>
+FlightState<T> get_launch_state(const LaunchConditions<T> &launch,
+                                vec3 position) {
+
+  using std::cos;
+  using std::sin;
+
+  // The world y axis points left of the target line
+  T heading = -launch.heading;
+
+  FlightState<T> state;
+
+  state.position = vec3_t<T>(position);
+  state.velocity = vec3_t<T>(launch.speed * cos(launch.angle) * cos(heading),
+                             launch.speed * cos(launch.angle) * sin(heading),
+                             launch.speed * sin(launch.angle));
+
+  // The 3D axis of rotation based on the launch heading and the spin axis
+  // angle
+  state.rotation_axis =
+      vec3_t<T>(cos(launch.spin_axis) * sin(heading),
+                -cos(launch.spin_axis) * cos(heading), launch.spin_axis);
+
+  state.launch_spin_rate = launch.spin_rate;
+  state.elapsed_time = T(0.0f);
+
+  return state;
+
+}
@@ -0,0 +1,74 @@
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+
+void start_metrics(ShotMetrics &metrics, vec3 launch_position) {
+
+  metrics = ShotMetrics();
+  metrics.launch_position = launch_position;
+  metrics.first_landing = launch_position;
+
+}
+
+void record_top(ShotMetrics &metrics, vec3 previous_position,
+                float previous_speed_z, float speed_z, float timestep) {
+
+  // Only the first flight and the first bounce are of interest
+  if (metrics.num_landings > 1) {
+    return;
+  }
+
+  // The height gained before the vertical speed reaches zero is the area
+  // under it, a triangle
+  float time_to_top =
+      timestep * previous_speed_z / (previous_speed_z - speed_z);
+  float top = previous_position.z + 0.5f * previous_speed_z * time_to_top;
+
+  // A bounce off an obstacle can start another, lower, top within the same
+  // flight, which mustn't replace the first
+  if (metrics.num_landings == 0) {
+    metrics.apex = std::max(metrics.apex, top - metrics.launch_position.z);
+  } else {
+    metrics.first_bounce_height =
+        std::max(metrics.first_bounce_height, top - metrics.first_landing.z);
+  }
+
+}
+
+void record_landing(ShotMetrics &metrics, vec3 position, vec3 velocity,
+                    float time) {
+
+  metrics.num_landings++;
+
+  if (metrics.num_landings == 2) {
+    metrics.first_bounce_distance =
+        get_horizontal_distance(metrics.first_landing, position);
+    return;
+  }
+
+  if (metrics.num_landings > 2) {
+    return;
+  }
+
+  float horizontal_speed =
+      std::sqrt(velocity.x * velocity.x + velocity.y * velocity.y);
+
+  metrics.first_landing = position;
+  metrics.carry = get_horizontal_distance(metrics.launch_position, position);
+
+  // The world y axis points left of the target line
+  metrics.offline = metrics.launch_position.y - position.y;
+
+  metrics.hang_time = time;
+  metrics.descent_angle = std::atan2(-velocity.z, horizontal_speed);
+
+}
+
+void record_rest(ShotMetrics &metrics, vec3 position) {
+
+  metrics.rest_position = position;
+  metrics.total = get_horizontal_distance(metrics.launch_position, position);
+  metrics.roll_out = metrics.total - metrics.carry;
+  metrics.at_rest = true;
+
+}
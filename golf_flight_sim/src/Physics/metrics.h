@@ -0,0 +1,69 @@
+#pragma once
+
+#include "../math/vec3.h"
+
+/*
+  Shot metrics, accumulated online while the ball is stepped instead of
+  worked out afterwards from a stored trajectory. The kernels update them at
+  the events they detect anyway: the top of every flight, every landing and
+  the ball coming to rest. Each event is interpolated within the step it
+  happened in, so the metrics don't move by a whole step's travel when the
+  rate level or timestep changes, and a ball never keeps any history.
+
+  Distances are horizontal, from the launch position, and the target line
+  is the x axis.
+*/
+
+struct ShotMetrics {
+
+  vec3 launch_position;
+
+  // Height of the first flight's highest top above the launch position, in
+  // meters
+  float apex;
+
+  // Where the ball first comes down, and how far from the launch
+  vec3 first_landing;
+  float carry;
+
+  // Right of the target line at the first landing
+  float offline;
+
+  // From the launch to the first landing, in seconds
+  float hang_time;
+
+  // Below the horizontal at the first landing, in radians
+  float descent_angle;
+
+  // From the first landing to the second, and the height of the bounce
+  // above the first landing. Both zero if the ball started rolling as soon
+  // as it landed.
+  float first_bounce_distance;
+  float first_bounce_height;
+
+  // Where the ball comes to rest, how far that is from the launch and how
+  // much of it came after the first landing, bounces included
+  vec3 rest_position;
+  float total;
+  float roll_out;
+
+  int num_landings;
+  bool at_rest;
+
+};
+
+void start_metrics(ShotMetrics &metrics, vec3 launch_position);
+
+// A step from previous_position, with vertical speeds from previous_speed_z
+// (at least zero) to speed_z (below zero), went over the top of a flight.
+// The vertical speed changes about linearly within a step, so the top is
+// where it crosses zero.
+void record_top(ShotMetrics &metrics, vec3 previous_position,
+                float previous_speed_z, float speed_z, float timestep);
+
+// The ball touched down at position with velocity, time seconds after its
+// launch, all interpolated to the moment it reached the ground
+void record_landing(ShotMetrics &metrics, vec3 position, vec3 velocity,
+                    float time);
+
+void record_rest(ShotMetrics &metrics, vec3 position);
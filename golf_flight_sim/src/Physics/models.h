@@ -0,0 +1,208 @@
+#pragma once
+
+#include "../math/generic.h"
+#include "aero.h"
+#include "atmosphere.h"
+#include "coefficients.h"
+#include "constants.h"
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+/*
+  Policies the stepper is specialized on. Each one is a stateless struct with
+  static functions and constexpr constants, so the choice of model is resolved
+  at compile time and costs nothing inside the step loop. The enums name the
+  same policies at runtime; see get_flight_kernel() for how one maps to the
+  other.
+*/
+
+enum class WindModelType : uint8_t {
+  UNIFORM,
+  LOGARITHMIC,
+  NUM_TYPES
+};
+
+enum class IntegratorType : uint8_t {
+  SEMI_IMPLICIT_EULER,
+  MIDPOINT,
+  NUM_TYPES
+};
+
+enum class GroundType : uint8_t {
+  SLOW_GREEN,
+  FAST_GREEN,
+  NUM_TYPES
+};
+
+enum class AeroModelType : uint8_t {
+  TABLE,
+  SMOOTH,
+  NUM_TYPES
+};
+
+const int NUM_WIND_MODEL_TYPES = static_cast<int>(WindModelType::NUM_TYPES);
+const int NUM_INTEGRATOR_TYPES = static_cast<int>(IntegratorType::NUM_TYPES);
+const int NUM_GROUND_TYPES = static_cast<int>(GroundType::NUM_TYPES);
+const int NUM_AERO_MODEL_TYPES = static_cast<int>(AeroModelType::NUM_TYPES);
+
+/*
+  Wind models. Given the wind velocity at the reference height, return the
+  wind velocity the ball sees at its height. Templated on the scalar type like
+  the force functions (see math/generic.h).
+*/
+
+// Same wind at every height
+struct UniformWind {
+
+  template <typename T>
+  static vec3_t<T> get_velocity(vec3_t<T> wind_velocity, T ball_height) {
+    return wind_velocity;
+  }
+
+};
+
+// Logarithmic wind profile, scaled so the wind matches the given velocity at
+// LOG_WIND_PROFILE_REFERENCE_HEIGHT.
+struct LogWind {
+
+  // 1 / ln(LOG_WIND_PROFILE_REFERENCE_HEIGHT / ROUGHNESS_LENGTH_SCALE)
+  static constexpr float INV_LOG_REFERENCE_RATIO = 0.31066746727980593f;
+
+  template <typename T>
+  static vec3_t<T> get_velocity(vec3_t<T> wind_velocity, T ball_height) {
+
+    using std::log;
+
+    const T roughness_length_scale(ROUGHNESS_LENGTH_SCALE);
+
+    ball_height = select(ball_height < roughness_length_scale,
+                         roughness_length_scale, ball_height);
+
+    return wind_velocity
+           * (log(ball_height / roughness_length_scale)
+              * T(INV_LOG_REFERENCE_RATIO));
+
+  }
+
+};
+
+/*
+  Aerodynamic models. Given the square of the ball's air speed, its spin rate
+  and the air it's flying through, return the drag and lift coefficients.
+*/
+
+// The table of bands the simulation has always used (see coefficients.h)
+struct TableAero {
+
+  template <typename T>
+  static MATH_INLINE std::pair<T, T>
+  get_coefficients(T air_speed_squared, T spin_rate,
+                   const AirConstants<T> &air) {
+    return get_drag_and_lift_coefficients(
+        air_speed_squared * air.speed_squared_scale, spin_rate);
+  }
+
+};
+
+// Smooth in the Reynolds number and spin ratio (see aero.h)
+struct SmoothAero {
+
+  template <typename T>
+  static MATH_INLINE std::pair<T, T>
+  get_coefficients(T air_speed_squared, T spin_rate,
+                   const AirConstants<T> &air) {
+    return get_smooth_drag_and_lift_coefficients(air_speed_squared, spin_rate,
+                                                 air.speed_squared_scale);
+  }
+
+};
+
+/*
+  Integrators. get_sum_forces(position, velocity) returns the sum of the forces
+  on the ball in that state; the integrator decides where to evaluate it.
+
+  The state is anything with position, velocity and acceleration members of
+  type vec3_t<T>, where T is the type of dt, like a FlightState (see flight.h)
+  at any precision or width.
+*/
+
+// What the simulation has always used: velocity first, then position with the
+// new velocity.
+struct SemiImplicitEuler {
+
+  // Its error is first order in dt and mostly from gravity, so it can't take
+  // longer steps without moving carries by yards (see stepper.h)
+  static constexpr int ORDER = 1;
+
+  template <typename State, typename T, typename SumForces>
+  static void integrate(State &state, T dt, SumForces get_sum_forces) {
+
+    state.acceleration =
+        get_sum_forces(state.position, state.velocity) * T(INV_BALL_MASS);
+
+    state.velocity += state.acceleration * dt;
+    state.position += state.velocity * dt;
+
+  }
+
+};
+
+// Second order Runge-Kutta, evaluating the forces a second time at the middle
+// of the step.
+struct Midpoint {
+
+  static constexpr int ORDER = 2;
+
+  template <typename State, typename T, typename SumForces>
+  static void integrate(State &state, T dt, SumForces get_sum_forces) {
+
+    T half_dt = T(0.5f) * dt;
+
+    vec3_t<T> acceleration =
+        get_sum_forces(state.position, state.velocity) * T(INV_BALL_MASS);
+
+    vec3_t<T> mid_position = state.position + state.velocity * half_dt;
+    vec3_t<T> mid_velocity = state.velocity + acceleration * half_dt;
+
+    state.acceleration =
+        get_sum_forces(mid_position, mid_velocity) * T(INV_BALL_MASS);
+
+    state.position += mid_velocity * dt;
+    state.velocity += state.acceleration * dt;
+
+  }
+
+};
+
+/*
+  Ground models. Constants for the bounce (firmness and friction during
+  impact) and for the roll.
+
+  The formula for the coefficient of friction for rolling on a green is
+  u_r = 0.784 / dist, where dist is the stimpmeter distance in feet.
+*/
+
+// Stimpmeter of 6, the simulation's original ground
+struct SlowGreen {
+
+  static constexpr float FIRMNESS = GROUND_FIRMNESS;
+  static constexpr float FRICTION = ::FRICTION;
+  static constexpr float ROLL_FRICTION = FRICTION_ROLL;
+
+  static constexpr float ROLL_DECELERATION =
+      (5.0f / 7.0f) * ROLL_FRICTION * BALL_WEIGHT_MAGNITUDE * INV_BALL_MASS;
+
+};
+
+// Stimpmeter of 10, a typical tournament green
+struct FastGreen {
+
+  static constexpr float FIRMNESS = GROUND_FIRMNESS;
+  static constexpr float FRICTION = ::FRICTION;
+  static constexpr float ROLL_FRICTION = 0.784f / 10.0f;
+
+  static constexpr float ROLL_DECELERATION =
+      (5.0f / 7.0f) * ROLL_FRICTION * BALL_WEIGHT_MAGNITUDE * INV_BALL_MASS;
+
+};
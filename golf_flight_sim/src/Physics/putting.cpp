@@ -0,0 +1,407 @@
+#include "putting.h"
+#include "../math/simd.h"
+#include "../tracy/tracy/Tracy.hpp"
+#include "constants.h"
+#include "force.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+// A ball at the capture speed moves an eighth of the hole's width in a step,
+// and a putt on level ground stops within a centimeter of the closed form
+// roll (see roll.h)
+const float PUTT_TIMESTEP = 1.0f / 120.0f;
+
+// A putt still rolling after this has run off the green, and is left where
+// it is
+const float MAX_PUTT_TIME = 20.0f; // in seconds
+
+// sqrt(GRAVITY / (2 * RADIUS)). A ball crossing a chord of the hole this
+// long, divided by its speed, takes long enough to fall by its own radius.
+const float CAPTURE_FACTOR = 15.17503f;
+
+/*
+  Rolls up to float8::LANES putts from start, with the given speed and
+  heading (radians from the x axis) in each lane, until every one has
+  stopped or dropped. Lanes past count are left out. If path isn't nullptr,
+  it gets the first lane's position after every step.
+*/
+void roll_putt_lanes(const Terrain &green, vec3 start, vec3 hole,
+                     float deceleration, const float *speed,
+                     const float *heading, int count, PuttResult *results,
+                     std::vector<vec3> *path) {
+
+  const int lanes = float8::LANES;
+
+  float velocity_x[lanes];
+  float velocity_y[lanes];
+  float lane_index[lanes];
+
+  // Lanes past count copy the last putt, so their arithmetic stays finite,
+  // and start out finished
+  for (int i = 0; i < lanes; i++) {
+
+    int lane = std::min(i, count - 1);
+    velocity_x[i] = speed[lane] * std::cos(heading[lane]);
+    velocity_y[i] = speed[lane] * std::sin(heading[lane]);
+    lane_index[i] = static_cast<float>(i);
+
+  }
+
+  const float8 zero(0.0f);
+  const float8 dt(PUTT_TIMESTEP);
+  const float8 inv_mass(INV_BALL_MASS);
+  const float8 level_friction(deceleration / INV_BALL_MASS);
+  const float8 slope_pull(GRAVITY * (5.0f / 7.0f));
+  const float8 min_speed_squared(MIN_ROLL_VELOCITY_SQUARED);
+  const float8 hole_radius_squared(HOLE_RADIUS * HOLE_RADIUS);
+  const float8 capture_factor(CAPTURE_FACTOR);
+  const float8 hole_x(hole.x);
+  const float8 hole_y(hole.y);
+
+  vec3_t<float8> position{float8(start.x), float8(start.y), float8(start.z)};
+  vec3_t<float8> velocity{float8::load(velocity_x), float8::load(velocity_y),
+                          zero};
+
+  // Masks: still rolling, dropped, and over the hole after the last step
+  float8 rolling =
+      float8::load(lane_index) < float8(static_cast<float>(count));
+  float8 holed = zero;
+  float8 over_hole = zero;
+  float8 end_time = zero;
+
+  float x[lanes], y[lanes], normal_x[lanes], normal_y[lanes], normal_z[lanes];
+  float height[lanes];
+  float rolling_lanes[lanes];
+
+  // A ball rolls a small part of a cell each step, so most lookups land in
+  // the cell it was already in
+  Terrain::SampleCache ground_cells[lanes];
+
+  // Finished lanes keep the last ground they were on
+  for (int i = 0; i < lanes; i++) {
+    height[i] = start.z;
+    normal_x[i] = 0.0f;
+    normal_y[i] = 0.0f;
+    normal_z[i] = 1.0f;
+  }
+
+  float8 time = zero;
+  int max_steps = static_cast<int>(MAX_PUTT_TIME / PUTT_TIMESTEP);
+
+  for (int step = 0; step < max_steps && any(rolling); step++) {
+
+    // The green under each ball still rolling. Lanes finish at very
+    // different times, so skipping the rest saves a good part of the lookups.
+    position.x.store(x);
+    position.y.store(y);
+    rolling.store(rolling_lanes);
+
+    for (int i = 0; i < lanes; i++) {
+
+      if (rolling_lanes[i] == 0.0f) {
+        continue;
+      }
+
+      TerrainSample ground = green.sample(x[i], y[i], ground_cells[i]);
+      height[i] = ground.height;
+      normal_x[i] = ground.normal.x;
+      normal_y[i] = ground.normal.y;
+      normal_z[i] = ground.normal.z;
+
+    }
+
+    vec3_t<float8> normal{float8::load(normal_x), float8::load(normal_y),
+                          float8::load(normal_z)};
+
+    position.z = float8::load(height);
+
+    // Along the surface, which is only ever tilted a little from one step to
+    // the next
+    velocity -= normal * velocity.dot(normal);
+
+    // Friction pressed on by the part of the weight into the surface, and
+    // the pull of the slope, 5/7 of it since the ball has to spin up too
+    float8 friction_magnitude = level_friction * normal.z;
+    vec3_t<float8> slope_acceleration =
+        vec3_t<float8>(normal.x * normal.z, normal.y * normal.z,
+                       normal.z * normal.z - float8(1.0f))
+        * slope_pull;
+
+    vec3_t<float8> acceleration =
+        get_friction_force<float8>(velocity, friction_magnitude) * inv_mass
+        + slope_acceleration;
+
+    velocity += acceleration * dt;
+
+    // Too slow to roll, on a slope gentle enough for friction to hold it.
+    // Finished balls stay where they are.
+    float8 friction_acceleration = friction_magnitude * inv_mass;
+    float8 held = slope_acceleration.dot(slope_acceleration)
+                  <= friction_acceleration * friction_acceleration;
+    float8 stopped =
+        (velocity.dot(velocity) <= min_speed_squared) & held & rolling;
+    float8 moving = select(stopped, zero, rolling);
+
+    velocity = select(moving, velocity, vec3_t<float8>(zero, zero, zero));
+    position += velocity * dt;
+
+    time = time + dt;
+
+    // Over the hole now, and by how far off its middle the ball is heading
+    float8 to_hole_x = hole_x - position.x;
+    float8 to_hole_y = hole_y - position.y;
+    float8 distance_squared = to_hole_x * to_hole_x + to_hole_y * to_hole_y;
+    float8 inside = distance_squared < hole_radius_squared;
+
+    float8 speed_squared =
+        velocity.x * velocity.x + velocity.y * velocity.y;
+    float8 along = to_hole_x * velocity.x + to_hole_y * velocity.y;
+    float8 offset_squared =
+        distance_squared
+        - select(speed_squared > zero, along * along / speed_squared, zero);
+
+    // Crossing the edge this step, with the chord ahead of it
+    float8 chord = float8(2.0f)
+                   * sqrt(max(hole_radius_squared - offset_squared, zero));
+    float8 capture_speed = chord * capture_factor;
+    float8 entering = select(over_hole, zero, inside);
+
+    float8 drops = ((entering & (speed_squared <= capture_speed
+                                                      * capture_speed))
+                    | (stopped & inside))
+                   & rolling;
+
+    holed = holed | drops;
+    over_hole = inside;
+
+    float8 finished = (drops | stopped) & rolling;
+    end_time = select(finished, time, end_time);
+    rolling = select(finished, zero, rolling);
+
+    if (path != nullptr) {
+      position.x.store(x);
+      position.y.store(y);
+      path->push_back(vec3(x[0], y[0], height[0]));
+    }
+
+  }
+
+  // Still rolling when time ran out
+  end_time = select(rolling, time, end_time);
+
+  float holed_lanes[lanes];
+  float end_times[lanes];
+  float z[lanes];
+
+  select(holed, float8(1.0f), zero).store(holed_lanes);
+  end_time.store(end_times);
+  position.x.store(x);
+  position.y.store(y);
+  position.z.store(z);
+
+  for (int i = 0; i < count; i++) {
+
+    PuttResult &result = results[i];
+
+    result.holed = holed_lanes[i] != 0.0f;
+    result.end_position = result.holed ? hole : vec3(x[i], y[i], z[i]);
+    result.time = end_times[i];
+
+  }
+
+}
+
+// The heading of the straight line from start to the hole
+float get_line_heading(vec3 start, vec3 hole) {
+  return std::atan2(hole.y - start.y, hole.x - start.x);
+}
+
+} // namespace
+
+float get_sweep_speed(const PuttSweep &sweep, int speed) {
+
+  float fraction = sweep.num_speeds > 1
+                       ? static_cast<float>(speed)
+                             / static_cast<float>(sweep.num_speeds - 1)
+                       : 0.5f;
+
+  return sweep.min_speed + (sweep.max_speed - sweep.min_speed) * fraction;
+
+}
+
+float get_sweep_aim(const PuttSweep &sweep, int aim) {
+
+  float fraction = sweep.num_aims > 1
+                       ? static_cast<float>(aim)
+                             / static_cast<float>(sweep.num_aims - 1)
+                       : 0.5f;
+
+  return sweep.max_aim * (2.0f * fraction - 1.0f);
+
+}
+
+PuttResult roll_putt(const Terrain &green, vec3 start, vec3 hole, float speed,
+                     float aim, float deceleration, std::vector<vec3> *path) {
+
+  // Aim is to the right, and the world's y axis points left
+  float heading = get_line_heading(start, hole) - aim;
+
+  PuttResult result;
+  roll_putt_lanes(green, start, hole, deceleration, &speed, &heading, 1,
+                  &result, path);
+
+  return result;
+
+}
+
+PuttSweep get_default_sweep(vec3 start, vec3 hole, float deceleration) {
+
+  float dx = hole.x - start.x;
+  float dy = hole.y - start.y;
+  float distance = std::sqrt(dx * dx + dy * dy);
+
+  // v^2 = 2 a d stops a ball d away on level ground. The fastest putts would
+  // reach the hole at a little over the capture speed.
+  PuttSweep sweep;
+  sweep.num_speeds = 64;
+  sweep.num_aims = 64;
+  sweep.min_speed = std::sqrt(2.0f * deceleration * 0.7f * distance);
+  sweep.max_speed =
+      std::sqrt(2.0f * deceleration * 1.3f * distance + 2.0f * 2.0f);
+
+  // Room for the hole and a few percent of the distance in break either side
+  sweep.max_aim = std::atan2(0.25f + 0.06f * distance, distance);
+
+  return sweep;
+
+}
+
+GreenReading read_green(const Terrain &green, vec3 start, vec3 hole,
+                        float deceleration, const PuttSweep &sweep,
+                        int num_threads) {
+
+  ZoneScoped; // for tracy
+
+  auto start_time = std::chrono::steady_clock::now();
+
+  GreenReading reading;
+  reading.sweep = sweep;
+
+  int num_putts = sweep.num_speeds * sweep.num_aims;
+  std::vector<PuttResult> results(num_putts);
+
+  float line_heading = get_line_heading(start, hole);
+
+  // Each vector holds eight aims at the same speed, which roll for about as
+  // long as each other, so few lanes sit idle waiting for the slowest. Each
+  // thread takes the next speed that nobody has rolled yet, so the faster
+  // putts, which roll the longest, don't hold one thread up.
+  std::atomic<int> next_speed(0);
+
+  auto roll_speeds = [&]() {
+
+    float speeds[float8::LANES];
+    float headings[float8::LANES];
+
+    for (int speed = next_speed++; speed < sweep.num_speeds;
+         speed = next_speed++) {
+
+      for (int first = 0; first < sweep.num_aims; first += float8::LANES) {
+
+        int count = std::min(float8::LANES, sweep.num_aims - first);
+
+        for (int i = 0; i < count; i++) {
+          speeds[i] = get_sweep_speed(sweep, speed);
+          headings[i] = line_heading - get_sweep_aim(sweep, first + i);
+        }
+
+        roll_putt_lanes(green, start, hole, deceleration, speeds, headings,
+                        count, &results[speed * sweep.num_aims + first],
+                        nullptr);
+
+      }
+
+    }
+
+  };
+
+  if (num_threads <= 0) {
+    num_threads = static_cast<int>(std::thread::hardware_concurrency());
+  }
+
+  num_threads = std::max(1, std::min(num_threads, sweep.num_speeds));
+
+  // This thread rolls its share as well
+  std::vector<std::thread> threads;
+
+  for (int i = 1; i < num_threads; i++) {
+    threads.emplace_back(roll_speeds);
+  }
+
+  roll_speeds();
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  reading.holed.resize(num_putts);
+  reading.leave.resize(num_putts);
+  reading.num_holed = 0;
+  reading.best_speed = 0.0f;
+  reading.best_aim = 0.0f;
+
+  for (int i = 0; i < num_putts; i++) {
+
+    vec3 miss = results[i].end_position - hole;
+
+    reading.holed[i] = results[i].holed ? 1 : 0;
+    reading.leave[i] = std::sqrt(miss.x * miss.x + miss.y * miss.y);
+    reading.num_holed += reading.holed[i];
+
+  }
+
+  // The speed with the longest run of neighbouring aims that drop, at the
+  // middle of the run. Where the break splits them into separate runs,
+  // aiming between those would miss.
+  int widest = 0;
+
+  for (int speed = 0; speed < sweep.num_speeds; speed++) {
+
+    const uint8_t *holed = &reading.holed[speed * sweep.num_aims];
+    int run = 0;
+
+    for (int aim = 0; aim < sweep.num_aims; aim++) {
+
+      run = holed[aim] ? run + 1 : 0;
+
+      if (run > widest) {
+
+        widest = run;
+        reading.best_speed = get_sweep_speed(sweep, speed);
+
+        float middle = static_cast<float>(aim)
+                       - 0.5f * static_cast<float>(run - 1);
+        float fraction =
+            sweep.num_aims > 1
+                ? middle / static_cast<float>(sweep.num_aims - 1)
+                : 0.5f;
+        reading.best_aim = sweep.max_aim * (2.0f * fraction - 1.0f);
+
+      }
+
+    }
+
+  }
+
+  reading.time_ms = std::chrono::duration<float, std::milli>(
+                        std::chrono::steady_clock::now() - start_time)
+                        .count();
+
+  return reading;
+
+}
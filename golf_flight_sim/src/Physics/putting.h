@@ -0,0 +1,99 @@
+#pragma once
+
+#include "../Terrain/Terrain.h"
+#include "../math/vec3.h"
+#include <cstdint>
+#include <vector>
+
+/*
+  Putting mode. A putt rolls across a green heightfield under the same forces
+  as the roll phase (see roll.h): rolling friction against the velocity,
+  pressed on by the part of the weight into the surface, and the pull of the
+  slope. Putts break along curving lines, so they're stepped rather than
+  solved in closed form, eight at a time in a float8 each.
+
+  A ball whose center crosses the edge of the hole drops if it's slow enough
+  to fall by its own radius before reaching the far edge, which for a ball
+  over the middle of the hole is about 1.6 m/s. A faster one rolls on over
+  it, and one that stops over the hole drops as well. Lip outs, which would
+  turn the ball, aren't modeled.
+
+  The green reading solver rolls a grid of putts at different speeds and
+  aims at once, spread over every core, and finds the ones that drop: the
+  make zone for the hole.
+*/
+
+// A regulation hole is 4.25 inches across
+const float HOLE_RADIUS = 0.053975f; // in meters
+
+struct PuttResult {
+
+  bool holed;
+
+  // Where the ball stopped, or the hole if it dropped
+  vec3 end_position;
+
+  // How long it rolled for, in seconds
+  float time;
+
+};
+
+// A grid of putts, every speed at every aim
+struct PuttSweep {
+
+  int num_speeds;
+  int num_aims;
+
+  // In m/s
+  float min_speed;
+  float max_speed;
+
+  // Either side of the straight line to the hole, in radians
+  float max_aim;
+
+};
+
+struct GreenReading {
+
+  PuttSweep sweep;
+
+  // Per putt, row by row in speed: whether it drops, and how far from the
+  // hole it stops if it doesn't
+  std::vector<uint8_t> holed;
+  std::vector<float> leave;
+
+  int num_holed;
+
+  // The speed with the longest run of neighbouring aims that drop, aimed at
+  // the middle of that run, which leaves the most room for error. Only set
+  // if any putt drops.
+  float best_speed;
+  float best_aim;
+
+  float time_ms;
+
+};
+
+// The speed and aim of the putts at the given indices in a sweep, evenly
+// spaced from the minimum to the maximum
+float get_sweep_speed(const PuttSweep &sweep, int speed);
+float get_sweep_aim(const PuttSweep &sweep, int aim);
+
+// Rolls a putt from start across the green, at the given speed and aim
+// (radians right of the straight line to the hole), until it stops or drops.
+// deceleration is the green's rolling deceleration on level ground (see
+// SurfaceTable). If path isn't nullptr, it gets the ball's position after
+// every step.
+PuttResult roll_putt(const Terrain &green, vec3 start, vec3 hole, float speed,
+                     float aim, float deceleration,
+                     std::vector<vec3> *path = nullptr);
+
+// Speeds from well short of the hole to well past it on level ground, and
+// aims wide enough for the break on a typical green
+PuttSweep get_default_sweep(vec3 start, vec3 hole, float deceleration);
+
+// Rolls every putt in the sweep on num_threads threads, or one per core if
+// it's 0
+GreenReading read_green(const Terrain &green, vec3 start, vec3 hole,
+                        float deceleration, const PuttSweep &sweep,
+                        int num_threads = 0);
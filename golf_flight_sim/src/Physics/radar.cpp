@@ -0,0 +1,340 @@
+#include "radar.h"
+#include "../Simulation/Simulation.h"
+#include "../math/linear.h"
+#include "../tracy/tracy/Tracy.hpp"
+#include "calibration.h"
+#include "flight.h"
+#include "sensitivity.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+namespace {
+
+// The simulation's rate, which the fit's flight steps at between samples
+const float TIMESTEP = 1.0f / 240.0f;
+
+// Closer to a sample than this and the flight is taken to be there
+const float MIN_STEP = 1e-6f; // in seconds
+
+// The spin rate and spin axis priors' rows, after the samples'
+const int NUM_PRIORS = 2;
+
+const double INITIAL_DAMPING = 1e-3;
+
+// An update stops once an iteration changes the cost by less than this
+// fraction
+const double MIN_IMPROVEMENT = 1e-4;
+
+// Keeps a fit that's wandered off from flying the ball backwards
+const float MIN_SPEED = 1.0f; // in m/s
+
+/*
+  Residuals of the track from flying launch: three per sample, over the
+  position noise, and then the priors. jacobian gets their derivatives with
+  respect to every LaunchInput, row by row. Returns the sum of the squares of
+  the residuals.
+*/
+double get_residuals(const RadarTrack &track,
+                     const LaunchConditions<float> &launch,
+                     const TrackerSettings &settings,
+                     std::vector<double> &residuals,
+                     std::vector<double> &jacobian) {
+
+  ZoneScoped; // for tracy
+
+  const int n = NUM_LAUNCH_INPUTS;
+  const int num_rows =
+      static_cast<int>(track.samples.size()) * 3 + NUM_PRIORS;
+
+  residuals.resize(num_rows);
+  jacobian.assign(num_rows * n, 0.0);
+
+  FlightState<LaunchDual> state =
+      get_launch_state(seed_launch_inputs(launch), track.launch_position);
+
+  const vec3_t<LaunchDual> wind(vec3(0.0f, 0.0f, 0.0f));
+  const AirConstants<LaunchDual> air(REFERENCE_AIR);
+  const float inv_noise = 1.0f / settings.position_noise;
+
+  float time = 0.0f;
+  double cost = 0.0;
+
+  for (size_t k = 0; k < track.samples.size(); k++) {
+
+    const RadarSample &sample = track.samples[k];
+
+    while (sample.time - time > MIN_STEP) {
+
+      float dt = std::min(TIMESTEP, sample.time - time);
+      step_flight_state<UniformWind, SemiImplicitEuler, SmoothAero>(
+          state, wind, air, LaunchDual(dt));
+      time += dt;
+
+    }
+
+    const LaunchDual *coordinates[3] = {&state.position.x, &state.position.y,
+                                       &state.position.z};
+    const float observed[3] = {sample.position.x, sample.position.y,
+                               sample.position.z};
+
+    for (int c = 0; c < 3; c++) {
+
+      int row = static_cast<int>(k) * 3 + c;
+      double residual = (coordinates[c]->value - observed[c]) * inv_noise;
+
+      residuals[row] = residual;
+      cost += residual * residual;
+
+      for (int i = 0; i < n; i++) {
+        jacobian[row * n + i] = coordinates[c]->gradient[i] * inv_noise;
+      }
+
+    }
+
+  }
+
+  int spin_rate_row = num_rows - 2;
+  int spin_axis_row = num_rows - 1;
+
+  residuals[spin_rate_row] = (launch.spin_rate - settings.spin_rate_prior)
+                             / settings.spin_rate_spread;
+  jacobian[spin_rate_row * n + static_cast<int>(LaunchInput::SPIN_RATE)] =
+      1.0 / settings.spin_rate_spread;
+
+  residuals[spin_axis_row] = launch.spin_axis / settings.spin_axis_spread;
+  jacobian[spin_axis_row * n + static_cast<int>(LaunchInput::SPIN_AXIS)] =
+      1.0 / settings.spin_axis_spread;
+
+  for (int row = spin_rate_row; row < num_rows; row++) {
+    cost += residuals[row] * residuals[row];
+  }
+
+  return cost;
+
+}
+
+/*
+  A first guess from the average velocity to the latest sample, with gravity
+  taken back out, ignoring drag and lift. The spin starts at its prior.
+*/
+LaunchConditions<float> guess_launch(const RadarTrack &track,
+                                     const TrackerSettings &settings) {
+
+  const RadarSample &last = track.samples.back();
+
+  vec3 velocity = (last.position - track.launch_position) / last.time;
+  velocity.z += 0.5f * GRAVITY * last.time;
+
+  float horizontal_speed =
+      std::sqrt(velocity.x * velocity.x + velocity.y * velocity.y);
+
+  LaunchConditions<float> launch;
+
+  launch.speed = std::max(norm(velocity), MIN_SPEED);
+  launch.angle = std::atan2(velocity.z, horizontal_speed);
+
+  // The world y axis points left of the target line
+  launch.heading = -std::atan2(velocity.y, velocity.x);
+
+  launch.spin_rate = settings.spin_rate_prior;
+  launch.spin_axis = 0.0f;
+
+  return launch;
+
+}
+
+LaunchConditions<float> add_step(const LaunchConditions<float> &launch,
+                                 const std::vector<double> &step) {
+
+  LaunchConditions<float> result;
+
+  result.speed = std::max(launch.speed + static_cast<float>(step[0]),
+                          MIN_SPEED);
+  result.angle = launch.angle + static_cast<float>(step[1]);
+  result.heading = launch.heading + static_cast<float>(step[2]);
+  result.spin_rate =
+      std::max(launch.spin_rate + static_cast<float>(step[3]), 0.0f);
+  result.spin_axis = launch.spin_axis + static_cast<float>(step[4]);
+
+  return result;
+
+}
+
+bool is_same_launch(const LaunchConditions<float> &a,
+                    const LaunchConditions<float> &b) {
+
+  return a.speed == b.speed && a.angle == b.angle && a.heading == b.heading
+         && a.spin_rate == b.spin_rate && a.spin_axis == b.spin_axis;
+
+}
+
+} // namespace
+
+// Out of line, where Simulation is complete
+RadarTrack::RadarTrack() = default;
+RadarTrack::~RadarTrack() = default;
+
+void RadarTrack::reset(vec3 launch_position) {
+
+  this->launch_position = launch_position;
+  samples.clear();
+  prediction = TrackPrediction();
+
+}
+
+const TrackPrediction &update_track(RadarTrack &track,
+                                    const RadarSample &sample,
+                                    const TrackerSettings &settings) {
+
+  ZoneScoped; // for tracy
+
+  static_assert(NUM_LAUNCH_INPUTS == 5, "add_step() expects five inputs");
+
+  auto start_time = std::chrono::steady_clock::now();
+
+  // Samples can arrive a little out of order
+  auto later = std::upper_bound(
+      track.samples.begin(), track.samples.end(), sample,
+      [](const RadarSample &a, const RadarSample &b) {
+        return a.time < b.time;
+      });
+  track.samples.insert(later, sample);
+
+  if (static_cast<int>(track.samples.size()) < MIN_TRACK_SAMPLES) {
+    return track.prediction;
+  }
+
+  TrackPrediction &prediction = track.prediction;
+
+  LaunchConditions<float> launch = prediction.valid
+                                       ? prediction.launch
+                                       : guess_launch(track, settings);
+
+  const int n = NUM_LAUNCH_INPUTS;
+
+  std::vector<double> &residuals = track.residuals;
+  std::vector<double> &jacobian = track.jacobian;
+  std::vector<double> &trial_residuals = track.trial_residuals;
+  std::vector<double> &trial_jacobian = track.trial_jacobian;
+  std::vector<double> &normal = track.normal;
+  std::vector<double> &gradient = track.gradient;
+  std::vector<double> &system = track.system;
+  std::vector<double> &step = track.step;
+
+  normal.resize(n * n);
+  gradient.resize(n);
+
+  double cost = get_residuals(track, launch, settings, residuals, jacobian);
+  double damping = INITIAL_DAMPING;
+  int iterations = 0;
+
+  while (iterations < settings.max_iterations) {
+
+    iterations++;
+
+    // The normal equations J^T J and the gradient J^T r
+    std::fill(normal.begin(), normal.end(), 0.0);
+    std::fill(gradient.begin(), gradient.end(), 0.0);
+
+    for (size_t row = 0; row < residuals.size(); row++) {
+
+      const double *derivatives = &jacobian[row * n];
+
+      for (int a = 0; a < n; a++) {
+
+        gradient[a] -= derivatives[a] * residuals[row];
+
+        for (int b = 0; b < n; b++) {
+          normal[a * n + b] += derivatives[a] * derivatives[b];
+        }
+
+      }
+
+    }
+
+    system = normal;
+    step = gradient;
+
+    for (int a = 0; a < n; a++) {
+      system[a * n + a] += damping * std::max(normal[a * n + a], 1e-9);
+    }
+
+    solve_linear_system(system, step, n);
+
+    LaunchConditions<float> trial = add_step(launch, step);
+    double trial_cost = get_residuals(track, trial, settings,
+                                      trial_residuals, trial_jacobian);
+
+    // Either way, a step that barely changes the cost means the fit is at
+    // its minimum, to within the float arithmetic of the flight
+    bool converged = std::fabs(cost - trial_cost) < MIN_IMPROVEMENT * cost;
+
+    if (trial_cost < cost) {
+      launch = trial;
+      cost = trial_cost;
+      std::swap(residuals, trial_residuals);
+      std::swap(jacobian, trial_jacobian);
+      damping = std::max(damping * 0.3, 1e-9);
+    } else {
+      damping *= 10.0;
+    }
+
+    if (converged) {
+      break;
+    }
+
+  }
+
+  // The priors' share of the cost doesn't count towards the fit
+  double samples_cost = 0.0;
+  int num_sample_rows = static_cast<int>(track.samples.size()) * 3;
+
+  for (int row = 0; row < num_sample_rows; row++) {
+    samples_cost += residuals[row] * residuals[row];
+  }
+
+  // An update whose every step was turned down leaves the launch, and so
+  // the rest of the shot, exactly as they were
+  bool launch_moved = !prediction.valid
+                      || !is_same_launch(launch, prediction.launch);
+
+  prediction.valid = true;
+  prediction.launch = launch;
+  prediction.rms = static_cast<float>(
+      std::sqrt(samples_cost / static_cast<double>(track.samples.size()))
+      * settings.position_noise);
+  prediction.iterations = iterations;
+
+  if (launch_moved) {
+
+    if (!track.simulation) {
+      track.simulation = std::make_unique<Simulation>(
+          1.0f / PHYSICS_STEPS_PER_SECOND, Wind(0.0f, 0.0f, false));
+    }
+
+    std::vector<ShotMetrics> &metrics = track.metrics;
+
+    simulate_shots(*track.simulation, &launch, 1, track.launch_position,
+                   DEFAULT_PHYSICS_PARAMETERS, AeroModelType::SMOOTH,
+                   metrics);
+
+    prediction.landing = metrics[0].first_landing;
+    prediction.rest = metrics[0].rest_position;
+    prediction.carry = metrics[0].carry;
+    prediction.total = metrics[0].total;
+    prediction.apex = metrics[0].apex + track.launch_position.z;
+
+    // The world y axis points left of the target line
+    prediction.offline = track.launch_position.y - prediction.landing.y;
+
+  }
+
+  prediction.time_ms = std::chrono::duration<float, std::milli>(
+                           std::chrono::steady_clock::now() - start_time)
+                           .count();
+
+  return prediction;
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../math/vec3.h"
+#include "launch.h"
+#include "metrics.h"
+#include <memory>
+#include <vector>
+
+class Simulation;
+
+/*
+  Landing prediction from a partial radar track. A radar follows the ball for
+  the first second or so of its flight, which is enough to pin down the launch
+  that produced it, and from the launch the simulation can fly, bounce and
+  roll the rest of the shot.
+
+  The launch (speed, angle, heading, spin rate and spin axis) is fitted to
+  the track by Levenberg-Marquardt on the sample positions. Each evaluation
+  flies the track once with dual numbers seeded on the five inputs, as the
+  sensitivity mode does (see sensitivity.h), which gives the residuals and
+  their exact Jacobian in one pass. Steps are cut short to land exactly on
+  every sample time, so nothing is interpolated.
+
+  The track only shows the spin through the lift it makes, so the fit flies
+  with the smooth aerodynamic model (see aero.h), whose coefficients change
+  with the spin rate; the table's are flat within each band and would give
+  it nothing to go on. Early in a track that's still very little, so weak
+  priors hold the spin rate and axis near a typical shot's until the
+  curvature of the track says otherwise.
+
+  Every new sample refines the last fit rather than starting again, which
+  usually takes one or two iterations, so predictions can follow the track
+  live. Shots are assumed to be hit in calm air at the reference conditions
+  onto level ground at height 0.
+*/
+
+// A position from the radar, in the simulation's frame, at a time since the
+// ball was struck
+struct RadarSample {
+
+  float time; // in seconds
+  vec3 position;
+
+};
+
+struct TrackerSettings {
+
+  // The radar's error in each coordinate, in meters
+  float position_noise = 0.02f;
+
+  // The spin rate prior's mean and spread, in rpm, and the spin axis
+  // prior's spread around zero, in radians
+  float spin_rate_prior = 3000.0f;
+  float spin_rate_spread = 3000.0f;
+  float spin_axis_spread = 0.35f;
+
+  int max_iterations = 8;
+
+};
+
+struct TrackPrediction {
+
+  // Whether there are enough samples for a fit yet
+  bool valid = false;
+
+  LaunchConditions<float> launch;
+
+  // Root mean square distance of the samples from the fitted flight, in
+  // meters, and the iterations this update took
+  float rms;
+  int iterations;
+
+  // Where the ball lands first and where it comes to rest
+  vec3 landing;
+  vec3 rest;
+
+  // From the launch position, in meters, with offline positive to the right
+  // of the target line
+  float carry;
+  float offline;
+  float total;
+  float apex;
+
+  // For the whole update, fit and prediction
+  float time_ms;
+
+};
+
+// Samples before the first fit
+const int MIN_TRACK_SAMPLES = 3;
+
+struct RadarTrack {
+
+  // Where the ball was struck from
+  vec3 launch_position = vec3(0.0f, 0.0f, 0.0f);
+
+  // In order of time
+  std::vector<RadarSample> samples;
+
+  // The latest, which the next update starts from
+  TrackPrediction prediction;
+
+  // The fit's working space, kept from one update to the next, and through
+  // resets, so an update doesn't allocate once the track has grown
+  std::vector<double> residuals;
+  std::vector<double> jacobian;
+  std::vector<double> trial_residuals;
+  std::vector<double> trial_jacobian;
+  std::vector<double> normal;
+  std::vector<double> gradient;
+  std::vector<double> system;
+  std::vector<double> step;
+
+  // Flies the rest of the shot from the fitted launch. Made by the first
+  // fit and kept the same way.
+  std::unique_ptr<Simulation> simulation;
+  std::vector<ShotMetrics> metrics;
+
+  RadarTrack();
+  ~RadarTrack();
+
+  // Starts a new track
+  void reset(vec3 launch_position);
+
+};
+
+// Adds a sample to the track, refits the launch to all of it and predicts the
+// rest of the shot
+const TrackPrediction &update_track(RadarTrack &track,
+                                    const RadarSample &sample,
+                                    const TrackerSettings &settings);
@@ -0,0 +1,132 @@
+#include "roll.h"
+#include "constants.h"
+#include <algorithm>
+#include <cmath>
+
+float get_roll_deceleration() {
+
+  // Same friction magnitude as get_friction_force, divided by the mass
+  return (5.0f / 7.0f) * FRICTION_ROLL * norm(BALL_WEIGHT) * INV_BALL_MASS;
+
+}
+
+RollSolution solve_roll(vec3 position, vec3 velocity) {
+  return solve_roll(position, velocity, get_roll_deceleration());
+}
+
+RollSolution solve_roll(vec3 position, vec3 velocity, float deceleration) {
+  return solve_roll(position, velocity, deceleration,
+                    vec3(0.0f, 0.0f, 1.0f), INFINITY);
+}
+
+RollSolution solve_roll(vec3 position, vec3 velocity, float deceleration,
+                        vec3 normal, float max_time) {
+
+  RollSolution roll;
+
+  roll.start_position = position;
+
+  // Only the part of the weight into the surface presses the ball onto it,
+  // and the part along it accelerates the ball, by 5/7 of it since the ball
+  // has to spin up as well. Both are exact zeros on level ground.
+  float friction = deceleration * normal.z;
+  vec3 slope_acceleration =
+      (GRAVITY_VEC - normal * GRAVITY_VEC.dot(normal)) * (5.0f / 7.0f);
+
+  float speed_squared = velocity.dot(velocity);
+  bool is_held =
+      slope_acceleration.dot(slope_acceleration) <= friction * friction;
+
+  if (speed_squared <= MIN_ROLL_VELOCITY_SQUARED) {
+
+    // Too slow to roll, and friction can hold it: the ball stops where it is
+    if (is_held) {
+
+      roll.direction = vec3(0.0f, 0.0f, 0.0f);
+      roll.start_speed = 0.0f;
+      roll.deceleration = friction;
+      roll.lateral_acceleration = vec3(0.0f, 0.0f, 0.0f);
+      roll.stop_time = 0.0f;
+      roll.end_time = 0.0f;
+      roll.end_position = position;
+      roll.comes_to_rest = true;
+
+      return roll;
+
+    }
+
+    // Otherwise it starts rolling downhill from rest
+    roll.start_speed = 0.0f;
+    roll.direction = slope_acceleration.unit_vector();
+
+  } else {
+
+    roll.start_speed = std::sqrt(speed_squared);
+    roll.direction = velocity / roll.start_speed;
+
+  }
+
+  float downhill = slope_acceleration.dot(roll.direction);
+
+  roll.deceleration = friction - downhill;
+  roll.lateral_acceleration = slope_acceleration - roll.direction * downhill;
+
+  roll.stop_time = roll.deceleration > 0.0f
+                       ? roll.start_speed / roll.deceleration
+                       : INFINITY;
+  roll.end_time = std::min(roll.stop_time, max_time);
+  roll.comes_to_rest = is_held && roll.end_time == roll.stop_time;
+
+  float end_distance;
+
+  if (roll.end_time == roll.stop_time) {
+    end_distance = speed_squared / (2.0f * roll.deceleration);
+  } else {
+    end_distance =
+        (roll.start_speed - 0.5f * roll.deceleration * roll.end_time)
+        * roll.end_time;
+  }
+
+  roll.end_position =
+      position + roll.direction * end_distance
+      + roll.lateral_acceleration * (0.5f * roll.end_time * roll.end_time);
+
+  return roll;
+
+}
+
+vec3 get_roll_position(const RollSolution &roll, float t) {
+
+  if (t >= roll.end_time) {
+    return roll.end_position;
+  }
+
+  float distance = (roll.start_speed - 0.5f * roll.deceleration * t) * t;
+
+  return roll.start_position + roll.direction * distance
+         + roll.lateral_acceleration * (0.5f * t * t);
+
+}
+
+vec3 get_roll_velocity(const RollSolution &roll, float t) {
+
+  if (t >= roll.end_time && roll.comes_to_rest) {
+    return vec3(0.0f, 0.0f, 0.0f);
+  }
+
+  t = std::min(t, roll.end_time);
+
+  return roll.direction * (roll.start_speed - roll.deceleration * t)
+         + roll.lateral_acceleration * t;
+
+}
+
+vec3 get_roll_acceleration(const RollSolution &roll, float t) {
+
+  if (t >= roll.end_time) {
+    return vec3(0.0f, 0.0f, 0.0f);
+  }
+
+  return roll.direction * -roll.deceleration + roll.lateral_acceleration;
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "../math/vec3.h"
+
+/*
+  Closed form solution of the roll phase.
+
+  While rolling, the ball feels rolling friction, which has a constant
+  magnitude of (5/7) * FRICTION_ROLL * |W| * n_z (n being the surface normal)
+  and always points against the velocity, and the part of its weight along
+  the surface. On a plane the pull of the slope is constant, so splitting it
+  along and across the initial direction of the roll gives
+
+        s(t) = v0 * t - 0.5 * a * t^2       along it
+        d(t) = 0.5 * a_lateral * t^2        across it
+
+  where a is the friction less the pull of the slope downhill. On level
+  ground a_lateral is zero and the ball decelerates uniformly along a
+  straight line, so the stopping point and time are known as soon as the
+  roll starts, and the position at any time is O(1) to evaluate.
+
+  On sloped ground the friction turns with the velocity, which the solution
+  doesn't follow, and the slope changes under the ball. There the solution
+  is only used for a short time (end_time), after which it's solved again
+  from where the ball has got to on the surface there. Once the ball stops
+  on a slope gentle enough for friction to hold it, it stays put; the
+  sideways drift the solution has built up by then comes from holding the
+  friction's direction fixed, not from the ball.
+*/
+
+struct RollSolution {
+
+  vec3 start_position;
+  vec3 direction; // unit vector along the initial roll velocity
+  float start_speed;
+
+  // Along direction: rolling friction less the pull of the slope downhill
+  float deceleration;
+
+  // The pull of the slope across direction
+  vec3 lateral_acceleration;
+
+  // Time from the start of the roll until the ball stops, in seconds. Infinite
+  // if the slope is too steep for it to stop.
+  float stop_time;
+
+  // How long the solution holds, which is stop_time unless it was limited,
+  // and where the ball is at that point. On level ground, where it comes to
+  // rest.
+  float end_time;
+  vec3 end_position;
+
+  // Whether the ball stops at end_time and stays there
+  bool comes_to_rest;
+
+};
+
+float get_roll_deceleration();
+
+RollSolution solve_roll(vec3 position, vec3 velocity);
+
+// Same as above, for a level surface with the given rolling deceleration
+RollSolution solve_roll(vec3 position, vec3 velocity, float deceleration);
+
+// Same as above, on a surface with the given unit normal, for at most
+// max_time seconds. velocity must lie in the surface. A ball that's too slow
+// to roll stays put (stop_time is zero) if friction can hold it on the slope,
+// otherwise it starts rolling downhill.
+RollSolution solve_roll(vec3 position, vec3 velocity, float deceleration,
+                        vec3 normal, float max_time);
+
+// t is the time since the roll started. Past end_time the ball stays at
+// end_position, and is only still moving if it doesn't come to rest.
+vec3 get_roll_position(const RollSolution &roll, float t);
+vec3 get_roll_velocity(const RollSolution &roll, float t);
+vec3 get_roll_acceleration(const RollSolution &roll, float t);
@@ -0,0 +1,209 @@
+#include "sensitivity.h"
+#include "../tracy/tracy/Tracy.hpp"
+#include "flight.h"
+
+LaunchConditions<LaunchDual>
+seed_launch_inputs(const LaunchConditions<float> &launch) {
+
+  LaunchConditions<LaunchDual> dual_launch;
+
+  dual_launch.speed =
+      LaunchDual::input(launch.speed, static_cast<int>(LaunchInput::SPEED));
+  dual_launch.angle =
+      LaunchDual::input(launch.angle, static_cast<int>(LaunchInput::ANGLE));
+  dual_launch.heading = LaunchDual::input(
+      launch.heading, static_cast<int>(LaunchInput::HEADING));
+  dual_launch.spin_rate = LaunchDual::input(
+      launch.spin_rate, static_cast<int>(LaunchInput::SPIN_RATE));
+  dual_launch.spin_axis = LaunchDual::input(
+      launch.spin_axis, static_cast<int>(LaunchInput::SPIN_AXIS));
+
+  return dual_launch;
+
+}
+
+// Long enough for any real shot. A ball still in the air after this is left
+// where it is.
+const float MAX_FLIGHT_TIME = 30.0f; // in seconds
+
+template <typename T> struct LandingState {
+
+  vec3_t<T> position;
+  T carry;
+  T offline;
+  T flight_time;
+
+};
+
+// Flies a launch until it drops below the ground, then interpolates the
+// crossing between the last two steps
+template <typename WindModel, typename Integrator, typename AeroModel,
+          typename T>
+LandingState<T> fly_to_ground(const LaunchConditions<T> &launch,
+                              vec3 position, vec3 wind_velocity,
+                              const AirConstants<float> &air,
+                              float timestep) {
+
+  using std::sqrt;
+
+  FlightState<T> state = get_launch_state(launch, position);
+  FlightState<T> previous = state;
+
+  const vec3_t<T> wind(wind_velocity);
+  const AirConstants<T> air_constants(air);
+  const T dt(timestep);
+
+  int max_steps = static_cast<int>(MAX_FLIGHT_TIME / timestep);
+
+  for (int i = 0; i < max_steps && state.position.z > T(0.0f); i++) {
+    previous = state;
+    step_flight_state<WindModel, Integrator, AeroModel>(state, wind,
+                                                        air_constants, dt);
+  }
+
+  // Fraction of the last step taken before the ball reached the ground
+  T fraction(1.0f);
+
+  if (state.position.z <= T(0.0f)) {
+    fraction = previous.position.z
+               / (previous.position.z - state.position.z);
+  }
+
+  LandingState<T> landing;
+
+  landing.position = previous.position
+                     + (state.position - previous.position) * fraction;
+  landing.flight_time = previous.elapsed_time + dt * fraction;
+
+  vec3_t<T> displacement = landing.position - vec3_t<T>(position);
+
+  landing.carry = sqrt(displacement.x * displacement.x
+                       + displacement.y * displacement.y);
+
+  // The world y axis points left of the target line
+  landing.offline = -displacement.y;
+
+  return landing;
+
+}
+
+template <typename WindModel, typename Integrator, typename AeroModel>
+Landing get_landing(const LaunchConditions<float> &launch, vec3 position,
+                    vec3 wind_velocity, const AirConstants<float> &air,
+                    float timestep) {
+
+  LandingState<float> state =
+      fly_to_ground<WindModel, Integrator, AeroModel>(
+          launch, position, wind_velocity, air, timestep);
+
+  Landing landing;
+
+  landing.position = state.position;
+  landing.carry = state.carry;
+  landing.offline = state.offline;
+  landing.flight_time = state.flight_time;
+
+  return landing;
+
+}
+
+template <typename WindModel, typename Integrator, typename AeroModel>
+LaunchSensitivities
+get_launch_sensitivities(const LaunchConditions<float> &launch,
+                         vec3 position, vec3 wind_velocity,
+                         const AirConstants<float> &air, float timestep) {
+
+  ZoneScoped; // for tracy
+
+  LandingState<LaunchDual> state =
+      fly_to_ground<WindModel, Integrator, AeroModel>(
+          seed_launch_inputs(launch), position, wind_velocity, air, timestep);
+
+  LaunchSensitivities sensitivities;
+
+  sensitivities.landing.position =
+      vec3(state.position.x.value, state.position.y.value,
+           state.position.z.value);
+  sensitivities.landing.carry = state.carry.value;
+  sensitivities.landing.offline = state.offline.value;
+  sensitivities.landing.flight_time = state.flight_time.value;
+
+  for (int i = 0; i < NUM_LAUNCH_INPUTS; i++) {
+
+    Landing &gradient = sensitivities.gradient[i];
+
+    gradient.position =
+        vec3(state.position.x.gradient[i], state.position.y.gradient[i],
+             state.position.z.gradient[i]);
+    gradient.carry = state.carry.gradient[i];
+    gradient.offline = state.offline.gradient[i];
+    gradient.flight_time = state.flight_time.gradient[i];
+
+  }
+
+  return sensitivities;
+
+}
+
+/*
+  Dispatch tables, indexed by the policy enums in the order they're declared
+  in models.h.
+*/
+
+using LandingFunction = Landing (*)(const LaunchConditions<float> &, vec3,
+                                    vec3, const AirConstants<float> &, float);
+using SensitivityFunction = LaunchSensitivities (*)(
+    const LaunchConditions<float> &, vec3, vec3, const AirConstants<float> &,
+    float);
+
+static const LandingFunction
+    LANDING_FUNCTIONS[NUM_WIND_MODEL_TYPES][NUM_INTEGRATOR_TYPES]
+                     [NUM_AERO_MODEL_TYPES] = {
+        {{get_landing<UniformWind, SemiImplicitEuler, TableAero>,
+          get_landing<UniformWind, SemiImplicitEuler, SmoothAero>},
+         {get_landing<UniformWind, Midpoint, TableAero>,
+          get_landing<UniformWind, Midpoint, SmoothAero>}},
+        {{get_landing<LogWind, SemiImplicitEuler, TableAero>,
+          get_landing<LogWind, SemiImplicitEuler, SmoothAero>},
+         {get_landing<LogWind, Midpoint, TableAero>,
+          get_landing<LogWind, Midpoint, SmoothAero>}}};
+
+static const SensitivityFunction
+    SENSITIVITY_FUNCTIONS[NUM_WIND_MODEL_TYPES][NUM_INTEGRATOR_TYPES]
+                         [NUM_AERO_MODEL_TYPES] = {
+        {{get_launch_sensitivities<UniformWind, SemiImplicitEuler, TableAero>,
+          get_launch_sensitivities<UniformWind, SemiImplicitEuler,
+                                   SmoothAero>},
+         {get_launch_sensitivities<UniformWind, Midpoint, TableAero>,
+          get_launch_sensitivities<UniformWind, Midpoint, SmoothAero>}},
+        {{get_launch_sensitivities<LogWind, SemiImplicitEuler, TableAero>,
+          get_launch_sensitivities<LogWind, SemiImplicitEuler, SmoothAero>},
+         {get_launch_sensitivities<LogWind, Midpoint, TableAero>,
+          get_launch_sensitivities<LogWind, Midpoint, SmoothAero>}}};
+
+Landing get_landing(const LaunchConditions<float> &launch, vec3 position,
+                    vec3 wind_velocity, const AirConstants<float> &air,
+                    WindModelType wind_model, IntegratorType integrator,
+                    AeroModelType aero_model, float timestep) {
+
+  return LANDING_FUNCTIONS[static_cast<int>(wind_model)]
+                          [static_cast<int>(integrator)]
+                          [static_cast<int>(aero_model)](
+                              launch, position, wind_velocity, air, timestep);
+
+}
+
+LaunchSensitivities
+get_launch_sensitivities(const LaunchConditions<float> &launch,
+                         vec3 position, vec3 wind_velocity,
+                         const AirConstants<float> &air,
+                         WindModelType wind_model, IntegratorType integrator,
+                         AeroModelType aero_model, float timestep) {
+
+  return SENSITIVITY_FUNCTIONS[static_cast<int>(wind_model)]
+                              [static_cast<int>(integrator)]
+                              [static_cast<int>(aero_model)](
+                                  launch, position, wind_velocity, air,
+                                  timestep);
+
+}
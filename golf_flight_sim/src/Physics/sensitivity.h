@@ -0,0 +1,85 @@
+#pragma once
+
+#include "../math/dual.h"
+#include "../math/vec3.h"
+#include "atmosphere.h"
+#include "launch.h"
+#include "models.h"
+#include <cstdint>
+
+/*
+  Sensitivity mode. Flies a launch to its landing once with dual numbers (see
+  math/dual.h) seeded on every launch input, which gives the landing along
+  with its derivatives with respect to all the inputs in a single pass,
+  instead of the 2N extra runs central finite differences would take.
+
+  The landing is interpolated between the last step above the ground and the
+  first one below it, so the landing (and its derivatives) move smoothly with
+  the inputs rather than jumping a whole timestep at a time.
+
+  Either aerodynamic model can be flown. The table's coefficients are
+  constant between band edges, so its derivatives are those of the model
+  within the current bands, and as the spin rate only acts through the
+  coefficients the derivatives with respect to it are zero. The smooth
+  model's coefficients change with the spin ratio (see aero.h), so it gives
+  the spin rate's real effect.
+*/
+
+enum class LaunchInput : uint8_t {
+  SPEED,
+  ANGLE,
+  HEADING,
+  SPIN_RATE,
+  SPIN_AXIS,
+  NUM_INPUTS
+};
+
+const int NUM_LAUNCH_INPUTS = static_cast<int>(LaunchInput::NUM_INPUTS);
+
+using LaunchDual = dual<float, NUM_LAUNCH_INPUTS>;
+
+// The launch with every input seeded as its own dual input, so one pass
+// through the flight carries the derivatives with respect to all of them
+LaunchConditions<LaunchDual>
+seed_launch_inputs(const LaunchConditions<float> &launch);
+
+// Where and when a ball lands, in meters and seconds
+struct Landing {
+
+  vec3 position;
+
+  // Horizontal distance from the launch position
+  float carry;
+
+  // Distance right of the target line (the x axis), the same sign as the
+  // launch heading
+  float offline;
+
+  float flight_time;
+
+};
+
+struct LaunchSensitivities {
+
+  Landing landing;
+
+  // gradient[i] holds the derivatives of every landing field with respect to
+  // LaunchInput i, in the units of LaunchConditions (m/s, radians and rpm)
+  Landing gradient[NUM_LAUNCH_INPUTS];
+
+};
+
+// The landing of a ball launched from position. wind_velocity is the wind at
+// the reference height, and air the constants for the air at the site.
+Landing get_landing(const LaunchConditions<float> &launch, vec3 position,
+                    vec3 wind_velocity, const AirConstants<float> &air,
+                    WindModelType wind_model, IntegratorType integrator,
+                    AeroModelType aero_model, float timestep);
+
+// The same landing, with its derivatives with respect to every launch input
+LaunchSensitivities
+get_launch_sensitivities(const LaunchConditions<float> &launch,
+                         vec3 position, vec3 wind_velocity,
+                         const AirConstants<float> &air,
+                         WindModelType wind_model, IntegratorType integrator,
+                         AeroModelType aero_model, float timestep);
@@ -0,0 +1,411 @@
+#include "stepper.h"
+#include "../math/simd_math.h"
+#include "../tracy/tracy/Tracy.hpp"
+#include "constants.h"
+#include "flight.h"
+#include "roll.h"
+#include <algorithm>
+#include <cmath>
+
+// Decays every ball's spin from its launch spin rate, a float8 at a time. The
+// ball state is interleaved, so the inputs are gathered into small arrays
+// first.
+static void update_spin_rates(Ball *balls, int count, float spin_decay_rate) {
+
+  const float8 decay_rate(spin_decay_rate);
+
+  float launch_spin_rate[float8::LANES];
+  float elapsed_time[float8::LANES];
+  float spin_rate[float8::LANES];
+
+  for (int i = 0; i < count; i += float8::LANES) {
+
+    int lanes = std::min(float8::LANES, count - i);
+
+    for (int j = 0; j < float8::LANES; j++) {
+      launch_spin_rate[j] = j < lanes ? balls[i + j].launch_spin_rate : 0.0f;
+      elapsed_time[j] = j < lanes ? balls[i + j].elapsed_time : 0.0f;
+    }
+
+    float8 decay = simd_exp(-(float8::load(elapsed_time) / decay_rate));
+    (float8::load(launch_spin_rate) * decay).store(spin_rate);
+
+    for (int j = 0; j < lanes; j++) {
+      balls[i + j].current_spin_rate = spin_rate[j];
+    }
+
+  }
+
+}
+
+/*
+  Rate level selection. The local error of a step grows with how much the
+  aerodynamic forces turn and slow the ball over it, so the step is kept to a
+  small fraction of |v| / |a_aero|, the time the air would take to change the
+  ball's velocity by its own size. That allows coarse steps for most of a
+  flight and fine ones off the tee, after a bounce and at low speed.
+
+  A ball that could reach the ground within two steps always drops to level
+  0, so it lands with the same resolution as before. clearance is its height
+  above the ground, or a lower bound on it.
+*/
+
+// Fraction of |v| / |a_aero| a step may take. Chosen so carries stay within
+// a few centimeters of fixed rate stepping.
+const float RATE_ACCURACY = 0.002f;
+
+int get_aligned_level(uint64_t step) {
+
+  int level = 0;
+
+  while (level < MAX_RATE_LEVEL && (step + 1) % (2ull << level) == 0) {
+    level++;
+  }
+
+  return level;
+
+}
+
+static int get_rate_level(const FlightState<float> &state, float clearance,
+                          float timestep, int max_level) {
+
+  vec3 aero_acceleration = state.acceleration - BALL_WEIGHT * INV_BALL_MASS;
+
+  // Squared so there's no sqrt: h^2 |a_aero|^2 <= (accuracy |v|)^2
+  float aero_acceleration_squared = aero_acceleration.dot(aero_acceleration);
+  float max_change_squared = RATE_ACCURACY * RATE_ACCURACY
+                             * state.velocity.dot(state.velocity);
+
+  int level = 0;
+  float step = timestep;
+
+  while (level < max_level) {
+
+    float next_step = 2.0f * step;
+
+    if (next_step * next_step * aero_acceleration_squared
+        > max_change_squared) {
+      break;
+    }
+
+    if (clearance + 2.0f * next_step * state.velocity.z <= 0.0f) {
+      break;
+    }
+
+    step = next_step;
+    level++;
+
+  }
+
+  return level;
+
+}
+
+void start_roll(Ball &ball, BallRecord &record, const Terrain &terrain,
+                const SurfaceMap &surfaces, const SurfaceTable &table,
+                double start_time) {
+
+  TerrainSample ground = terrain.sample(ball.position.x, ball.position.y);
+  SurfaceMaterial material =
+      surfaces.get_material(ball.position.x, ball.position.y);
+  float deceleration = table.roll_deceleration[static_cast<int>(material)];
+
+  ball.position.z = ground.height;
+  ball.velocity -= ground.normal * ball.velocity.dot(ground.normal);
+
+  // The solution is exact on level ground of one material, so it only needs
+  // solving again where the ground isn't level or the ball may roll onto
+  // another material
+  float max_time = terrain.is_flat() && surfaces.is_uniform()
+                       ? INFINITY
+                       : ROLL_SEGMENT_TIME;
+
+  record.roll = solve_roll(ball.position, ball.velocity, deceleration,
+                           ground.normal, max_time);
+  record.roll_start_time = start_time;
+
+}
+
+void update_roll(Ball &ball, const BallRecord &record, double time) {
+
+  float t = static_cast<float>(time - record.roll_start_time);
+
+  ball.position = get_roll_position(record.roll, t);
+  ball.velocity = get_roll_velocity(record.roll, t);
+
+  if (t >= record.roll.stop_time) {
+    ball.current_spin_rate = 0.0f;
+  }
+
+}
+
+// Puts a ball that ran into an obstacle during its step back where it
+// touched and sends it off again. Spin along the surface is lost in the same
+// proportion as speed.
+static void bounce_off_obstacle(Ball &ball, FlightState<float> &state,
+                                const ObstacleHit &hit) {
+
+  const ObstacleResponse &response =
+      OBSTACLE_RESPONSES[static_cast<int>(hit.material)];
+
+  vec3 normal_velocity = hit.normal * state.velocity.dot(hit.normal);
+  vec3 tangential_velocity = state.velocity - normal_velocity;
+
+  state.position = hit.position;
+  state.velocity = tangential_velocity * response.tangential_retention
+                   - normal_velocity * response.restitution;
+
+  ball.launch_spin_rate *= response.tangential_retention;
+
+}
+
+template <typename WindModel, typename Integrator, typename AeroModel>
+static bool step_flight(Ball *balls, BallRecord *records, int count,
+                        const StepContext &context) {
+
+  ZoneScoped; // for tracy
+
+  bool phases_changed = false;
+
+  const Terrain &terrain = *context.terrain;
+  const float max_ground_height = terrain.get_max_height();
+
+  // Only second order integrators step at coarser levels
+  const int max_level = Integrator::ORDER >= 2 ? context.max_level : 0;
+
+  update_spin_rates(balls, count, context.spin_decay_rate);
+
+  for (int i = 0; i < count; i++) {
+
+    Ball &ball = balls[i];
+
+    /*
+      Flight subroutine
+      Calculates the trajectory of the ball through the air
+    */
+
+    auto get_sum_forces = [&ball, &context](vec3 position, vec3 velocity) {
+      return get_flight_forces<WindModel, AeroModel>(
+                 position, velocity, ball.rotation_axis,
+                 ball.current_spin_rate, context.wind_velocity, context.air)
+          .get_sum();
+    };
+
+    // The integrator also works out the acceleration, which Ball doesn't
+    // keep, so it runs on a local copy
+    FlightState<float> state;
+    state.position = ball.position;
+    state.velocity = ball.velocity;
+
+    Integrator::integrate(state, ball.timestep, get_sum_forces);
+
+    // Checked along the straight line between the two states, which is
+    // within millimeters of the curve even at the coarsest level
+    bool hit_obstacle = false;
+
+    if (context.obstacles != nullptr) {
+
+      ObstacleHit hit;
+
+      if (context.obstacles->sweep(ball.position, state.position, RADIUS,
+                                   hit)) {
+        bounce_off_obstacle(ball, state, hit);
+        hit_obstacle = true;
+      }
+
+    }
+
+    // The first step on the way down is the top of the flight
+    if ((state.velocity.z < 0.0f) && (ball.velocity.z >= 0.0f)) {
+
+      records[i].max_height =
+          state.position.z
+          - terrain.get_height(state.position.x, state.position.y);
+
+      // After a bounce off an obstacle the two velocities are from either
+      // side of it, and there's no top between them to interpolate
+      if (!hit_obstacle) {
+        record_top(records[i].metrics, ball.position, ball.velocity.z,
+                   state.velocity.z, ball.timestep);
+      }
+
+    }
+
+    // For interpolating the landing
+    vec3 previous_position = ball.position;
+    vec3 previous_velocity = ball.velocity;
+
+    ball.position = state.position;
+    ball.velocity = state.velocity;
+    ball.elapsed_time += ball.timestep;
+
+    // Above the highest point of the terrain the ball can't have landed, so
+    // only balls lower down need to look up the ground under them
+    float ground_height = max_ground_height;
+
+    if (ball.position.z <= max_ground_height) {
+      ground_height = terrain.get_height(ball.position.x, ball.position.y);
+    }
+
+    if (ball.position.z > ground_height) {
+
+      // Coarser levels have to wait for their steps to line up. The
+      // forces from before a bounce off an obstacle say nothing about the
+      // flight after it, so it starts again from the finest level.
+      int level = 0;
+
+      if (!hit_obstacle) {
+        level = std::min(get_rate_level(state, ball.position.z - ground_height,
+                                        context.timestep, max_level),
+                         context.aligned_level);
+      }
+
+      float timestep = context.timestep * static_cast<float>(1 << level);
+
+      // Checked against the timestep so the record is only touched when the
+      // level changes
+      if (timestep != ball.timestep) {
+        ball.timestep = timestep;
+        records[i].rate_level = static_cast<uint8_t>(level);
+        phases_changed = true;
+      }
+
+      continue;
+
+    }
+
+    /*
+      The ball has reached the ground. It bounces unless the max height from
+      the previous flight part was less than the specified minimum bounce
+      height of 5 mm, in which case it starts rolling.
+    */
+
+    BallRecord &record = records[i];
+
+    // The fraction of the step before the ball reached the ground, from its
+    // height above the ground at either end
+    float previous_height =
+        previous_position.z
+        - terrain.get_height(previous_position.x, previous_position.y);
+    float fraction = 0.0f;
+
+    if (previous_height > 0.0f) {
+      fraction = previous_height
+                 / (previous_height - (ball.position.z - ground_height));
+    }
+
+    record_landing(
+        record.metrics,
+        previous_position + (ball.position - previous_position) * fraction,
+        previous_velocity + (ball.velocity - previous_velocity) * fraction,
+        ball.elapsed_time - ball.timestep * (1.0f - fraction));
+
+    ball.position.z = ground_height;
+    phases_changed = true;
+
+    // The ball's step ends with this simulation step
+    double step_start_time =
+        context.simulation_time + context.timestep - ball.timestep;
+
+    // Every flight starts at the finest level
+    record.rate_level = 0;
+    ball.timestep = context.timestep;
+
+    if (record.max_height >= MIN_BOUNCE_HEIGHT) {
+      record.phase = BallPhase::IMPACT;
+      continue;
+    }
+
+    record.phase = BallPhase::ROLL;
+
+    // The friction from the surface and the slope of the ground decelerate
+    // the ball uniformly, so solve the roll right here (all of it on level
+    // ground of one material). The roll starts at the beginning of this step.
+    start_roll(ball, record, terrain, *context.surfaces,
+               *context.surface_table, step_start_time);
+
+    update_roll(ball, record, context.simulation_time + context.timestep);
+
+  }
+
+  return phases_changed;
+
+}
+
+void step_impact(Ball *balls, BallRecord *records, int count,
+                 const Terrain &terrain, const SurfaceMap &surfaces,
+                 const SurfaceTable &table, float spin_decay_rate,
+                 ImpactBatch &batch) {
+
+  ZoneScoped; // for tracy
+
+  batch.clear();
+
+  update_spin_rates(balls, count, spin_decay_rate);
+
+  for (int i = 0; i < count; i++) {
+
+    const Ball &ball = balls[i];
+    vec3 normal = terrain.sample(ball.position.x, ball.position.y).normal;
+    SurfaceMaterial material =
+        surfaces.get_material(ball.position.x, ball.position.y);
+
+    batch.add(ball.velocity, ball.rotation_axis, ball.current_spin_rate,
+              normal, material);
+
+  }
+
+  resolve_impacts(batch, table);
+
+  for (int i = 0; i < count; i++) {
+
+    Ball &ball = balls[i];
+
+    // The flight subroutine will be called once again with these values as the
+    // new parameters.
+    ball.velocity = batch.get_velocity(i);
+    ball.rotation_axis = batch.get_rotation_axis(i);
+    ball.launch_spin_rate = batch.spin_rate[i];
+
+    // Set again at the top of the new flight. On a slope the ball can come
+    // down again without ever rising, and then it's too low to bounce.
+    records[i].max_height = 0.0f;
+    records[i].phase = BallPhase::FLIGHT;
+
+  }
+
+}
+
+/*
+  Dispatch tables, indexed by the policy enums in the order they're declared
+  in models.h.
+*/
+
+static const FlightKernel
+    FLIGHT_KERNELS[NUM_WIND_MODEL_TYPES][NUM_INTEGRATOR_TYPES]
+                  [NUM_AERO_MODEL_TYPES] = {
+        {{step_flight<UniformWind, SemiImplicitEuler, TableAero>,
+          step_flight<UniformWind, SemiImplicitEuler, SmoothAero>},
+         {step_flight<UniformWind, Midpoint, TableAero>,
+          step_flight<UniformWind, Midpoint, SmoothAero>}},
+        {{step_flight<LogWind, SemiImplicitEuler, TableAero>,
+          step_flight<LogWind, SemiImplicitEuler, SmoothAero>},
+         {step_flight<LogWind, Midpoint, TableAero>,
+          step_flight<LogWind, Midpoint, SmoothAero>}}};
+
+static constexpr SurfaceTable SURFACE_TABLES[NUM_GROUND_TYPES] = {
+    make_surface_table<SlowGreen>(), make_surface_table<FastGreen>()};
+
+FlightKernel get_flight_kernel(WindModelType wind_model,
+                               IntegratorType integrator,
+                               AeroModelType aero_model) {
+
+  return FLIGHT_KERNELS[static_cast<int>(wind_model)]
+                       [static_cast<int>(integrator)]
+                       [static_cast<int>(aero_model)];
+
+}
+
+const SurfaceTable &get_surface_table(GroundType ground) {
+  return SURFACE_TABLES[static_cast<int>(ground)];
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "../Components/Ball.h"
+#include "../Obstacles/Obstacles.h"
+#include "../Terrain/SurfaceMap.h"
+#include "../Terrain/Terrain.h"
+#include "../math/vec3.h"
+#include "atmosphere.h"
+#include "impact.h"
+#include "models.h"
+#include "surfaces.h"
+#include <cstdint>
+
+/*
+  Phase kernels, specialized at compile time on the wind model, integrator
+  and aerodynamic model (see models.h). Every combination is instantiated up
+  front and stored in a dispatch table, so the simulation looks up the kernel
+  matching its current settings once per step and the loops inside carry no
+  configuration branches.
+
+  The ground model only supplies the green's row of the surface table, which
+  the bounce and the roll read at runtime anyway, so it's passed in with the
+  spin decay rate instead. That way the calibration (see calibration.h) flies
+  its candidates through these same kernels.
+*/
+
+/*
+  Multi-rate stepping. A ball in flight steps at 2^level times the
+  simulation's timestep, for a level from 0 to MAX_RATE_LEVEL picked from its
+  state after every step (see get_rate_level() in stepper.cpp). Steps at level
+  L end together at every 2^L-th simulation step, so a ball can always move
+  to a finer level after a step but only to a coarser one where both levels'
+  steps end.
+
+  Only integrators of second order or higher (Integrator::ORDER) use it.
+  Semi-implicit Euler's error grows with the step whatever the forces, so it
+  always steps at level 0.
+*/
+
+const int NUM_RATE_LEVELS = 4;
+const int MAX_RATE_LEVEL = NUM_RATE_LEVELS - 1;
+
+struct StepContext {
+
+  // Wind velocity at the reference height, in m/s
+  vec3 wind_velocity;
+
+  AirConstants<float> air;
+
+  // SPIN_DECAY_RATE unless it's being calibrated
+  float spin_decay_rate;
+
+  // Every material's bounce and roll coefficients (see get_surface_table())
+  const SurfaceTable *surface_table;
+
+  // The simulation's timestep, i.e. rate level 0
+  float timestep;
+
+  // Simulation time at the start of the step
+  double simulation_time;
+
+  // The coarsest level whose steps end with this simulation step
+  int aligned_level;
+
+  // The coarsest level balls may use. 0 steps every ball at the simulation's
+  // timestep.
+  int max_level;
+
+  const Terrain *terrain;
+  const SurfaceMap *surfaces;
+
+  // nullptr if there aren't any
+  const Obstacles *obstacles;
+
+};
+
+// How long a roll on sloped ground goes before it's solved again for the
+// surface under the ball (see roll.h), in seconds
+const float ROLL_SEGMENT_TIME = 0.1f;
+
+// The coarsest level whose steps end when simulation step number step (from
+// 0) does
+int get_aligned_level(uint64_t step);
+
+// Integrates count balls in flight, each by its own timestep, and picks
+// their next rate level. Balls that run into an obstacle bounce off it. Balls
+// that reach the ground get their phase set to IMPACT or ROLL in their
+// record. Returns whether any ball changed phase or
+// rate level.
+using FlightKernel = bool (*)(Ball *balls, BallRecord *records, int count,
+                              const StepContext &context);
+
+FlightKernel get_flight_kernel(WindModelType wind_model,
+                               IntegratorType integrator,
+                               AeroModelType aero_model);
+
+// Bounces count balls in the impact phase off the terrain, each on the
+// material under it with the coefficients from table, and puts them back in
+// flight. batch is scratch space.
+void step_impact(Ball *balls, BallRecord *records, int count,
+                 const Terrain &terrain, const SurfaceMap &surfaces,
+                 const SurfaceTable &table, float spin_decay_rate,
+                 ImpactBatch &batch);
+
+// The materials' coefficients with the given ground model's green
+const SurfaceTable &get_surface_table(GroundType ground);
+
+// Solves a roll from the ball's position and velocity, starting at the given
+// simulation time, with the rolling friction of the material under the ball.
+// The ball is put on the terrain and its velocity along it first.
+void start_roll(Ball &ball, BallRecord &record, const Terrain &terrain,
+                const SurfaceMap &surfaces, const SurfaceTable &table,
+                double start_time);
+
+// Sets a rolling ball's state from its roll solution at the given simulation
+// time.
+void update_roll(Ball &ball, const BallRecord &record, double time);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "constants.h"
+#include "models.h"
+#include <cstdint>
+
+// What the ground is covered with. Where each one is comes from a SurfaceMap
+// (see Terrain/SurfaceMap.h).
+enum class SurfaceMaterial : uint8_t {
+  GREEN,
+  FAIRWAY,
+  ROUGH,
+  BUNKER,
+  NUM_MATERIALS
+};
+
+const int NUM_SURFACE_MATERIALS =
+    static_cast<int>(SurfaceMaterial::NUM_MATERIALS);
+
+/*
+  How a ball bounces and rolls on every material, as structure of arrays
+  indexed by material. A batch of impacts gathers each coefficient for its
+  lanes straight from its row (see gather() in math/generic.h), and a row is
+  only NUM_SURFACE_MATERIALS floats, so the whole table stays in cache.
+
+  The green is the surface the simulation has always had, so its row comes
+  from the ground model (see models.h) and its roll follows the green speed.
+*/
+struct SurfaceTable {
+
+  // Scales the coefficient of restitution from
+  // get_coefficient_of_restitution()
+  float restitution[NUM_SURFACE_MATERIALS];
+
+  // How far the surface gives under the ball, which tilts the plane it
+  // bounces off (theta_c in resolve_impacts())
+  float firmness[NUM_SURFACE_MATERIALS];
+
+  // Coefficient of sliding friction during the impact
+  float friction[NUM_SURFACE_MATERIALS];
+
+  // Rolling friction's deceleration on level ground, in m/s^2
+  float roll_deceleration[NUM_SURFACE_MATERIALS];
+
+};
+
+// The deceleration rolling friction with the given coefficient causes, the
+// same way as the ground models
+constexpr float get_roll_deceleration(float roll_friction) {
+  return (5.0f / 7.0f) * roll_friction * BALL_WEIGHT_MAGNITUDE
+         * INV_BALL_MASS;
+}
+
+template <typename GroundModel> constexpr SurfaceTable make_surface_table() {
+
+  // In the order GREEN, FAIRWAY, ROUGH, BUNKER. Fairways are firmer than
+  // greens and run out further, rough grabs the ball, and sand soaks up most
+  // of the bounce and stops the roll within a meter or two.
+  return SurfaceTable{
+      {1.0f, 1.1f, 0.7f, 0.25f},
+      {GroundModel::FIRMNESS, 0.014f, 0.025f, 0.045f},
+      {GroundModel::FRICTION, 0.45f, 0.6f, 0.8f},
+      {GroundModel::ROLL_DECELERATION, get_roll_deceleration(0.25f),
+       get_roll_deceleration(0.6f), get_roll_deceleration(1.5f)}};
+
+}
@@ -0,0 +1,305 @@
+#include "Profiler.h"
+
+#ifdef PROFILER_ENABLE
+
+#include "../../lib/imgui/imgui.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define PROFILER_USE_RDTSC
+#endif
+
+namespace profiler {
+
+namespace {
+
+const int NUM_SECTIONS = static_cast<int>(Section::NUM_SECTIONS);
+
+const char *SECTION_NAMES[NUM_SECTIONS] = {
+    "input", "update", "draw_primitives", "imgui", "present", "sleep"};
+
+// Single producer (the owning thread), single consumer (the main thread in
+// end_frame). The capacity has to be a power of two so the indices can wrap
+// with a mask.
+struct ThreadBuffer {
+
+  static const uint32_t CAPACITY = 1024;
+
+  Sample samples[CAPACITY];
+  std::atomic<uint32_t> head{0};
+  std::atomic<uint32_t> tail{0};
+  std::atomic<uint32_t> dropped{0};
+
+};
+
+const int MAX_THREADS = 16;
+
+// Thread buffers are registered once and live for the rest of the program, so
+// the reader never has to worry about a buffer disappearing under it.
+std::array<std::atomic<ThreadBuffer *>, MAX_THREADS> thread_buffers{};
+std::atomic<int> num_thread_buffers{0};
+
+ThreadBuffer *get_thread_buffer() {
+
+  thread_local ThreadBuffer *buffer = nullptr;
+
+  if (buffer == nullptr) {
+
+    int slot = num_thread_buffers.fetch_add(1, std::memory_order_relaxed);
+
+    // Ran out of slots: samples from this thread are dropped.
+    if (slot >= MAX_THREADS) {
+      return nullptr;
+    }
+
+    buffer = new ThreadBuffer();
+    thread_buffers[slot].store(buffer, std::memory_order_release);
+
+  }
+
+  return buffer;
+
+}
+
+// Number of frames kept for the min/avg/p99 statistics.
+const int HISTORY_SIZE = 240;
+
+struct FrameHistory {
+
+  // Per-section time in milliseconds for each frame in the history window
+  float section_ms[NUM_SECTIONS][HISTORY_SIZE] = {};
+  float frame_ms[HISTORY_SIZE] = {};
+  int num_frames = 0;
+  int next_frame = 0;
+
+  // Accumulated time for the frame currently being recorded, in ticks
+  uint64_t current_ticks[NUM_SECTIONS] = {};
+  uint64_t frame_start_ticks = 0;
+
+  uint32_t dropped_samples = 0;
+
+};
+
+FrameHistory history;
+
+// Timestamp calibration. When the timestamp counter is used the tick rate is
+// measured against steady_clock over the lifetime of the program.
+const uint64_t calibration_start_ticks = now_ticks();
+const auto calibration_start_time = std::chrono::steady_clock::now();
+double ms_per_tick = 1e-6;
+
+void update_calibration(uint64_t ticks) {
+
+#ifdef PROFILER_USE_RDTSC
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - calibration_start_time;
+  uint64_t elapsed_ticks = ticks - calibration_start_ticks;
+
+  if (elapsed_ticks > 0 && elapsed.count() > 0.0) {
+    ms_per_tick = elapsed.count() / static_cast<double>(elapsed_ticks);
+  }
+#endif
+
+}
+
+struct Stats {
+  float last;
+  float min;
+  float avg;
+  float p99;
+};
+
+Stats get_stats(const float *values, int num_values, int newest) {
+
+  Stats stats = {values[newest], values[0], 0.0f, 0.0f};
+
+  if (num_values == 0) {
+    return stats;
+  }
+
+  std::array<float, HISTORY_SIZE> sorted;
+  std::copy(values, values + num_values, sorted.begin());
+
+  float sum = 0.0f;
+
+  for (int i = 0; i < num_values; i++) {
+    sum += sorted[i];
+    stats.min = std::min(stats.min, sorted[i]);
+  }
+
+  stats.avg = sum / static_cast<float>(num_values);
+
+  int p99_index = (num_values * 99) / 100;
+  std::nth_element(sorted.begin(), sorted.begin() + p99_index,
+                   sorted.begin() + num_values);
+  stats.p99 = sorted[p99_index];
+
+  return stats;
+
+}
+
+} // namespace
+
+uint64_t now_ticks() {
+
+#ifdef PROFILER_USE_RDTSC
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(
+      std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+
+}
+
+void record(Section section, uint64_t start, uint64_t end) {
+
+  ThreadBuffer *buffer = get_thread_buffer();
+
+  if (buffer == nullptr) {
+    return;
+  }
+
+  uint32_t head = buffer->head.load(std::memory_order_relaxed);
+  uint32_t tail = buffer->tail.load(std::memory_order_acquire);
+
+  if (head - tail >= ThreadBuffer::CAPACITY) {
+    buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  buffer->samples[head & (ThreadBuffer::CAPACITY - 1)] = {start, end, section};
+  buffer->head.store(head + 1, std::memory_order_release);
+
+}
+
+void end_frame() {
+
+  uint64_t frame_end_ticks = now_ticks();
+
+  // Drain every registered thread buffer into the current frame's totals
+  int num_buffers = std::min(
+      num_thread_buffers.load(std::memory_order_relaxed), MAX_THREADS);
+
+  for (int i = 0; i < num_buffers; i++) {
+
+    ThreadBuffer *buffer = thread_buffers[i].load(std::memory_order_acquire);
+
+    if (buffer == nullptr) {
+      continue;
+    }
+
+    uint32_t tail = buffer->tail.load(std::memory_order_relaxed);
+    uint32_t head = buffer->head.load(std::memory_order_acquire);
+
+    for (; tail != head; tail++) {
+      const Sample &sample =
+          buffer->samples[tail & (ThreadBuffer::CAPACITY - 1)];
+      history.current_ticks[static_cast<int>(sample.section)] +=
+          sample.end - sample.start;
+    }
+
+    buffer->tail.store(tail, std::memory_order_release);
+    history.dropped_samples +=
+        buffer->dropped.exchange(0, std::memory_order_relaxed);
+
+  }
+
+  update_calibration(frame_end_ticks);
+
+  // Close the frame and push its totals into the history
+  int frame = history.next_frame;
+
+  for (int i = 0; i < NUM_SECTIONS; i++) {
+    history.section_ms[i][frame] =
+        static_cast<float>(history.current_ticks[i] * ms_per_tick);
+    history.current_ticks[i] = 0;
+  }
+
+  if (history.frame_start_ticks != 0) {
+    history.frame_ms[frame] = static_cast<float>(
+        (frame_end_ticks - history.frame_start_ticks) * ms_per_tick);
+  }
+
+  history.frame_start_ticks = frame_end_ticks;
+  history.next_frame = (frame + 1) % HISTORY_SIZE;
+  history.num_frames = std::min(history.num_frames + 1, HISTORY_SIZE);
+
+}
+
+void draw_overlay() {
+
+  ImGui::SetNextWindowPos(ImVec2(500, 206), ImGuiCond_Once);
+  ImGui::SetNextWindowBgAlpha(0.6f);
+
+  if (ImGui::Begin("Profiler", nullptr,
+                   ImGuiWindowFlags_AlwaysAutoResize
+                       | ImGuiWindowFlags_NoCollapse
+                       | ImGuiWindowFlags_NoSavedSettings)) {
+
+    int newest = (history.next_frame + HISTORY_SIZE - 1) % HISTORY_SIZE;
+
+    if (ImGui::BeginTable("profiler_sections", 5,
+                          ImGuiTableFlags_SizingFixedFit)) {
+
+      ImGui::TableSetupColumn("Section (ms)");
+      ImGui::TableSetupColumn("Last");
+      ImGui::TableSetupColumn("Min");
+      ImGui::TableSetupColumn("Avg");
+      ImGui::TableSetupColumn("p99");
+      ImGui::TableHeadersRow();
+
+      for (int i = 0; i <= NUM_SECTIONS; i++) {
+
+        // The last row is the whole frame
+        const float *values =
+            (i < NUM_SECTIONS) ? history.section_ms[i] : history.frame_ms;
+        const char *name = (i < NUM_SECTIONS) ? SECTION_NAMES[i] : "frame";
+
+        Stats stats = get_stats(values, history.num_frames, newest);
+
+        ImGui::TableNextRow();
+        ImGui::TableSetColumnIndex(0);
+        ImGui::TextUnformatted(name);
+        ImGui::TableSetColumnIndex(1);
+        ImGui::Text("%.3f", stats.last);
+        ImGui::TableSetColumnIndex(2);
+        ImGui::Text("%.3f", stats.min);
+        ImGui::TableSetColumnIndex(3);
+        ImGui::Text("%.3f", stats.avg);
+        ImGui::TableSetColumnIndex(4);
+        ImGui::Text("%.3f", stats.p99);
+
+      }
+
+      ImGui::EndTable();
+
+    }
+
+    // Rolling frame time graph, oldest frame on the left
+    ImGui::PlotLines("##frame_ms", history.frame_ms, history.num_frames,
+                     history.num_frames == HISTORY_SIZE ? history.next_frame
+                                                        : 0,
+                     "frame time (ms)", 0.0f, FLT_MAX, ImVec2(0, 40));
+
+    if (history.dropped_samples > 0) {
+      ImGui::Text("Dropped samples: %u", history.dropped_samples);
+    }
+
+  }
+
+  ImGui::End();
+
+}
+
+} // namespace profiler
+
+#endif
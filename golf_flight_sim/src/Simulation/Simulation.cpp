@@ -0,0 +1,852 @@
+#include "Simulation.h"
+#include "../Physics/constants.h"
+#include "../Physics/flight.h"
+#include "../Physics/roll.h"
+#include "../Physics/stepper.h"
+#include "../Profiler/Profiler.h"
+#include "../math/unit_conversion.h"
+#include "../tracy/tracy/Tracy.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+Simulation::Simulation(float timestep, const Wind &wind)
+    : wind(wind), terrain(std::make_shared<Terrain>()),
+      surface_map(std::make_shared<SurfaceMap>()) {
+
+  this->timestep = timestep;
+  this->air = REFERENCE_AIR;
+  this->integrator = IntegratorType::SEMI_IMPLICIT_EULER;
+  this->ground = GroundType::SLOW_GREEN;
+  this->aero_model = AeroModelType::TABLE;
+  this->surface_table = get_surface_table(ground);
+  this->spin_decay_rate = SPIN_DECAY_RATE;
+  this->adaptive_stepping = true;
+  this->next_ball_id = 0;
+  this->phases_changed = false;
+  this->step_count = 0;
+  this->simulation_time = 0.0;
+  this->is_running = false;
+  this->timing_phases = false;
+  this->diagnostics_request = {};
+
+  std::fill(std::begin(phase_begin), std::end(phase_begin), 0);
+  std::fill(std::begin(rate_begin), std::end(rate_begin), 0);
+
+}
+
+Simulation::~Simulation() {
+  stop();
+}
+
+void Simulation::start() {
+
+  if (is_running) {
+    return;
+  }
+
+  is_running = true;
+  thread = std::thread(&Simulation::run, this);
+
+}
+
+void Simulation::stop() {
+
+  is_running = false;
+
+  if (thread.joinable()) {
+    thread.join();
+  }
+
+}
+
+void Simulation::run() {
+
+  tracy::SetThreadName("Physics");
+
+  using clock = std::chrono::steady_clock;
+
+  const auto step_duration = std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>(static_cast<double>(timestep)));
+
+  clock::time_point next_step = clock::now();
+
+  while (is_running) {
+
+    // Run however many steps are due. If we've fallen too far behind, drop
+    // the backlog instead of spiralling.
+    int steps_taken = 0;
+
+    while (clock::now() >= next_step && steps_taken < MAX_CATCH_UP_STEPS) {
+
+      process_commands();
+      step();
+      publish_snapshot();
+
+      next_step += step_duration;
+      steps_taken++;
+
+    }
+
+    if (steps_taken == MAX_CATCH_UP_STEPS) {
+      next_step = clock::now() + step_duration;
+    }
+
+    std::this_thread::sleep_until(next_step);
+
+  }
+
+}
+
+void Simulation::process_commands() {
+
+  SimulationCommand command;
+
+  while (commands.pop(command)) {
+
+    switch (command.type) {
+
+    case SimulationCommand::Type::LAUNCH_BALL:
+      balls.emplace_back(command.position, command.velocity,
+                         command.rotation_axis, command.spin_rate, timestep);
+      records.emplace_back(next_ball_id++, command.position);
+      phases_changed = true;
+      break;
+
+    case SimulationCommand::Type::CLEAR_BALLS:
+      balls.clear();
+      records.clear();
+      next_ball_id = 0;
+      phases_changed = true;
+
+      // Nothing depends on the clock without any balls, and starting it
+      // again keeps roll times precise in a simulation reused for many shots
+      step_count = 0;
+      simulation_time = 0.0;
+      break;
+
+    case SimulationCommand::Type::SET_WIND:
+      wind.speed = command.wind_speed;
+      wind.direction = command.wind_direction;
+      wind.log_wind = command.log_wind;
+      break;
+
+    case SimulationCommand::Type::SET_AIR:
+      air = command.air;
+      break;
+
+    case SimulationCommand::Type::SET_MODELS:
+      integrator = command.integrator;
+      ground = command.ground;
+      aero_model = command.aero_model;
+      surface_table = get_surface_table(ground);
+      break;
+
+    case SimulationCommand::Type::SET_SPIN_DECAY_RATE:
+      spin_decay_rate = command.spin_decay_rate;
+      break;
+
+    case SimulationCommand::Type::SET_SURFACE_TABLE:
+      surface_table = command.surface_table;
+      break;
+
+    case SimulationCommand::Type::SET_ADAPTIVE_STEPPING:
+      adaptive_stepping = command.adaptive_stepping;
+      break;
+
+    case SimulationCommand::Type::SET_TERRAIN:
+      terrain = std::move(command.terrain);
+      terrain_streamer.reset();
+      break;
+
+    case SimulationCommand::Type::SET_TERRAIN_STREAMER:
+      terrain_streamer = std::move(command.terrain_streamer);
+      // Shares ownership with the streamer it's part of
+      terrain = std::shared_ptr<const Terrain>(
+          terrain_streamer, &terrain_streamer->get_terrain());
+      break;
+
+    case SimulationCommand::Type::SET_OBSTACLES:
+      obstacles = std::move(command.obstacles);
+      break;
+
+    case SimulationCommand::Type::SET_SURFACE_MAP:
+      surface_map = std::move(command.surface_map);
+      break;
+
+    case SimulationCommand::Type::SET_DIAGNOSTICS:
+      diagnostics_request = command.diagnostics;
+      break;
+
+    }
+
+  }
+
+}
+
+vec3 Simulation::get_wind_velocity() const {
+
+  // The wind is the same for every ball, so the trig only needs doing once.
+  // We only convert the wind speed here because we need it in mph for
+  // everything else (the UI stuff).
+  float wind_speed_ms = mph_to_ms(wind.speed);
+
+  return vec3(wind_speed_ms * cosf(wind.direction),
+              wind_speed_ms * sinf(wind.direction), 0.0f);
+
+}
+
+bool Simulation::is_diagnosed(const Ball &ball,
+                              const BallRecord &record) const {
+
+  const DiagnosticsRequest &request = diagnostics_request;
+
+  if (record.id >= request.first_id && record.id < request.last_id) {
+    return true;
+  }
+
+  if (!request.on_screen) {
+    return false;
+  }
+
+  const ViewBounds &view = request.view;
+
+  return ball.position.x >= view.min_x && ball.position.x <= view.max_x
+         && (ball.position.z <= view.max_z
+             || std::fabs(ball.position.y) <= view.max_abs_y);
+
+}
+
+BallDiagnostics Simulation::get_diagnostics(const Ball &ball,
+                                            const BallRecord &record) const {
+
+  BallDiagnostics diagnostics = {};
+
+  if (record.phase == BallPhase::ROLL || record.phase == BallPhase::REST) {
+    diagnostics.acceleration = get_roll_acceleration(
+        record.roll,
+        static_cast<float>(simulation_time - record.roll_start_time));
+    return diagnostics;
+  }
+
+  // The forces at the ball's current state, which is where the next step
+  // starts from
+  auto get_forces = [&](auto wind_model, auto aero_model) {
+    return get_flight_forces<decltype(wind_model), decltype(aero_model)>(
+        ball.position, ball.velocity, ball.rotation_axis,
+        ball.current_spin_rate, get_wind_velocity(), air);
+  };
+
+  bool smooth = aero_model == AeroModelType::SMOOTH;
+
+  FlightForces<float> forces =
+      wind.log_wind
+          ? (smooth ? get_forces(LogWind(), SmoothAero())
+                    : get_forces(LogWind(), TableAero()))
+          : (smooth ? get_forces(UniformWind(), SmoothAero())
+                    : get_forces(UniformWind(), TableAero()));
+
+  diagnostics.acceleration = forces.get_sum() * INV_BALL_MASS;
+  diagnostics.wind_velocity = forces.wind_velocity;
+  diagnostics.lift_force = forces.lift_force;
+  diagnostics.drag_force = forces.drag_force;
+
+  return diagnostics;
+
+}
+
+void Simulation::publish_snapshot() {
+
+  ZoneScoped; // for tracy
+
+  SimulationSnapshot &snapshot = snapshots.get_back();
+
+  // resize() keeps the capacity around, so this only allocates when the
+  // number of balls grows past what the buffer has seen before.
+  snapshot.balls.resize(balls.size());
+  snapshot.diagnostics.clear();
+
+  for (size_t i = 0; i < balls.size(); i++) {
+
+    const Ball &ball = balls[i];
+    const BallRecord &record = records[i];
+
+    BallSnapshot &ball_snapshot = snapshot.balls[record.id];
+
+    if (record.phase == BallPhase::ROLL) {
+
+      // Rolling balls aren't touched by step(), evaluate them for display
+      float t = static_cast<float>(simulation_time - record.roll_start_time);
+      ball_snapshot.position = get_roll_position(record.roll, t);
+      ball_snapshot.velocity = get_roll_velocity(record.roll, t);
+
+    } else if (record.phase == BallPhase::FLIGHT) {
+
+      // A ball on a coarse level is partway through its step, so its state
+      // is from up to 2^rate_level - 1 steps ago. Carry it forward to now
+      // so it doesn't stutter on screen.
+      uint64_t steps_behind = step_count % (1ull << record.rate_level);
+      float lag = static_cast<float>(steps_behind) * timestep;
+
+      ball_snapshot.position = ball.position + ball.velocity * lag;
+      ball_snapshot.velocity = ball.velocity;
+
+    } else {
+
+      ball_snapshot.position = ball.position;
+      ball_snapshot.velocity = ball.velocity;
+
+    }
+
+    ball_snapshot.current_spin_rate = ball.current_spin_rate;
+    ball_snapshot.carry = record.metrics.num_landings > 0
+                              ? record.metrics.carry
+                              : NAN;
+    ball_snapshot.total = record.metrics.at_rest ? record.metrics.total : NAN;
+    ball_snapshot.phase = record.phase;
+    ball_snapshot.is_rolling =
+        record.phase == BallPhase::ROLL || record.phase == BallPhase::REST;
+
+    // The diagnostics are only worked out for the balls being displayed
+    ball_snapshot.diagnostics = -1;
+
+    if (is_diagnosed(ball, record)) {
+      ball_snapshot.diagnostics =
+          static_cast<int>(snapshot.diagnostics.size());
+      snapshot.diagnostics.push_back(get_diagnostics(ball, record));
+    }
+
+  }
+
+  snapshot.phase_stats = phase_stats;
+  snapshot.terrain_streamed = terrain_streamer != nullptr;
+
+  if (terrain_streamer) {
+    snapshot.terrain_cache = terrain_streamer->get_stats();
+  }
+
+  snapshot.step_count = step_count;
+  snapshot.simulation_time = simulation_time;
+
+  snapshots.publish();
+
+}
+
+void Simulation::run_until(BallPhase phase, float max_time) {
+
+  process_commands();
+
+  double end_time = simulation_time + max_time;
+
+  // The phases are in the order balls go through them
+  while (simulation_time < end_time) {
+
+    bool all_reached = true;
+
+    for (const BallRecord &record : records) {
+      all_reached &= record.phase >= phase;
+    }
+
+    if (all_reached) {
+      break;
+    }
+
+    step();
+
+  }
+
+}
+
+void Simulation::run_until_rolling(float max_time) {
+  run_until(BallPhase::ROLL, max_time);
+}
+
+void Simulation::run_until_resting(float max_time) {
+
+  // Clearing the balls starts the clock again
+  process_commands();
+
+  double end_time = simulation_time + max_time;
+
+  run_until(BallPhase::ROLL, max_time);
+  settle_rolls();
+
+  // Whatever's left is rolling over uneven ground or material boundaries
+  run_until(BallPhase::REST, static_cast<float>(end_time - simulation_time));
+
+}
+
+void Simulation::settle_rolls() {
+
+  for (size_t i = 0; i < records.size(); i++) {
+
+    BallRecord &record = records[i];
+
+    if (record.phase != BallPhase::ROLL || !record.roll.comes_to_rest) {
+      continue;
+    }
+
+    Ball &ball = balls[i];
+
+    ball.position = record.roll.end_position;
+    ball.velocity = vec3(0.0f, 0.0f, 0.0f);
+    ball.current_spin_rate = 0.0f;
+
+    record.phase = BallPhase::REST;
+    record_rest(record.metrics, ball.position);
+    phases_changed = true;
+
+  }
+
+}
+
+const std::vector<Ball> &Simulation::get_balls() const {
+  return balls;
+}
+
+const std::vector<BallRecord> &Simulation::get_records() const {
+  return records;
+}
+
+void Simulation::get_shot_metrics(std::vector<ShotMetrics> &metrics) const {
+
+  metrics.resize(records.size());
+
+  for (const BallRecord &record : records) {
+    metrics[record.id] = record.metrics;
+  }
+
+}
+
+bool Simulation::launch_ball(vec3 position, vec3 velocity, vec3 rotation_axis,
+                             float spin_rate) {
+
+  SimulationCommand command = {};
+  command.type = SimulationCommand::Type::LAUNCH_BALL;
+  command.position = position;
+  command.velocity = velocity;
+  command.rotation_axis = rotation_axis;
+  command.spin_rate = spin_rate;
+
+  return commands.push(command);
+
+}
+
+bool Simulation::clear_balls() {
+
+  SimulationCommand command = {};
+  command.type = SimulationCommand::Type::CLEAR_BALLS;
+
+  return commands.push(command);
+
+}
+
+bool Simulation::set_wind(const Wind &wind) {
+
+  SimulationCommand command = {};
+  command.type = SimulationCommand::Type::SET_WIND;
+  command.wind_speed = wind.speed;
+  command.wind_direction = wind.direction;
+  command.log_wind = wind.log_wind;
+
+  return commands.push(command);
+
+}
+
+bool Simulation::set_air(const SiteConditions &site) {
+
+  SimulationCommand command = {};
+  command.type = SimulationCommand::Type::SET_AIR;
+  command.air = get_air_constants(site);
+
+  return commands.push(command);
+
+}
+
+bool Simulation::set_air(const AirConstants<float> &air) {
+
+  SimulationCommand command = {};
+  command.type = SimulationCommand::Type::SET_AIR;
+  command.air = air;
+
+  return commands.push(command);
+
+}
+
+bool Simulation::set_models(IntegratorType integrator, GroundType ground,
+                            AeroModelType aero_model) {
+
+  SimulationCommand command = {};
+  command.type = SimulationCommand::Type::SET_MODELS;
+  command.integrator = integrator;
+  command.ground = ground;
+  command.aero_model = aero_model;
+
+  return commands.push(command);
+
+}
+
+bool Simulation::set_spin_decay_rate(float spin_decay_rate) {
+
+  SimulationCommand command = {};
+  command.type = SimulationCommand::Type::SET_SPIN_DECAY_RATE;
+  command.spin_decay_rate = spin_decay_rate;
+
+  return commands.push(command);
+
+}
+
+bool Simulation::set_surface_table(const SurfaceTable &table) {
+
+  SimulationCommand command = {};
+  command.type = SimulationCommand::Type::SET_SURFACE_TABLE;
+  command.surface_table = table;
+
+  return commands.push(command);
+
+}
+
+bool Simulation::set_adaptive_stepping(bool adaptive_stepping) {
+
+  SimulationCommand command = {};
+  command.type = SimulationCommand::Type::SET_ADAPTIVE_STEPPING;
+  command.adaptive_stepping = adaptive_stepping;
+
+  return commands.push(command);
+
+}
+
+bool Simulation::set_terrain(std::shared_ptr<const Terrain> terrain) {
+
+  SimulationCommand command = {};
+  command.type = SimulationCommand::Type::SET_TERRAIN;
+  command.terrain = std::move(terrain);
+
+  return commands.push(command);
+
+}
+
+bool Simulation::set_terrain_streamer(
+    std::shared_ptr<TerrainStreamer> streamer) {
+
+  SimulationCommand command = {};
+  command.type = SimulationCommand::Type::SET_TERRAIN_STREAMER;
+  command.terrain_streamer = std::move(streamer);
+
+  return commands.push(command);
+
+}
+
+bool Simulation::set_obstacles(std::shared_ptr<const Obstacles> obstacles) {
+
+  SimulationCommand command = {};
+  command.type = SimulationCommand::Type::SET_OBSTACLES;
+  command.obstacles = std::move(obstacles);
+
+  return commands.push(command);
+
+}
+
+bool Simulation::set_surface_map(
+    std::shared_ptr<const SurfaceMap> surface_map) {
+
+  SimulationCommand command = {};
+  command.type = SimulationCommand::Type::SET_SURFACE_MAP;
+  command.surface_map = std::move(surface_map);
+
+  return commands.push(command);
+
+}
+
+bool Simulation::set_diagnostics(const DiagnosticsRequest &request) {
+
+  SimulationCommand command = {};
+  command.type = SimulationCommand::Type::SET_DIAGNOSTICS;
+  command.diagnostics = request;
+
+  return commands.push(command);
+
+}
+
+const SimulationSnapshot &Simulation::acquire_snapshot() {
+  return snapshots.acquire();
+}
+
+
+// Reads the clock only if the phases are being timed
+static std::chrono::steady_clock::time_point start_timer(bool timed) {
+
+  return timed ? std::chrono::steady_clock::now()
+               : std::chrono::steady_clock::time_point();
+
+}
+
+static float elapsed_us(std::chrono::steady_clock::time_point start) {
+
+  std::chrono::duration<float, std::micro> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+
+}
+
+void Simulation::partition_phases() {
+
+  if (!phases_changed) {
+    return;
+  }
+
+  ZoneScoped; // for tracy
+
+  auto start = start_timer(timing_phases);
+
+  /*
+    Counting sort by phase, with the flight range split up by rate level.
+    Balls in flight get keys 0 to MAX_RATE_LEVEL and the other phases follow
+    on from there. Balls keep their relative order within a key.
+
+    It's one pass to count the keys and one to move the balls.
+  */
+  const int num_keys = NUM_RATE_LEVELS + NUM_BALL_PHASES - 1;
+
+  auto get_key = [](const BallRecord &record) {
+    return record.phase == BallPhase::FLIGHT
+               ? static_cast<int>(record.rate_level)
+               : MAX_RATE_LEVEL + static_cast<int>(record.phase);
+  };
+
+  int key_begin[num_keys + 1] = {};
+
+  for (const BallRecord &record : records) {
+    key_begin[get_key(record) + 1]++;
+  }
+
+  for (int key = 0; key < num_keys; key++) {
+    key_begin[key + 1] += key_begin[key];
+  }
+
+  if (!balls.empty()) {
+
+    // Every element is overwritten below, the fill value doesn't matter
+    partition_scratch.resize(balls.size(), balls.front());
+    record_scratch.resize(records.size(), records.front());
+
+    int next[num_keys];
+    std::copy(key_begin, key_begin + num_keys, next);
+
+    for (size_t i = 0; i < balls.size(); i++) {
+
+      int destination = next[get_key(records[i])]++;
+
+      partition_scratch[destination] = balls[i];
+      record_scratch[destination] = records[i];
+
+    }
+
+  }
+
+  for (int level = 0; level <= NUM_RATE_LEVELS; level++) {
+    rate_begin[level] = key_begin[level];
+  }
+
+  for (int phase = 0; phase <= NUM_BALL_PHASES; phase++) {
+    phase_begin[phase] = key_begin[phase == 0 ? 0 : MAX_RATE_LEVEL + phase];
+  }
+
+  if (!balls.empty()) {
+    balls.swap(partition_scratch);
+    records.swap(record_scratch);
+  }
+
+  phases_changed = false;
+
+  if (timing_phases) {
+    phase_stats.partition_time_us += elapsed_us(start);
+  }
+
+}
+
+void Simulation::step_flight() {
+
+  // Only the levels whose steps end with this one are due, and they're at
+  // the front of the flight range
+  int aligned_level = get_aligned_level(step_count);
+
+  int begin = phase_begin[static_cast<int>(BallPhase::FLIGHT)];
+  int end = rate_begin[aligned_level + 1];
+
+  phase_stats.flight_steps = end - begin;
+
+  if (begin == end) {
+    return;
+  }
+
+  StepContext context;
+  context.wind_velocity = get_wind_velocity();
+  context.air = air;
+  context.spin_decay_rate = spin_decay_rate;
+  context.surface_table = &surface_table;
+  context.timestep = timestep;
+  context.simulation_time = simulation_time;
+  context.aligned_level = aligned_level;
+  context.max_level = adaptive_stepping ? MAX_RATE_LEVEL : 0;
+  context.terrain = terrain.get();
+  context.surfaces = surface_map.get();
+  context.obstacles =
+      obstacles && !obstacles->is_empty() ? obstacles.get() : nullptr;
+
+  WindModelType wind_model =
+      wind.log_wind ? WindModelType::LOGARITHMIC : WindModelType::UNIFORM;
+  FlightKernel step_flight_kernel =
+      get_flight_kernel(wind_model, integrator, aero_model);
+
+  if (step_flight_kernel(&balls[begin], &records[begin], end - begin,
+                         context)) {
+    phases_changed = true;
+  }
+
+}
+
+void Simulation::step_impact() {
+
+  int begin = phase_begin[static_cast<int>(BallPhase::IMPACT)];
+  int end = phase_begin[static_cast<int>(BallPhase::IMPACT) + 1];
+
+  if (begin == end) {
+    return;
+  }
+
+  /*
+    Bounce subroutine
+
+    We can simplify the collision of the ball bouncing against the ground to a
+    2D equation by defining a new frame of reference upon ground impact, where
+    the x unit vector points along the direction of the velocity vector, the y
+    unit vector points along the normal vector of the surface that the ball is
+    colliding against, and the z vector perpendicular to unit vectors x and y.
+    See resolve_impacts() for the details.
+  */
+
+  ::step_impact(&balls[begin], &records[begin], end - begin, *terrain,
+                *surface_map, surface_table, spin_decay_rate, impact_batch);
+
+  phases_changed = true;
+
+}
+
+void Simulation::step_roll() {
+
+  ZoneScoped; // for tracy
+
+  int begin = phase_begin[static_cast<int>(BallPhase::ROLL)];
+  int end = phase_begin[static_cast<int>(BallPhase::ROLL) + 1];
+
+  double time = simulation_time + timestep;
+
+  // Rolling balls follow their closed form solution, so there's nothing to
+  // integrate. They only need to be put to rest once they've stopped, or on
+  // sloped ground, have their roll solved again once it runs out.
+  for (int i = begin; i < end;) {
+
+    BallRecord &record = records[i];
+
+    if (time - record.roll_start_time < record.roll.end_time) {
+      i++;
+      continue;
+    }
+
+    Ball &ball = balls[i];
+
+    update_roll(ball, record, time);
+
+    if (!record.roll.comes_to_rest) {
+
+      // Carries on from where the last solution ended, on whatever it has
+      // rolled onto, unless friction holds the ball right there
+      start_roll(ball, record, *terrain, *surface_map, surface_table,
+                 record.roll_start_time + record.roll.end_time);
+
+      if (record.roll.stop_time > 0.0f || !record.roll.comes_to_rest) {
+        i++;
+        continue;
+      }
+
+    }
+
+    record.phase = BallPhase::REST;
+    record_rest(record.metrics, ball.position);
+
+    // The rest range follows the roll range, so swapping the ball with the
+    // last rolling one moves it across without a repartition. On uneven
+    // ground balls come to rest a few at a time, and repartitioning all of
+    // them every step was most of the cost of a batch run.
+    end--;
+    std::swap(balls[i], balls[end]);
+    std::swap(records[i], records[end]);
+    phase_begin[static_cast<int>(BallPhase::REST)] = end;
+
+  }
+
+}
+
+void Simulation::step() {
+
+  ZoneScoped; // for tracy
+  PROFILE_SCOPE(UPDATE);
+
+  // Only the physics thread's snapshots show the timings. Headless runs,
+  // like the calibration's and the radar's, would spend more time reading
+  // the clock than stepping their few balls.
+  timing_phases = is_running.load(std::memory_order_relaxed);
+  phase_stats.partition_time_us = 0.0f;
+
+  partition_phases();
+
+  // Every ball that isn't at rest may query the terrain this step. Any tiles
+  // it needs that aren't in yet get asked for now and installed by a later
+  // step, so nothing here waits on the disk.
+  if (terrain_streamer) {
+    terrain_streamer->update(balls.data(), records.data(),
+                             phase_begin[static_cast<int>(BallPhase::REST)]);
+  }
+
+  const int flight = static_cast<int>(BallPhase::FLIGHT);
+  const int impact = static_cast<int>(BallPhase::IMPACT);
+  const int roll = static_cast<int>(BallPhase::ROLL);
+
+  phase_stats.population[flight] =
+      phase_begin[flight + 1] - phase_begin[flight];
+
+  auto start = start_timer(timing_phases);
+  step_flight();
+
+  if (timing_phases) {
+    phase_stats.time_us[flight] = elapsed_us(start);
+  }
+
+  // Moves the balls that touched down into the impact and roll ranges
+  partition_phases();
+
+  for (int phase = impact; phase < NUM_BALL_PHASES; phase++) {
+    phase_stats.population[phase] = phase_begin[phase + 1] - phase_begin[phase];
+  }
+
+  start = start_timer(timing_phases);
+  step_impact();
+
+  if (timing_phases) {
+    phase_stats.time_us[impact] = elapsed_us(start);
+  }
+
+  start = start_timer(timing_phases);
+  step_roll();
+
+  if (timing_phases) {
+    phase_stats.time_us[roll] = elapsed_us(start);
+  }
+
+  // Balls at rest have nothing left to do, so they don't get a kernel
+
+  step_count++;
+  simulation_time = static_cast<double>(step_count) * timestep;
+
+}
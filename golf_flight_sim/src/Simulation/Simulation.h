@@ -0,0 +1,395 @@
+#pragma once
+
+#include "../Components/Ball.h"
+#include "../Components/Wind.h"
+#include "../Obstacles/Obstacles.h"
+#include "../Physics/atmosphere.h"
+#include "../Physics/impact.h"
+#include "../Physics/models.h"
+#include "../Physics/stepper.h"
+#include "../Terrain/SurfaceMap.h"
+#include "../Terrain/Terrain.h"
+#include "../Terrain/TerrainStreamer.h"
+#include "../math/vec3.h"
+#include "../misc/spsc_queue.h"
+#include "../misc/triple_buffer.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Fixed rate the physics thread steps at, independent of the frame rate.
+const float PHYSICS_STEPS_PER_SECOND = 240.0f;
+
+// Most steps the physics thread will run back to back to catch up after a
+// stall before it gives up and resynchronizes with the clock.
+const int MAX_CATCH_UP_STEPS = 8;
+
+// Everything the render thread needs to know about a ball.
+struct BallSnapshot {
+
+  vec3 position;
+  vec3 velocity;
+
+  float current_spin_rate;
+
+  // From the ball's metrics, NaN until it has landed and come to rest
+  float carry;
+  float total;
+
+  BallPhase phase;
+  bool is_rolling;
+
+  // Index into SimulationSnapshot::diagnostics, or -1 if the ball's
+  // diagnostics weren't asked for
+  int diagnostics;
+
+};
+
+// What's acting on a ball, for display only. Balls that aren't in flight only
+// have an acceleration.
+struct BallDiagnostics {
+
+  vec3 acceleration;
+
+  // Wind velocity at the ball's height
+  vec3 wind_velocity;
+
+  vec3 lift_force;
+  vec3 drag_force;
+
+};
+
+// The part of the world the render thread shows, in meters. A ball is on
+// screen if it's inside the x range and either below max_z (the side view)
+// or within max_abs_y of the target line (the top down view).
+struct ViewBounds {
+
+  float min_x;
+  float max_x;
+  float max_z;
+  float max_abs_y;
+
+};
+
+// Which balls to work out diagnostics for when publishing a snapshot
+struct DiagnosticsRequest {
+
+  // Every ball on screen, while the forces are displayed
+  bool on_screen;
+  ViewBounds view;
+
+  // Balls with ids from first_id up to (not including) last_id, e.g. the
+  // rows of a list that are scrolled into view
+  int first_id;
+  int last_id;
+
+};
+
+const int NUM_BALL_PHASES = static_cast<int>(BallPhase::NUM_PHASES);
+
+// How many balls were in each phase during the last step and how long each
+// phase's kernel took.
+struct SimulationPhaseStats {
+
+  int population[NUM_BALL_PHASES] = {};
+  float time_us[NUM_BALL_PHASES] = {};
+
+  // Balls in flight whose step ended with this one. The rest are partway
+  // through a longer step (see stepper.h).
+  int flight_steps = 0;
+
+  // Time spent moving balls between the phase ranges
+  float partition_time_us = 0.0f;
+
+};
+
+struct SimulationSnapshot {
+
+  // Indexed by ball id, i.e. in launch order
+  std::vector<BallSnapshot> balls;
+
+  // Only for the balls asked for with Simulation::set_diagnostics()
+  std::vector<BallDiagnostics> diagnostics;
+
+  SimulationPhaseStats phase_stats;
+
+  // Only filled in while the terrain is streamed
+  bool terrain_streamed = false;
+  TerrainCacheStats terrain_cache;
+
+  uint64_t step_count = 0;
+  double simulation_time = 0.0;
+
+};
+
+struct SimulationCommand {
+
+  enum class Type : uint8_t {
+    LAUNCH_BALL,
+    CLEAR_BALLS,
+    SET_WIND,
+    SET_AIR,
+    SET_MODELS,
+    SET_SPIN_DECAY_RATE,
+    SET_SURFACE_TABLE,
+    SET_ADAPTIVE_STEPPING,
+    SET_TERRAIN,
+    SET_TERRAIN_STREAMER,
+    SET_OBSTACLES,
+    SET_SURFACE_MAP,
+    SET_DIAGNOSTICS
+  };
+
+  Type type;
+
+  // LAUNCH_BALL
+  vec3 position;
+  vec3 velocity;
+  vec3 rotation_axis;
+  float spin_rate;
+
+  // SET_WIND
+  float wind_speed;
+  float wind_direction;
+  bool log_wind;
+
+  // SET_AIR
+  AirConstants<float> air;
+
+  // SET_MODELS
+  IntegratorType integrator;
+  GroundType ground;
+  AeroModelType aero_model;
+
+  // SET_SPIN_DECAY_RATE
+  float spin_decay_rate;
+
+  // SET_SURFACE_TABLE
+  SurfaceTable surface_table;
+
+  // SET_ADAPTIVE_STEPPING
+  bool adaptive_stepping;
+
+  // SET_TERRAIN
+  std::shared_ptr<const Terrain> terrain;
+
+  // SET_TERRAIN_STREAMER
+  std::shared_ptr<TerrainStreamer> terrain_streamer;
+
+  // SET_OBSTACLES
+  std::shared_ptr<const Obstacles> obstacles;
+
+  // SET_SURFACE_MAP
+  std::shared_ptr<const SurfaceMap> surface_map;
+
+  // SET_DIAGNOSTICS
+  DiagnosticsRequest diagnostics;
+
+};
+
+/*
+  Owns the balls and steps them on a dedicated thread at
+  PHYSICS_STEPS_PER_SECOND, so a slow present or text rasterization on the
+  render thread can't stall the physics.
+
+  The render thread talks to the simulation through a lock-free command queue
+  and reads its state from a triple-buffered snapshot that's published after
+  every step. Neither side ever takes a lock.
+*/
+class Simulation {
+private:
+  float timestep;
+
+  /*
+    The balls are kept sorted by phase, so balls[phase_begin[p]] up to
+    balls[phase_begin[p + 1]] are the balls in phase p. A ball that changes
+    phase during a step just gets its phase field updated; it's moved to its
+    new range the next time the balls are partitioned. The exception is a
+    ball coming to rest, which step_roll() swaps into the rest range straight
+    away.
+
+    records[i] is the rest of balls[i] (see Ball.h), and is moved along with
+    it.
+
+    The flight range is further sorted by rate level, from rate_begin[l] up
+    to rate_begin[l + 1] for level l, so the balls whose steps end with a
+    simulation step are always the front of the flight range.
+  */
+  std::vector<Ball> balls;
+  std::vector<BallRecord> records;
+  int phase_begin[NUM_BALL_PHASES + 1];
+  int rate_begin[NUM_RATE_LEVELS + 1];
+  bool phases_changed;
+
+  // Reused when repartitioning so it doesn't allocate every time
+  std::vector<Ball> partition_scratch;
+  std::vector<BallRecord> record_scratch;
+
+  int next_ball_id;
+  Wind wind;
+
+  // Worked out from the site conditions on the render thread, so the physics
+  // thread only copies them
+  AirConstants<float> air;
+
+  // Shared with whoever set it, which may still be reading it. It's never
+  // modified, only replaced, except by terrain_streamer if there is one.
+  std::shared_ptr<const Terrain> terrain;
+
+  // Pages the terrain in around the balls between steps, when it's streamed
+  std::shared_ptr<TerrainStreamer> terrain_streamer;
+
+  // Built before it's handed over and never modified. May be nullptr.
+  std::shared_ptr<const Obstacles> obstacles;
+
+  // Never modified, only replaced, like the terrain
+  std::shared_ptr<const SurfaceMap> surface_map;
+
+  // Which kernels step() dispatches to. The wind model follows wind.log_wind.
+  IntegratorType integrator;
+  GroundType ground;
+  AeroModelType aero_model;
+
+  // The ground model's table and SPIN_DECAY_RATE, unless they've been
+  // replaced
+  SurfaceTable surface_table;
+  float spin_decay_rate;
+
+  // Whether balls in flight may step at coarser rate levels
+  bool adaptive_stepping;
+
+  // Gathered from the impact range and resolved in one batch
+  ImpactBatch impact_batch;
+
+  DiagnosticsRequest diagnostics_request;
+
+  SimulationPhaseStats phase_stats;
+
+  // Whether this step's phases are timed into phase_stats
+  bool timing_phases;
+
+  SPSCQueue<SimulationCommand, 1024> commands;
+  TripleBuffer<SimulationSnapshot> snapshots;
+
+  /*
+    step_count timesteps, worked out again after every step rather than
+    added up. The clock runs for as long as the application does, and in a
+    float a step would be a sizeable fraction of its last place after a few
+    hours, so rolls, which are timed from it, would jitter and the clock
+    would stop advancing evenly. Only times local to a ball, like how long
+    it's been rolling, are taken down to float.
+  */
+  uint64_t step_count;
+  double simulation_time;
+
+  std::atomic<bool> is_running;
+  std::thread thread;
+
+  void run();
+  void process_commands();
+  void publish_snapshot();
+
+  // Wind velocity at the reference height, in m/s
+  vec3 get_wind_velocity() const;
+
+  bool is_diagnosed(const Ball &ball, const BallRecord &record) const;
+  BallDiagnostics get_diagnostics(const Ball &ball,
+                                  const BallRecord &record) const;
+
+  // Sorts the balls into contiguous ranges by phase, and the flight range by
+  // rate level, if any ball has changed either since the last call.
+  void partition_phases();
+
+  // Steps until every ball has reached the given phase or one after it, or
+  // until max_time seconds have been simulated
+  void run_until(BallPhase phase, float max_time);
+
+  // Puts every rolling ball whose roll solution ends at rest there
+  void settle_rolls();
+
+  // One kernel per phase, each over its own range of balls
+  void step_flight();
+  void step_impact();
+  void step_roll();
+
+public:
+  Simulation(float timestep, const Wind &wind);
+  ~Simulation();
+
+  Simulation(const Simulation &) = delete;
+  Simulation &operator=(const Simulation &) = delete;
+
+  void start();
+  void stop();
+
+  // Advances every ball by one timestep. Called by the physics thread, or
+  // directly when running headless.
+  void step();
+
+  // Headless use only (the physics thread must not be running). Steps until
+  // every ball has started rolling, or until max_time seconds have been
+  // simulated. On flat terrain with a single surface material a ball's final
+  // resting place is known from record.roll.end_position as soon as it
+  // starts rolling.
+  void run_until_rolling(float max_time);
+
+  // Same as above, until every ball has come to rest, when its metrics are
+  // complete. Once every ball is rolling, those whose roll is solved all the
+  // way to a stop are put to rest there straight away, since nothing about
+  // them would change before then but the time.
+  void run_until_resting(float max_time);
+
+  const std::vector<Ball> &get_balls() const;
+  const std::vector<BallRecord> &get_records() const;
+
+  // Headless use only. Every ball's metrics, in launch order.
+  void get_shot_metrics(std::vector<ShotMetrics> &metrics) const;
+
+  // Render thread side. The commands return false if the queue is full.
+  bool launch_ball(vec3 position, vec3 velocity, vec3 rotation_axis,
+                   float spin_rate);
+  bool clear_balls();
+  bool set_wind(const Wind &wind);
+
+  // The reference air (see atmosphere.h) by default
+  bool set_air(const SiteConditions &site);
+
+  // Same as above, from the constants themselves, e.g. with the drag and
+  // lift scaled by the calibration
+  bool set_air(const AirConstants<float> &air);
+
+  // Also puts back the ground model's surface table
+  bool set_models(IntegratorType integrator, GroundType ground,
+                  AeroModelType aero_model);
+
+  // In place of SPIN_DECAY_RATE and the ground model's surface table, for
+  // calibrating them (see calibration.h)
+  bool set_spin_decay_rate(float spin_decay_rate);
+  bool set_surface_table(const SurfaceTable &table);
+  bool set_adaptive_stepping(bool adaptive_stepping);
+
+  // Flat by default. Balls already launched carry on over the new terrain.
+  bool set_terrain(std::shared_ptr<const Terrain> terrain);
+
+  // Switches to the streamer's terrain, which from then on belongs to the
+  // physics thread. Only its overview may be read elsewhere.
+  bool set_terrain_streamer(std::shared_ptr<TerrainStreamer> streamer);
+
+  // None by default. They have to be built already (see Obstacles::build()).
+  bool set_obstacles(std::shared_ptr<const Obstacles> obstacles);
+
+  // The green everywhere by default. The green's coefficients follow the
+  // ground model set with set_models().
+  bool set_surface_map(std::shared_ptr<const SurfaceMap> surface_map);
+
+  // Balls don't keep their forces, so snapshots only carry them for the balls
+  // asked for here. None are by default.
+  bool set_diagnostics(const DiagnosticsRequest &request);
+
+  // Returns the newest published snapshot. The reference stays valid until
+  // the next call.
+  const SimulationSnapshot &acquire_snapshot();
+
+};
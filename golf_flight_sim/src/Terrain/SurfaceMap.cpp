@@ -0,0 +1,113 @@
+#include "SurfaceMap.h"
+#include <cassert>
+#include <cmath>
+
+SurfaceMap::SurfaceMap()
+    : SurfaceMap(0.0f, 0.0f, 1.0f, 1, 1,
+                 std::vector<SurfaceMaterial>(1, SurfaceMaterial::GREEN)) {}
+
+SurfaceMap::SurfaceMap(float origin_x, float origin_y, float spacing,
+                       int cells_x, int cells_y,
+                       const std::vector<SurfaceMaterial> &materials) {
+
+  assert(cells_x >= 1 && cells_y >= 1);
+  assert(materials.size() == static_cast<size_t>(cells_x * cells_y));
+
+  this->origin_x = origin_x;
+  this->origin_y = origin_y;
+  this->spacing = spacing;
+  this->inv_spacing = 1.0f / spacing;
+  this->cells_x = cells_x;
+  this->cells_y = cells_y;
+  this->uniform = true;
+
+  this->materials.resize(materials.size());
+
+  for (size_t i = 0; i < materials.size(); i++) {
+
+    this->materials[i] = static_cast<uint8_t>(materials[i]);
+
+    if (materials[i] != materials[0]) {
+      this->uniform = false;
+    }
+
+  }
+
+}
+
+SurfaceMap SurfaceMap::driving_range() {
+
+  // The same ground as the rolling hills, a meter to a cell
+  const float origin_x = -20.0f;
+  const float origin_y = -100.0f;
+  const float spacing = 1.0f;
+  const int cells_x = 440;
+  const int cells_y = 200;
+
+  const float fairway_half_width = 25.0f;
+  const float fairway_end = 300.0f;
+
+  // Greens are a little longer than they're wide
+  const float green_half_length = 10.0f;
+  const float green_half_width = 8.0f;
+  const float bunker_radius = 3.5f;
+
+  auto inside_ellipse = [](float x, float y, float half_x, float half_y) {
+    return (x * x) / (half_x * half_x) + (y * y) / (half_y * half_y) <= 1.0f;
+  };
+
+  std::vector<SurfaceMaterial> materials(cells_x * cells_y);
+
+  for (int j = 0; j < cells_y; j++) {
+    for (int i = 0; i < cells_x; i++) {
+
+      // At the middle of the cell
+      float x = origin_x + (static_cast<float>(i) + 0.5f) * spacing;
+      float y = origin_y + (static_cast<float>(j) + 0.5f) * spacing;
+
+      SurfaceMaterial material = SurfaceMaterial::ROUGH;
+
+      if (std::abs(y) < fairway_half_width && x < fairway_end) {
+        material = SurfaceMaterial::FAIRWAY;
+      }
+
+      for (int green = 0; green < NUM_RANGE_GREENS; green++) {
+
+        float green_x = x - RANGE_GREEN_X[green];
+        float green_y = y - RANGE_GREEN_Y[green];
+
+        if (inside_ellipse(green_x, green_y, green_half_length,
+                           green_half_width)) {
+          material = SurfaceMaterial::GREEN;
+        }
+
+        // Short of the green on alternate sides, and on both for the longer
+        // targets
+        float side = green % 2 == 0 ? 1.0f : -1.0f;
+        float bunker_x = green_x + green_half_length + 2.0f;
+        float bunker_y = green_y - side * green_half_width;
+
+        bool in_bunker = inside_ellipse(bunker_x, bunker_y, bunker_radius,
+                                        bunker_radius);
+
+        if (green >= 3) {
+          float other_bunker_y = green_y + side * green_half_width;
+          in_bunker |= inside_ellipse(bunker_x, other_bunker_y, bunker_radius,
+                                      bunker_radius);
+        }
+
+        if (in_bunker) {
+          material = SurfaceMaterial::BUNKER;
+        }
+
+      }
+
+      materials[j * cells_x + i] = material;
+
+    }
+  }
+
+  return SurfaceMap(origin_x, origin_y, spacing, cells_x, cells_y,
+                    materials);
+
+}
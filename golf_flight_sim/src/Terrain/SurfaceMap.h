@@ -0,0 +1,110 @@
+#pragma once
+
+#include "../Physics/surfaces.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// The driving range's target greens, 50 to 250 yards out, which its
+// obstacles put flagsticks on
+const int NUM_RANGE_GREENS = 5;
+const float RANGE_GREEN_X[NUM_RANGE_GREENS] = {45.72f, 91.44f, 137.16f,
+                                               182.88f, 228.6f};
+const float RANGE_GREEN_Y[NUM_RANGE_GREENS] = {0.0f, 6.0f, -8.0f, 5.0f,
+                                               -4.0f};
+
+/*
+  Which material covers the ground where, as a raster of square cells with
+  one byte per cell holding a SurfaceMaterial. Finding the material under a
+  point is a multiply, two clamps and one load, with no search, so the
+  impact and roll phases can look it up for every ball.
+
+  Outside the raster the material of the nearest edge cell carries on, like
+  the terrain's heights.
+*/
+class SurfaceMap {
+private:
+  float origin_x;
+  float origin_y;
+  float spacing;
+  float inv_spacing;
+
+  int cells_x;
+  int cells_y;
+
+  // Row by row in x
+  std::vector<uint8_t> materials;
+
+  // Only one material anywhere
+  bool uniform;
+
+public:
+  // The green everywhere, the simulation's original surface
+  SurfaceMap();
+
+  // materials has cells_x * cells_y entries, row by row in x, for the cells
+  // with corners at (origin_x + i * spacing, origin_y + j * spacing).
+  SurfaceMap(float origin_x, float origin_y, float spacing, int cells_x,
+             int cells_y, const std::vector<SurfaceMaterial> &materials);
+
+  // A fairway down the middle of a driving range with rough either side,
+  // and the target greens with a bunker or two in front of each
+  static SurfaceMap driving_range();
+
+  SurfaceMaterial get_material(float x, float y) const;
+
+  // For drawing the raster
+  SurfaceMaterial get_cell(int i, int j) const;
+  float get_origin_x() const;
+  float get_origin_y() const;
+  float get_spacing() const;
+  int get_cells_x() const;
+  int get_cells_y() const;
+
+  // Whether every point has the same material, in which case a roll on
+  // level ground never crosses onto another one
+  bool is_uniform() const;
+
+};
+
+inline SurfaceMaterial SurfaceMap::get_material(float x, float y) const {
+
+  // Clamped as floats so points far outside can't overflow the conversion.
+  // std::max() with the bound first returns it for a NaN.
+  float grid_x = std::min(std::max(0.0f, (x - origin_x) * inv_spacing),
+                          static_cast<float>(cells_x - 1));
+  float grid_y = std::min(std::max(0.0f, (y - origin_y) * inv_spacing),
+                          static_cast<float>(cells_y - 1));
+
+  return get_cell(static_cast<int>(grid_x), static_cast<int>(grid_y));
+
+}
+
+inline SurfaceMaterial SurfaceMap::get_cell(int i, int j) const {
+  return static_cast<SurfaceMaterial>(
+      materials[static_cast<size_t>(j) * cells_x + i]);
+}
+
+inline float SurfaceMap::get_origin_x() const {
+  return origin_x;
+}
+
+inline float SurfaceMap::get_origin_y() const {
+  return origin_y;
+}
+
+inline float SurfaceMap::get_spacing() const {
+  return spacing;
+}
+
+inline int SurfaceMap::get_cells_x() const {
+  return cells_x;
+}
+
+inline int SurfaceMap::get_cells_y() const {
+  return cells_y;
+}
+
+inline bool SurfaceMap::is_uniform() const {
+  return uniform;
+}
@@ -0,0 +1,187 @@
+#include "Terrain.h"
+#include "../Physics/constants.h"
+#include <cassert>
+
+Terrain::Terrain()
+    : Terrain(0.0f, 0.0f, 1.0f, 2, 2, std::vector<float>(4, 0.0f)) {}
+
+Terrain::Terrain(float origin_x, float origin_y, float spacing, int samples_x,
+                 int samples_y, const std::vector<float> &heights) {
+
+  assert(samples_x >= 2 && samples_y >= 2);
+  assert(heights.size() == static_cast<size_t>(samples_x * samples_y));
+
+  this->origin_x = origin_x;
+  this->origin_y = origin_y;
+  this->min_height = *std::min_element(heights.begin(), heights.end());
+  this->max_height = *std::max_element(heights.begin(), heights.end());
+  this->flat = min_height == max_height;
+
+  Level level = make_level(spacing, samples_x, samples_y);
+  int num_tiles = level.tiles_x * level.tiles_y;
+
+  auto height_at = [&](int i, int j) {
+    return heights[static_cast<size_t>(j * samples_x + i)];
+  };
+
+  cells.resize(static_cast<size_t>(num_tiles) * TILE_CELLS);
+
+  float samples[TILE_SAMPLES * TILE_SAMPLES];
+
+  for (int tile = 0; tile < num_tiles; tile++) {
+
+    Cell *tile_cells = &cells[static_cast<size_t>(tile) * TILE_CELLS];
+
+    gather_tile_samples(height_at, samples_x, samples_y, tile % level.tiles_x,
+                        tile / level.tiles_x, samples);
+    build_tile(samples, spacing, tile_cells);
+
+    level.tiles[tile] = tile_cells;
+
+  }
+
+  levels.push_back(std::move(level));
+
+}
+
+Terrain::Terrain(float origin_x, float origin_y, float min_height,
+                 float max_height) {
+
+  this->origin_x = origin_x;
+  this->origin_y = origin_y;
+  this->min_height = min_height;
+  this->max_height = max_height;
+  this->flat = min_height == max_height;
+
+}
+
+Terrain::Level Terrain::make_level(float spacing, int samples_x,
+                                   int samples_y) {
+
+  Level level;
+  level.spacing = spacing;
+  level.inv_spacing = 1.0f / spacing;
+  level.cells_x = samples_x - 1;
+  level.cells_y = samples_y - 1;
+  level.tiles_x = (level.cells_x + TILE_SIZE - 1) / TILE_SIZE;
+  level.tiles_y = (level.cells_y + TILE_SIZE - 1) / TILE_SIZE;
+  level.tiles.assign(static_cast<size_t>(level.tiles_x * level.tiles_y),
+                     nullptr);
+
+  return level;
+
+}
+
+void Terrain::build_tile(const float *samples, float spacing, Cell *tile) {
+
+  // Sample (i, j) of the tile is at samples[(j + 1) * TILE_SAMPLES + i + 1]
+  auto height_at = [&](int i, int j) {
+    return samples[(j + 1) * TILE_SAMPLES + i + 1];
+  };
+
+  // Normals at the samples from central differences
+  const float inv_span = 0.5f / spacing;
+
+  vec3 normals[(TILE_SIZE + 1) * (TILE_SIZE + 1)];
+
+  for (int j = 0; j <= TILE_SIZE; j++) {
+    for (int i = 0; i <= TILE_SIZE; i++) {
+
+      float slope_x = (height_at(i + 1, j) - height_at(i - 1, j)) * inv_span;
+      float slope_y = (height_at(i, j + 1) - height_at(i, j - 1)) * inv_span;
+
+      normals[j * (TILE_SIZE + 1) + i] =
+          vec3(-slope_x, -slope_y, 1.0f).unit_vector();
+
+    }
+  }
+
+  for (int cell_y = 0; cell_y < TILE_SIZE; cell_y++) {
+    for (int cell_x = 0; cell_x < TILE_SIZE; cell_x++) {
+
+      Cell &cell = tile[get_cell_index(cell_x, cell_y)];
+
+      for (int corner = 0; corner < 4; corner++) {
+
+        int i = cell_x + (corner & 1);
+        int j = cell_y + (corner >> 1);
+        const vec3 &normal = normals[j * (TILE_SIZE + 1) + i];
+
+        cell.height[corner] = height_at(i, j);
+        cell.normal_x[corner] = normal.x;
+        cell.normal_y[corner] = normal.y;
+        cell.normal_z[corner] = normal.z;
+
+      }
+
+    }
+  }
+
+}
+
+Terrain Terrain::rolling_hills() {
+
+  // From just behind the tee to past the longest drives, 2 m apart
+  const float origin_x = -20.0f;
+  const float origin_y = -100.0f;
+  const float spacing = 2.0f;
+  const int samples_x = 221;
+  const int samples_y = 101;
+
+  std::vector<float> heights(samples_x * samples_y);
+
+  for (int j = 0; j < samples_y; j++) {
+    for (int i = 0; i < samples_x; i++) {
+
+      float x = origin_x + static_cast<float>(i) * spacing;
+      float y = origin_y + static_cast<float>(j) * spacing;
+
+      // A few swells of different sizes, a meter or two high, with slopes
+      // of up to about 10%
+      heights[j * samples_x + i] =
+          1.0f * std::sin(2.0f * PI * x / 90.0f)
+              * std::cos(2.0f * PI * y / 70.0f)
+          + 0.5f * std::sin(2.0f * PI * (x + y) / 60.0f)
+          + 0.15f * std::cos(2.0f * PI * (x - 2.0f * y) / 30.0f);
+
+    }
+  }
+
+  return Terrain(origin_x, origin_y, spacing, samples_x, samples_y, heights);
+
+}
+
+Terrain Terrain::practice_green() {
+
+  // 30 m long and 24 m across, 25 cm apart, with the ball putted from the
+  // origin towards +x
+  const float origin_x = -4.0f;
+  const float origin_y = -12.0f;
+  const float spacing = 0.25f;
+  const int samples_x = 121;
+  const int samples_y = 97;
+
+  std::vector<float> heights(samples_x * samples_y);
+
+  for (int j = 0; j < samples_y; j++) {
+    for (int i = 0; i < samples_x; i++) {
+
+      float x = origin_x + static_cast<float>(i) * spacing;
+      float y = origin_y + static_cast<float>(j) * spacing;
+
+      // Falling 1.5% to the right of the line, a 25 cm step up to the back
+      // tier from 10 to 14 m out, and a shallow swale short of it on the left
+      float tier = std::clamp((x - 10.0f) / 4.0f, 0.0f, 1.0f);
+      float swale_x = x - 6.0f;
+      float swale_y = y - 3.0f;
+
+      heights[j * samples_x + i] =
+          0.015f * y + 0.25f * tier * tier * (3.0f - 2.0f * tier)
+          - 0.08f * std::exp(-(swale_x * swale_x + swale_y * swale_y) / 8.0f);
+
+    }
+  }
+
+  return Terrain(origin_x, origin_y, spacing, samples_x, samples_y, heights);
+
+}
@@ -0,0 +1,416 @@
+#pragma once
+
+#include "../math/math_inline.h"
+#include "../math/vec3.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// The ground under a point: its height and its unit surface normal
+struct TerrainSample {
+
+  float height;
+  vec3 normal;
+
+};
+
+/*
+  Heightfield terrain. Heights are given on a regular grid of samples with
+  the same spacing in x and y, and the surface between them is bilinear.
+
+  The grid is stored by cell rather than by sample: every cell holds the
+  heights and precomputed normals of its four corners, which is exactly one
+  cache line, so a query reads one line and does no neighbour lookups. Cells
+  are grouped into tiles of TILE_SIZE x TILE_SIZE, and within a tile they're
+  in Morton (Z) order, so balls close together in either direction read cells
+  that are close together in memory.
+
+  A terrain can have several levels of detail, each with twice the spacing of
+  the one before, and each tile is found through a table of pointers. A
+  terrain built in memory has one level with every tile present. A streamed
+  one (see TerrainStreamer.h) only has the tiles it has paged in, and a query
+  over a missing tile falls back to the next coarser level that has one. The
+  coarsest level is always complete, so a query never waits for anything.
+
+  Outside the grid the terrain carries on flat at the height of the nearest
+  edge, with the normal pointing straight up.
+*/
+class Terrain {
+private:
+  friend class TerrainStreamer;
+
+  struct alignas(64) Cell {
+
+    // Corners in the order (x0, y0), (x1, y0), (x0, y1), (x1, y1)
+    float height[4];
+    float normal_x[4];
+    float normal_y[4];
+    float normal_z[4];
+
+  };
+
+  static_assert(sizeof(Cell) == 64, "A terrain cell must fill a cache line");
+
+  struct Level {
+
+    float spacing;
+    float inv_spacing;
+
+    int cells_x;
+    int cells_y;
+    int tiles_x;
+    int tiles_y;
+
+    // Row by row, each pointing to TILE_SIZE * TILE_SIZE cells, or nullptr
+    // if the tile isn't resident
+    std::vector<const Cell *> tiles;
+
+  };
+
+  float origin_x;
+  float origin_y;
+
+  float min_height;
+  float max_height;
+  bool flat;
+
+  // Finest first
+  std::vector<Level> levels;
+
+  // The tiles of a terrain built in memory. A streamed terrain's tiles
+  // belong to its streamer.
+  std::vector<Cell> cells;
+
+  // Used by TerrainStreamer, which fills in the rest
+  Terrain(float origin_x, float origin_y, float min_height, float max_height);
+
+  // Sets up a level's size with none of its tiles resident
+  static Level make_level(float spacing, int samples_x, int samples_y);
+
+  // Within a tile, in Morton order
+  static int get_cell_index(int cell_x, int cell_y);
+  static int get_tile_index(const Level &level, int cell_x, int cell_y);
+
+  // Finds the cell containing (x, y) and the position in it from 0 to 1 on
+  // each axis. Returns false if the point is outside the grid.
+  bool locate(const Level &level, float x, float y, int &cell_x, int &cell_y,
+              float &u, float &v) const;
+
+  // The cell under (x, y) from the finest level that has it resident
+  const Cell &find_cell(float x, float y, float &u, float &v,
+                        bool &inside) const;
+
+  // The height and normal at (u, v) in a cell
+  static TerrainSample sample_cell(const Cell &cell, float u, float v);
+
+  // Fills a tile's cells from its samples (see gather_tile_samples())
+  static void build_tile(const float *samples, float spacing, Cell *tile);
+
+public:
+  // Cells per tile side. A power of two.
+  static const int TILE_SHIFT = 4;
+  static const int TILE_SIZE = 1 << TILE_SHIFT;
+  static const int TILE_CELLS = TILE_SIZE * TILE_SIZE;
+
+  // Samples per side that it takes to build a tile: its TILE_SIZE + 1, and
+  // one more either side for the normals at its edges
+  static const int TILE_SAMPLES = TILE_SIZE + 3;
+
+  // Flat ground at z = 0
+  Terrain();
+
+  // heights has samples_x * samples_y entries, row by row in x, for the
+  // samples at (origin_x + i * spacing, origin_y + j * spacing).
+  Terrain(float origin_x, float origin_y, float spacing, int samples_x,
+          int samples_y, const std::vector<float> &heights);
+
+  // The tile tables point into the cells, which a move keeps but a copy
+  // wouldn't
+  Terrain(const Terrain &) = delete;
+  Terrain &operator=(const Terrain &) = delete;
+  Terrain(Terrain &&) = default;
+  Terrain &operator=(Terrain &&) = default;
+
+  // Gentle undulations over a driving range, for trying out the terrain
+  static Terrain rolling_hills();
+
+  // A two tier putting green around the origin, tilted to one side, for the
+  // putting mode
+  static Terrain practice_green();
+
+  float get_height(float x, float y) const;
+  TerrainSample sample(float x, float y) const;
+
+  /*
+    The cell of the finest level that a query last landed in, for a caller
+    that samples a point moving a little at a time, like a rolling putt.
+    While the point stays in that cell, sample() skips finding it again.
+    A streamed terrain can page its tiles out, so the cache is only for as
+    long as the caller holds on to the terrain without a streamer update.
+  */
+  struct SampleCache {
+
+    const Cell *cell = nullptr;
+    float min_x = 0.0f;
+    float min_y = 0.0f;
+
+  };
+
+  // Same as above, through the cache
+  TerrainSample sample(float x, float y, SampleCache &cache) const;
+
+  // Bounds on the height anywhere, so a ball above max_height doesn't need a
+  // query to know it's off the ground
+  float get_min_height() const;
+  float get_max_height() const;
+
+  // Flat ground at a single height everywhere
+  bool is_flat() const;
+
+  /*
+    Copies the TILE_SAMPLES x TILE_SAMPLES samples for tile (tile_x, tile_y)
+    of a samples_x x samples_y grid into samples, row by row, starting one
+    sample before the tile on each axis. height(i, j) gives the sample at
+    column i and row j.
+
+    The samples one past the edge of the grid are extrapolated linearly, which
+    makes the central differences there one sided. Samples further out only
+    belong to cells past the edge, which are never read, and are clamped.
+  */
+  template <typename HeightFunction>
+  static void gather_tile_samples(const HeightFunction &height,
+                                  int samples_x, int samples_y, int tile_x,
+                                  int tile_y, float *samples);
+
+};
+
+// Spreads the low 8 bits of v out to the even bits
+MATH_INLINE constexpr uint32_t spread_bits(uint32_t v) {
+
+  v = (v | (v << 4)) & 0x0F0Fu;
+  v = (v | (v << 2)) & 0x3333u;
+  v = (v | (v << 1)) & 0x5555u;
+
+  return v;
+
+}
+
+inline int Terrain::get_cell_index(int cell_x, int cell_y) {
+
+  uint32_t morton = spread_bits(cell_x & (TILE_SIZE - 1))
+                    | (spread_bits(cell_y & (TILE_SIZE - 1)) << 1);
+
+  return static_cast<int>(morton);
+
+}
+
+inline int Terrain::get_tile_index(const Level &level, int cell_x,
+                                   int cell_y) {
+  return (cell_y >> TILE_SHIFT) * level.tiles_x + (cell_x >> TILE_SHIFT);
+}
+
+inline bool Terrain::locate(const Level &level, float x, float y, int &cell_x,
+                            int &cell_y, float &u, float &v) const {
+
+  float grid_x = (x - origin_x) * level.inv_spacing;
+  float grid_y = (y - origin_y) * level.inv_spacing;
+
+  bool inside = grid_x >= 0.0f && grid_y >= 0.0f
+                && grid_x <= static_cast<float>(level.cells_x)
+                && grid_y <= static_cast<float>(level.cells_y);
+
+  // Clamped, so points outside get the height of the nearest edge
+  grid_x = std::fmin(std::fmax(grid_x, 0.0f),
+                     static_cast<float>(level.cells_x));
+  grid_y = std::fmin(std::fmax(grid_y, 0.0f),
+                     static_cast<float>(level.cells_y));
+
+  cell_x = std::min(static_cast<int>(grid_x), level.cells_x - 1);
+  cell_y = std::min(static_cast<int>(grid_y), level.cells_y - 1);
+  u = grid_x - static_cast<float>(cell_x);
+  v = grid_y - static_cast<float>(cell_y);
+
+  return inside;
+
+}
+
+inline const Terrain::Cell &Terrain::find_cell(float x, float y, float &u,
+                                                float &v,
+                                                bool &inside) const {
+
+  // The coarsest level has every tile, so this always finds one
+  for (const Level *level = levels.data();; level++) {
+
+    int cell_x, cell_y;
+    inside = locate(*level, x, y, cell_x, cell_y, u, v);
+
+    const Cell *tile = level->tiles[get_tile_index(*level, cell_x, cell_y)];
+
+    if (tile != nullptr) {
+      return tile[get_cell_index(cell_x, cell_y)];
+    }
+
+  }
+
+}
+
+// Bilinear interpolation between a cell's corners
+MATH_INLINE float interpolate_corners(const float corners[4], float u,
+                                      float v) {
+
+  float bottom = corners[0] + (corners[1] - corners[0]) * u;
+  float top = corners[2] + (corners[3] - corners[2]) * u;
+
+  return bottom + (top - bottom) * v;
+
+}
+
+inline float Terrain::get_height(float x, float y) const {
+
+  if (flat) {
+    return max_height;
+  }
+
+  float u, v;
+  bool inside;
+  const Cell &cell = find_cell(x, y, u, v, inside);
+
+  return interpolate_corners(cell.height, u, v);
+
+}
+
+inline TerrainSample Terrain::sample(float x, float y) const {
+
+  TerrainSample result;
+
+  if (flat) {
+
+    result.height = max_height;
+    result.normal = vec3(0.0f, 0.0f, 1.0f);
+
+    return result;
+
+  }
+
+  float u, v;
+  bool inside;
+  const Cell &cell = find_cell(x, y, u, v, inside);
+
+  if (!inside) {
+    result.height = interpolate_corners(cell.height, u, v);
+    result.normal = vec3(0.0f, 0.0f, 1.0f);
+    return result;
+  }
+
+  return sample_cell(cell, u, v);
+
+}
+
+inline TerrainSample Terrain::sample_cell(const Cell &cell, float u,
+                                          float v) {
+
+  TerrainSample result;
+
+  result.height = interpolate_corners(cell.height, u, v);
+
+  // The interpolated normal is a little short of unit length in the middle
+  // of a cell
+  vec3 normal(interpolate_corners(cell.normal_x, u, v),
+              interpolate_corners(cell.normal_y, u, v),
+              interpolate_corners(cell.normal_z, u, v));
+  result.normal = normal.fast_unit_vector();
+
+  return result;
+
+}
+
+inline TerrainSample Terrain::sample(float x, float y,
+                                     SampleCache &cache) const {
+
+  if (flat) {
+    return sample(x, y);
+  }
+
+  const Level &level = levels.front();
+
+  float u, v;
+
+  if (cache.cell != nullptr) {
+
+    u = (x - cache.min_x) * level.inv_spacing;
+    v = (y - cache.min_y) * level.inv_spacing;
+
+    if (u >= 0.0f && u < 1.0f && v >= 0.0f && v < 1.0f) {
+      return sample_cell(*cache.cell, u, v);
+    }
+
+    cache.cell = nullptr;
+
+  }
+
+  int cell_x, cell_y;
+  bool inside = locate(level, x, y, cell_x, cell_y, u, v);
+  const Cell *tile = level.tiles[get_tile_index(level, cell_x, cell_y)];
+
+  // Outside the grid, or over a tile that isn't resident
+  if (!inside || tile == nullptr) {
+    return sample(x, y);
+  }
+
+  cache.cell = &tile[get_cell_index(cell_x, cell_y)];
+  cache.min_x = origin_x + static_cast<float>(cell_x) * level.spacing;
+  cache.min_y = origin_y + static_cast<float>(cell_y) * level.spacing;
+
+  return sample_cell(*cache.cell, u, v);
+
+}
+
+inline float Terrain::get_min_height() const {
+  return min_height;
+}
+
+inline float Terrain::get_max_height() const {
+  return max_height;
+}
+
+inline bool Terrain::is_flat() const {
+  return flat;
+}
+
+template <typename HeightFunction>
+void Terrain::gather_tile_samples(const HeightFunction &height,
+                                  int samples_x, int samples_y, int tile_x,
+                                  int tile_y, float *samples) {
+
+  int first_i = tile_x * TILE_SIZE - 1;
+  int first_j = tile_y * TILE_SIZE - 1;
+
+  for (int row = 0; row < TILE_SAMPLES; row++) {
+    for (int column = 0; column < TILE_SAMPLES; column++) {
+
+      int i = first_i + column;
+      int j = first_j + row;
+
+      int inside_i = std::min(std::max(i, 0), samples_x - 1);
+      int inside_j = std::min(std::max(j, 0), samples_y - 1);
+
+      float sample = height(inside_i, inside_j);
+
+      // One past the edge on either axis, carry on the edge's slope. Only
+      // the samples next to an edge row or column are used for its normals,
+      // so it's never needed on both axes at once.
+      if (i == -1 || i == samples_x) {
+        int before = i == -1 ? 1 : samples_x - 2;
+        sample += sample - height(before, inside_j);
+      } else if (j == -1 || j == samples_y) {
+        int before = j == -1 ? 1 : samples_y - 2;
+        sample += sample - height(inside_i, before);
+      }
+
+      samples[row * TILE_SAMPLES + column] = sample;
+
+    }
+  }
+
+}
@@ -0,0 +1,344 @@
+#include "TerrainStreamer.h"
+#include "../Physics/constants.h"
+#include "../tracy/tracy/Tracy.hpp"
+#include <cassert>
+#include <cstring>
+
+// The most tiles out with the loader at once. No more than the loaded queue
+// holds, so the loader never has to wait to hand one back.
+static const int MAX_LOADING_TILES = 256;
+
+float TerrainCacheStats::get_hit_rate() const {
+
+  if (lookups == 0) {
+    return 0.0f;
+  }
+
+  return static_cast<float>(static_cast<double>(hits)
+                            / static_cast<double>(lookups));
+
+}
+
+TerrainStreamer::TerrainStreamer() {
+  this->update_count = 0;
+}
+
+TerrainStreamer::~TerrainStreamer() {
+
+  if (!is_running) {
+    return;
+  }
+
+  is_running = false;
+  request_signal.fetch_add(1, std::memory_order_release);
+  request_signal.notify_one();
+  loader.join();
+
+}
+
+bool TerrainStreamer::open(const char *path, int capacity) {
+
+  assert(!is_running && capacity > 0);
+
+  TerrainFileHeader header;
+
+  if (!file.open(path)
+      || !read_terrain_file_levels(file.get_data(), file.get_size(), header,
+                                   file_levels)) {
+    file.close();
+    return false;
+  }
+
+  // Every level's samples are a subset of the finest level's, so its height
+  // range covers them all
+  const TerrainFileLevel &finest = file_levels.front();
+  const int coarsest = static_cast<int>(file_levels.size()) - 1;
+
+  terrain = Terrain(header.origin_x, header.origin_y, finest.min_height,
+                    finest.max_height);
+
+  for (const TerrainFileLevel &level : file_levels) {
+    terrain.levels.push_back(Terrain::make_level(
+        level.spacing, level.samples_x, level.samples_y));
+  }
+
+  // The coarsest level is read in full, here rather than on the loader so
+  // that it's there before the first query
+  Terrain::Level &coarse_level = terrain.levels.back();
+  int num_coarse_tiles = coarse_level.tiles_x * coarse_level.tiles_y;
+
+  coarse_cells.resize(static_cast<size_t>(num_coarse_tiles)
+                      * Terrain::TILE_CELLS);
+
+  for (int tile = 0; tile < num_coarse_tiles; tile++) {
+
+    Terrain::Cell *cells =
+        &coarse_cells[static_cast<size_t>(tile) * Terrain::TILE_CELLS];
+
+    load_tile(coarsest, tile, cells);
+    coarse_level.tiles[tile] = cells;
+
+  }
+
+  overview = Terrain(header.origin_x, header.origin_y, finest.min_height,
+                     finest.max_height);
+  overview.levels.push_back(coarse_level);
+
+  tile_slots.resize(coarsest);
+
+  for (int level = 0; level < coarsest; level++) {
+    tile_slots[level].assign(terrain.levels[level].tiles.size(), -1);
+  }
+
+  slot_cells.resize(static_cast<size_t>(capacity) * Terrain::TILE_CELLS);
+  slots.assign(capacity, Slot{-1, -1, SlotState::FREE, 0});
+
+  for (int slot = capacity - 1; slot >= 0; slot--) {
+    free_slots.push_back(slot);
+  }
+
+  stats = {};
+  stats.capacity = capacity;
+
+  is_running = true;
+  loader = std::thread(&TerrainStreamer::run_loader, this);
+
+  return true;
+
+}
+
+void TerrainStreamer::run_loader() {
+
+  tracy::SetThreadName("Terrain loader");
+
+  while (is_running) {
+
+    // Read before popping, so a request pushed after a failed pop still
+    // changes the signal and wakes us
+    uint32_t signal = request_signal.load(std::memory_order_acquire);
+
+    TileRequest request;
+
+    if (!requests.pop(request)) {
+      request_signal.wait(signal, std::memory_order_acquire);
+      continue;
+    }
+
+    Terrain::Cell *cells =
+        &slot_cells[static_cast<size_t>(request.slot) * Terrain::TILE_CELLS];
+    load_tile(request.level, request.tile, cells);
+
+    // Can't fail, see MAX_LOADING_TILES
+    loaded.push(request);
+
+  }
+
+}
+
+void TerrainStreamer::load_tile(int level, int tile,
+                                Terrain::Cell *cells) const {
+
+  ZoneScoped; // for tracy
+
+  const TerrainFileLevel &file_level = file_levels[level];
+  const uint8_t *source = file.get_data() + file_level.offset
+                          + static_cast<uint64_t>(tile)
+                                * TERRAIN_FILE_TILE_BYTES;
+
+  // Copied out first, as the mapping makes no promises about alignment
+  float samples[Terrain::TILE_SAMPLES * Terrain::TILE_SAMPLES];
+  std::memcpy(samples, source, TERRAIN_FILE_TILE_BYTES);
+
+  Terrain::build_tile(samples, file_level.spacing, cells);
+
+}
+
+void TerrainStreamer::install_loaded_tiles() {
+
+  TileRequest request;
+
+  while (loaded.pop(request)) {
+
+    slots[request.slot].state = SlotState::RESIDENT;
+    terrain.levels[request.level].tiles[request.tile] =
+        &slot_cells[static_cast<size_t>(request.slot) * Terrain::TILE_CELLS];
+
+    stats.loading_tiles--;
+    stats.resident_tiles++;
+    stats.loads++;
+
+  }
+
+}
+
+int TerrainStreamer::take_slot() {
+
+  if (!free_slots.empty()) {
+
+    int slot = free_slots.back();
+    free_slots.pop_back();
+
+    return slot;
+
+  }
+
+  // Tiles used in this update are left alone, or a ball could lose the tile
+  // under it to one further along its path
+  int oldest = -1;
+
+  for (int i = 0; i < static_cast<int>(slots.size()); i++) {
+
+    const Slot &slot = slots[i];
+
+    if (slot.state == SlotState::RESIDENT && slot.last_used < update_count
+        && (oldest < 0 || slot.last_used < slots[oldest].last_used)) {
+      oldest = i;
+    }
+
+  }
+
+  if (oldest < 0) {
+    return -1;
+  }
+
+  Slot &slot = slots[oldest];
+  terrain.levels[slot.level].tiles[slot.tile] = nullptr;
+  tile_slots[slot.level][slot.tile] = -1;
+  slot.state = SlotState::FREE;
+
+  stats.resident_tiles--;
+  stats.evictions++;
+
+  return oldest;
+
+}
+
+bool TerrainStreamer::request_tiles(float x, float y) {
+
+  auto get_tile = [&](int level) {
+
+    const Terrain::Level &terrain_level = terrain.levels[level];
+
+    int cell_x, cell_y;
+    float u, v;
+    terrain.locate(terrain_level, x, y, cell_x, cell_y, u, v);
+
+    return Terrain::get_tile_index(terrain_level, cell_x, cell_y);
+
+  };
+
+  // Most of the time the finest tile is already there
+  int finest_slot = tile_slots[0][get_tile(0)];
+
+  if (finest_slot >= 0 && slots[finest_slot].state == SlotState::RESIDENT) {
+    slots[finest_slot].last_used = update_count;
+    return true;
+  }
+
+  const int coarsest = static_cast<int>(terrain.levels.size()) - 1;
+
+  for (int level = coarsest - 1; level >= 0; level--) {
+
+    int tile = get_tile(level);
+    int &tile_slot = tile_slots[level][tile];
+
+    if (tile_slot >= 0) {
+      slots[tile_slot].last_used = update_count;
+      continue;
+    }
+
+    if (stats.loading_tiles >= MAX_LOADING_TILES) {
+      break;
+    }
+
+    int slot = take_slot();
+
+    if (slot < 0) {
+      break;
+    }
+
+    requests.push(TileRequest{level, tile, slot});
+
+    slots[slot] = Slot{level, tile, SlotState::LOADING, update_count};
+    tile_slot = slot;
+
+    stats.loading_tiles++;
+
+  }
+
+  return false;
+
+}
+
+void TerrainStreamer::update(const Ball *balls, const BallRecord *records,
+                             int count) {
+
+  ZoneScoped; // for tracy
+
+  update_count++;
+
+  install_loaded_tiles();
+
+  // A file with one level is all resident from the start
+  if (tile_slots.empty()) {
+    stats.lookups += count;
+    stats.hits += count;
+    return;
+  }
+
+  int loading_before = stats.loading_tiles;
+
+  for (int i = 0; i < count; i++) {
+
+    const Ball &ball = balls[i];
+
+    stats.lookups++;
+
+    if (request_tiles(ball.position.x, ball.position.y)) {
+      stats.hits++;
+    }
+
+    // Balls in flight take turns looking ahead, so each one does every
+    // PREFETCH_PERIOD updates
+    if (records[i].phase != BallPhase::FLIGHT
+        || (update_count + i) % PREFETCH_PERIOD != 0) {
+      continue;
+    }
+
+    // Along the path it would take without drag or lift, which runs long,
+    // until it's below the lowest ground. The near points are the ones that
+    // matter, and they're close enough.
+    for (int step = 1; step <= PREFETCH_STEPS; step++) {
+
+      float t = static_cast<float>(step) * PREFETCH_INTERVAL;
+      vec3 position = ball.position + ball.velocity * t
+                      + GRAVITY_VEC * (0.5f * t * t);
+
+      request_tiles(position.x, position.y);
+
+      if (position.z < terrain.get_min_height()) {
+        break;
+      }
+
+    }
+
+  }
+
+  if (stats.loading_tiles > loading_before) {
+    request_signal.fetch_add(1, std::memory_order_release);
+    request_signal.notify_one();
+  }
+
+}
+
+const Terrain &TerrainStreamer::get_terrain() const {
+  return terrain;
+}
+
+const Terrain &TerrainStreamer::get_overview() const {
+  return overview;
+}
+
+const TerrainCacheStats &TerrainStreamer::get_stats() const {
+  return stats;
+}
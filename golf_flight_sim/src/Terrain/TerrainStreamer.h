@@ -0,0 +1,149 @@
+#pragma once
+
+#include "../Components/Ball.h"
+#include "../misc/mapped_file.h"
+#include "../misc/spsc_queue.h"
+#include "Terrain.h"
+#include "terrain_file.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Tile cache counters since the streamer was opened
+struct TerrainCacheStats {
+
+  // One per ball per update. A hit is a ball whose tile of the finest level
+  // was resident, so its queries got the full detail.
+  uint64_t lookups = 0;
+  uint64_t hits = 0;
+
+  // Tiles paged in from the file, and thrown out to make room for others
+  uint64_t loads = 0;
+  uint64_t evictions = 0;
+
+  int resident_tiles = 0;
+  int loading_tiles = 0;
+  int capacity = 0;
+
+  float get_hit_rate() const;
+
+};
+
+/*
+  Streams a terrain too big to keep in memory from a terrain file (see
+  terrain_file.h). The file is memory mapped and only the coarsest level is
+  read up front. Finer tiles are paged into a fixed size cache around the
+  balls that are moving, and ahead of them along where they're heading, and
+  the least recently used ones are thrown out to make room.
+
+  The physics thread never reads the file. update() only asks a loader
+  thread for tiles and installs the ones it has finished since the last
+  call, so page faults and disk reads all happen on the loader thread. Until
+  a tile arrives, queries over it fall back to the next coarser level that's
+  resident (see Terrain.h).
+
+  get_terrain() and update() belong to the physics thread. get_overview()
+  is the coarsest level on its own, which never changes, so any thread can
+  read it.
+*/
+class TerrainStreamer {
+private:
+  struct TileRequest {
+
+    int level;
+    int tile;
+    int slot;
+
+  };
+
+  enum class SlotState : uint8_t { FREE, LOADING, RESIDENT };
+
+  struct Slot {
+
+    int level;
+    int tile;
+    SlotState state;
+    uint64_t last_used;
+
+  };
+
+  MappedFile file;
+  std::vector<TerrainFileLevel> file_levels;
+
+  Terrain terrain;
+  Terrain overview;
+
+  // Every tile of the coarsest level, shared by terrain and overview
+  std::vector<Terrain::Cell> coarse_cells;
+
+  // The cache, TILE_CELLS cells per slot
+  std::vector<Terrain::Cell> slot_cells;
+  std::vector<Slot> slots;
+  std::vector<int> free_slots;
+
+  // For the levels above the coarsest, the slot each tile is in, or -1
+  std::vector<std::vector<int>> tile_slots;
+
+  // Physics thread to loader and back. A slot is only touched by the loader
+  // between the two.
+  SPSCQueue<TileRequest, 256> requests;
+  SPSCQueue<TileRequest, 256> loaded;
+
+  // Bumped after pushing requests, for the loader to wait on
+  std::atomic<uint32_t> request_signal{0};
+
+  std::atomic<bool> is_running{false};
+  std::thread loader;
+
+  uint64_t update_count;
+  TerrainCacheStats stats;
+
+  void run_loader();
+
+  // Reads a tile from the file and builds its cells. Can block on the disk.
+  void load_tile(int level, int tile, Terrain::Cell *cells) const;
+
+  void install_loaded_tiles();
+
+  // Asks for the tiles under (x, y) that aren't resident or on their way,
+  // coarse to fine so the fallback improves while the finer ones load.
+  // Returns whether the finest one is resident.
+  bool request_tiles(float x, float y);
+
+  // A free slot, or the least recently used resident one if there aren't
+  // any. Returns -1 if every slot was used in this update or is loading.
+  int take_slot();
+
+public:
+  // Tiles kept in memory, 16 KB each
+  static const int DEFAULT_CAPACITY = 1024;
+
+  // Balls in flight have their path looked ahead along every
+  // PREFETCH_PERIOD updates, a few at a time, at PREFETCH_INTERVAL second
+  // intervals for up to PREFETCH_STEPS intervals
+  static const int PREFETCH_PERIOD = 8;
+  static const int PREFETCH_STEPS = 8;
+  static constexpr float PREFETCH_INTERVAL = 0.25f;
+
+  TerrainStreamer();
+  ~TerrainStreamer();
+
+  TerrainStreamer(const TerrainStreamer &) = delete;
+  TerrainStreamer &operator=(const TerrainStreamer &) = delete;
+
+  // Maps the file, reads its coarsest level and starts the loader. Returns
+  // false if the file can't be mapped or isn't a terrain file. Only once per
+  // streamer.
+  bool open(const char *path, int capacity = DEFAULT_CAPACITY);
+
+  const Terrain &get_terrain() const;
+  const Terrain &get_overview() const;
+
+  // Physics thread, between steps. balls and records are the count balls
+  // that may query the terrain in the next step.
+  void update(const Ball *balls, const BallRecord *records, int count);
+
+  const TerrainCacheStats &get_stats() const;
+
+};
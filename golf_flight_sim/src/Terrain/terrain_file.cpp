@@ -0,0 +1,189 @@
+#include "terrain_file.h"
+#include "../Physics/constants.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+bool write_terrain_file(const char *path, float origin_x, float origin_y,
+                        float spacing, int samples_x, int samples_y,
+                        int num_levels,
+                        const std::function<float(int, int)> &height) {
+
+  if (samples_x < 2 || samples_y < 2 || num_levels < 1) {
+    return false;
+  }
+
+  TerrainFileHeader header = {};
+  std::memcpy(header.magic, TERRAIN_FILE_MAGIC, sizeof(header.magic));
+  header.version = TERRAIN_FILE_VERSION;
+  header.tile_size = Terrain::TILE_SIZE;
+  header.num_levels = static_cast<uint32_t>(num_levels);
+  header.origin_x = origin_x;
+  header.origin_y = origin_y;
+
+  std::vector<TerrainFileLevel> levels(num_levels);
+  uint64_t offset =
+      sizeof(TerrainFileHeader) + levels.size() * sizeof(TerrainFileLevel);
+
+  for (int l = 0; l < num_levels; l++) {
+
+    int stride = 1 << l;
+
+    // Rounded up, so a coarse level covers all of the one before it
+    TerrainFileLevel &level = levels[l];
+    level.spacing = spacing * static_cast<float>(stride);
+    level.samples_x = (samples_x - 1 + stride - 1) / stride + 1;
+    level.samples_y = (samples_y - 1 + stride - 1) / stride + 1;
+    level.tiles_x = (level.samples_x - 1 + Terrain::TILE_SIZE - 1)
+                    / Terrain::TILE_SIZE;
+    level.tiles_y = (level.samples_y - 1 + Terrain::TILE_SIZE - 1)
+                    / Terrain::TILE_SIZE;
+    level.min_height = INFINITY;
+    level.max_height = -INFINITY;
+    level.offset = offset;
+
+    offset += static_cast<uint64_t>(level.tiles_x * level.tiles_y)
+              * TERRAIN_FILE_TILE_BYTES;
+
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+  if (!file) {
+    return false;
+  }
+
+  // The header and level table go in last, once the height ranges are known
+  file.seekp(static_cast<std::streamoff>(levels[0].offset));
+
+  std::vector<float> samples(Terrain::TILE_SAMPLES * Terrain::TILE_SAMPLES);
+
+  for (int l = 0; l < num_levels; l++) {
+
+    TerrainFileLevel &level = levels[l];
+    int stride = 1 << l;
+
+    auto level_height = [&](int i, int j) {
+      return height(std::min(i * stride, samples_x - 1),
+                    std::min(j * stride, samples_y - 1));
+    };
+
+    for (int j = 0; j < level.samples_y; j++) {
+      for (int i = 0; i < level.samples_x; i++) {
+
+        float sample = level_height(i, j);
+        level.min_height = std::min(level.min_height, sample);
+        level.max_height = std::max(level.max_height, sample);
+
+      }
+    }
+
+    for (int tile_y = 0; tile_y < level.tiles_y; tile_y++) {
+      for (int tile_x = 0; tile_x < level.tiles_x; tile_x++) {
+
+        Terrain::gather_tile_samples(level_height, level.samples_x,
+                                     level.samples_y, tile_x, tile_y,
+                                     samples.data());
+        file.write(reinterpret_cast<const char *>(samples.data()),
+                   TERRAIN_FILE_TILE_BYTES);
+
+      }
+    }
+
+  }
+
+  file.seekp(0);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(levels.data()),
+             levels.size() * sizeof(TerrainFileLevel));
+
+  return static_cast<bool>(file);
+
+}
+
+bool write_example_course(const char *path) {
+
+  // The tee is 128 samples in from the back and 1024 in from the side, a
+  // multiple of the coarsest level's stride of 16
+  const float spacing = 0.5f;
+  const float origin_x = -64.0f;
+  const float origin_y = -512.0f;
+  const int samples_x = 4097;
+  const int samples_y = 2049;
+  const int num_levels = 5;
+
+  auto height = [&](int i, int j) {
+
+    float x = origin_x + static_cast<float>(i) * spacing;
+    float y = origin_y + static_cast<float>(j) * spacing;
+
+    // The same swells as Terrain::rolling_hills() on top of a slow rise and
+    // fall of a few meters across the whole course
+    return 1.0f * std::sin(2.0f * PI * x / 90.0f)
+               * std::cos(2.0f * PI * y / 70.0f)
+           + 0.5f * std::sin(2.0f * PI * (x + y) / 60.0f)
+           + 0.15f * std::cos(2.0f * PI * (x - 2.0f * y) / 30.0f)
+           + 3.0f * std::sin(2.0f * PI * x / 800.0f)
+                 * std::sin(2.0f * PI * y / 600.0f);
+
+  };
+
+  return write_terrain_file(path, origin_x, origin_y, spacing, samples_x,
+                            samples_y, num_levels, height);
+
+}
+
+bool read_terrain_file_levels(const uint8_t *data, size_t size,
+                              TerrainFileHeader &header,
+                              std::vector<TerrainFileLevel> &levels) {
+
+  if (size < sizeof(TerrainFileHeader)) {
+    return false;
+  }
+
+  std::memcpy(&header, data, sizeof(header));
+
+  if (std::memcmp(header.magic, TERRAIN_FILE_MAGIC, sizeof(header.magic)) != 0
+      || header.version != TERRAIN_FILE_VERSION
+      || header.tile_size != static_cast<uint32_t>(Terrain::TILE_SIZE)
+      || header.num_levels < 1 || header.num_levels > 32) {
+    return false;
+  }
+
+  size_t table_end =
+      sizeof(TerrainFileHeader) + header.num_levels * sizeof(TerrainFileLevel);
+
+  if (size < table_end) {
+    return false;
+  }
+
+  levels.resize(header.num_levels);
+  std::memcpy(levels.data(), data + sizeof(TerrainFileHeader),
+              levels.size() * sizeof(TerrainFileLevel));
+
+  for (const TerrainFileLevel &level : levels) {
+
+    int tiles_x = (level.samples_x - 1 + Terrain::TILE_SIZE - 1)
+                  / Terrain::TILE_SIZE;
+    int tiles_y = (level.samples_y - 1 + Terrain::TILE_SIZE - 1)
+                  / Terrain::TILE_SIZE;
+
+    if (!(level.spacing > 0.0f) || level.samples_x < 2 || level.samples_y < 2
+        || level.tiles_x != tiles_x || level.tiles_y != tiles_y
+        || level.offset < table_end) {
+      return false;
+    }
+
+    uint64_t bytes = static_cast<uint64_t>(tiles_x) * tiles_y
+                     * TERRAIN_FILE_TILE_BYTES;
+
+    if (level.offset > size || bytes > size - level.offset) {
+      return false;
+    }
+
+  }
+
+  return true;
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Terrain.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/*
+  Tiled, multi-resolution height files, which TerrainStreamer maps and pages
+  in tile by tile. Laid out as
+
+    TerrainFileHeader
+    TerrainFileLevel for each level, finest first
+    the tiles of each level, row by row
+
+  Level l has 2^l times the spacing of level 0 and takes every 2^l-th sample
+  of it, so every level passes through the same heights wherever their
+  samples line up. A tile is the Terrain::TILE_SAMPLES^2 float heights that
+  Terrain::gather_tile_samples() gives for it, ready to build its cells from
+  without touching any other tile. That repeats the samples along the tile
+  edges, about 40% more than the heights alone.
+
+  Everything is stored in the byte order of the machine that wrote it, which
+  is little endian for everything this runs on.
+*/
+
+const char TERRAIN_FILE_MAGIC[8] = {'G', 'F', 'S', 'T', 'E', 'R', 'R', '\0'};
+const uint32_t TERRAIN_FILE_VERSION = 1;
+
+struct TerrainFileHeader {
+
+  char magic[8];
+  uint32_t version;
+  uint32_t tile_size;
+  uint32_t num_levels;
+  float origin_x;
+  float origin_y;
+  uint32_t padding;
+
+};
+
+struct TerrainFileLevel {
+
+  float spacing;
+  int32_t samples_x;
+  int32_t samples_y;
+  int32_t tiles_x;
+  int32_t tiles_y;
+  float min_height;
+  float max_height;
+  uint32_t padding;
+
+  // Of the level's first tile, from the start of the file
+  uint64_t offset;
+
+};
+
+static_assert(sizeof(TerrainFileHeader) == 32, "Unexpected header padding");
+static_assert(sizeof(TerrainFileLevel) == 40, "Unexpected level padding");
+
+const size_t TERRAIN_FILE_TILE_BYTES =
+    Terrain::TILE_SAMPLES * Terrain::TILE_SAMPLES * sizeof(float);
+
+// height(i, j) is the sample at (origin_x + i * spacing, origin_y + j *
+// spacing) for i < samples_x and j < samples_y. Returns false if the file
+// can't be written.
+bool write_terrain_file(const char *path, float origin_x, float origin_y,
+                        float spacing, int samples_x, int samples_y,
+                        int num_levels,
+                        const std::function<float(int, int)> &height);
+
+// Where the app looks for a course to stream, relative to where it's run
+const char *const EXAMPLE_COURSE_PATH = "course.terrain";
+
+// A course about 2 km by 1 km of rolling ground sampled every half meter,
+// for trying out streaming. The tee at the origin is on a sample of every
+// level. Around 60 MB.
+bool write_example_course(const char *path);
+
+// Checks that the header and level table are sane and that every tile is
+// inside the size bytes of the file. Fills in levels, finest first.
+bool read_terrain_file_levels(const uint8_t *data, size_t size,
+                              TerrainFileHeader &header,
+                              std::vector<TerrainFileLevel> &levels);
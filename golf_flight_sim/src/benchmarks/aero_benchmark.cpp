@@ -0,0 +1,247 @@
+#include "aero_benchmark.h"
+#include "../Physics/flight.h"
+#include "../Physics/launch.h"
+#include "../math/simd.h"
+#include "../math/stats.h"
+#include "../math/unit_conversion.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const int SAMPLES_PER_SIDE = 8;
+
+const int NUM_RUNS = 10;
+const int NUM_LOOKUPS = 1 << 16;
+const int NUM_SHOTS = 64;
+
+const float TIMESTEP = 1.0f / 240.0f;
+const int MAX_STEPS = 240 * 30;
+const vec3 TEE_POSITION(0.0f, 0.0f, 0.0381f);
+
+// Four to a line, so they fit in 80 columns
+void print_terms(const char *name, const float *terms) {
+
+  std::printf("    // %s\n    {", name);
+
+  for (int i = 0; i < NUM_AERO_TERMS; i++) {
+
+    const char *separator = i + 1 == NUM_AERO_TERMS ? "},\n"
+                            : i % 4 == 3           ? ",\n     "
+                                                   : ", ";
+    std::printf("%.8gf%s", terms[i], separator);
+
+  }
+
+}
+
+// Everything from a wedge to a driver, as in the sensitivity benchmark
+std::vector<LaunchConditions<float>> make_shots() {
+
+  std::vector<LaunchConditions<float>> shots(NUM_SHOTS);
+
+  for (int i = 0; i < NUM_SHOTS; i++) {
+
+    shots[i].speed = mph_to_ms(80.0f + static_cast<float>(i % 8) * 12.0f);
+    shots[i].angle = deg_to_rad(8.0f + static_cast<float>(i / 8) * 3.0f);
+    shots[i].heading = 0.0f;
+    shots[i].spin_rate = 2000.0f + static_cast<float>(i % 5) * 1500.0f;
+    shots[i].spin_axis = 0.0f;
+
+  }
+
+  return shots;
+
+}
+
+template <typename AeroModel> float get_carry(LaunchConditions<float> shot) {
+
+  FlightState<float> state = get_launch_state(shot, TEE_POSITION);
+
+  fly_to_landing<UniformWind, SemiImplicitEuler, AeroModel>(
+      state, vec3(0.0f, 0.0f, 0.0f), REFERENCE_AIR, TIMESTEP, MAX_STEPS);
+
+  return std::sqrt(state.position.x * state.position.x
+                   + state.position.y * state.position.y);
+
+}
+
+// Nanoseconds per lookup, over inputs spread through the table
+template <typename T, typename AeroModel>
+double time_lookups(const std::vector<float> &speeds_squared,
+                    const std::vector<float> &spin_rates, float &checksum) {
+
+  constexpr int lanes = sizeof(T) / sizeof(float);
+
+  const AirConstants<T> air(REFERENCE_AIR);
+  T sum(0.0f);
+
+  auto start = std::chrono::high_resolution_clock::now();
+
+  for (int i = 0; i < NUM_LOOKUPS; i += lanes) {
+
+    T speed_squared;
+    T spin_rate;
+
+    if constexpr (lanes == 1) {
+      speed_squared = speeds_squared[i];
+      spin_rate = spin_rates[i];
+    } else {
+      speed_squared = T::load(&speeds_squared[i]);
+      spin_rate = T::load(&spin_rates[i]);
+    }
+
+    std::pair<T, T> coefficients =
+        AeroModel::get_coefficients(speed_squared, spin_rate, air);
+    sum = sum + coefficients.first + coefficients.second;
+
+  }
+
+  auto end = std::chrono::high_resolution_clock::now();
+
+  // Keeps the lookups from being optimized away
+  float lanes_sum[lanes];
+
+  if constexpr (lanes == 1) {
+    lanes_sum[0] = sum;
+  } else {
+    sum.store(lanes_sum);
+  }
+
+  for (float value : lanes_sum) {
+    checksum += value;
+  }
+
+  std::chrono::duration<double, std::nano> elapsed = end - start;
+  return elapsed.count() / NUM_LOOKUPS;
+
+}
+
+template <typename T, typename AeroModel>
+void report_lookups(const char *name, const std::vector<float> &speeds_squared,
+                    const std::vector<float> &spin_rates) {
+
+  std::vector<double> ns;
+  float checksum = 0.0f;
+
+  for (int run = 0; run < NUM_RUNS; run++) {
+    ns.push_back(time_lookups<T, AeroModel>(speeds_squared, spin_rates,
+                                            checksum));
+  }
+
+  double mean = 0.0;
+
+  for (double value : ns) {
+    mean += value;
+  }
+
+  mean /= static_cast<double>(ns.size());
+
+  std::printf("%-16s %7.2f +/- %5.2f ns per lookup (checksum %g)\n", name,
+              mean, stdev_s(ns), checksum);
+
+}
+
+} // namespace
+
+void run_aero_fit() {
+
+  AeroFitReport report =
+      fit_aero_table(DRAG_AND_LIFT_COEFFICIENTS_ARR, SAMPLES_PER_SIDE);
+
+  std::printf("Fit to %d points, %d to a cell\n", report.num_samples,
+              SAMPLES_PER_SIDE * SAMPLES_PER_SIDE);
+  std::printf("%-14s %9s %9s %9s %9s\n", "air speed", "Cd rms", "Cd max",
+              "Cl rms", "Cl max");
+
+  for (int row = 0; row <= 10; row++) {
+
+    const AeroFitError &error = row < 10 ? report.rows[row] : report.total;
+
+    char name[32];
+
+    if (row == 10) {
+      std::snprintf(name, sizeof(name), "all");
+    } else if (row == 9) {
+      std::snprintf(name, sizeof(name), "above %.0f m/s",
+                    std::sqrt(AIR_SPEED_SQUARED_BANDS[row - 1]));
+    } else {
+      std::snprintf(name, sizeof(name), "below %.0f m/s",
+                    std::sqrt(AIR_SPEED_SQUARED_BANDS[row]));
+    }
+
+    std::printf("%-14s %9.4f %9.4f %9.4f %9.4f\n", name, error.drag_rms,
+                error.drag_max, error.lift_rms, error.lift_max);
+
+  }
+
+  const AeroFit &fit = report.fit;
+
+  std::printf("\nconst AeroFit AERO_FIT = {\n");
+  print_terms("drag", fit.drag);
+  print_terms("lift", fit.lift);
+  std::printf("    %.8gf,\n    %.8gf,\n    %.8gf};\n", fit.min_u, fit.max_u,
+              fit.max_spin_ratio);
+
+}
+
+void run_aero_benchmark() {
+
+  // Air speeds from 5 to 90 m/s and spin rates up to 9000 rpm, in a fixed
+  // pseudorandom order so neither lookup gets a predictable pattern
+  std::vector<float> speeds_squared(NUM_LOOKUPS);
+  std::vector<float> spin_rates(NUM_LOOKUPS);
+
+  uint32_t state = 12345;
+
+  auto next_fraction = [&state]() {
+    state = state * 1664525u + 1013904223u;
+    return static_cast<float>(state >> 8) / 16777216.0f;
+  };
+
+  for (int i = 0; i < NUM_LOOKUPS; i++) {
+
+    float speed = 5.0f + 85.0f * next_fraction();
+    speeds_squared[i] = speed * speed;
+    spin_rates[i] = 9000.0f * next_fraction();
+
+  }
+
+  std::printf("%d coefficient lookups, %d runs\n", NUM_LOOKUPS, NUM_RUNS);
+  report_lookups<float, TableAero>("table", speeds_squared, spin_rates);
+  report_lookups<float, SmoothAero>("smooth", speeds_squared, spin_rates);
+  report_lookups<float8, TableAero>("table float8", speeds_squared,
+                                    spin_rates);
+  report_lookups<float8, SmoothAero>("smooth float8", speeds_squared,
+                                     spin_rates);
+
+  std::vector<LaunchConditions<float>> shots = make_shots();
+
+  double mean_difference = 0.0;
+  double max_difference = 0.0;
+  double mean_carry = 0.0;
+
+  for (const LaunchConditions<float> &shot : shots) {
+
+    double table_carry = m_to_yd(get_carry<TableAero>(shot));
+    double smooth_carry = m_to_yd(get_carry<SmoothAero>(shot));
+    double difference = std::fabs(smooth_carry - table_carry);
+
+    mean_carry += table_carry;
+    mean_difference += difference;
+    max_difference = std::fmax(max_difference, difference);
+
+  }
+
+  mean_carry /= NUM_SHOTS;
+  mean_difference /= NUM_SHOTS;
+
+  std::printf("%d shots, mean carry %.1f yd with the table\n", NUM_SHOTS,
+              mean_carry);
+  std::printf("smooth fit carries differ by %.2f yd on average, %.2f yd at "
+              "most\n",
+              mean_difference, max_difference);
+
+}
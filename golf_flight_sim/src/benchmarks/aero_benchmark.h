@@ -0,0 +1,11 @@
+#pragma once
+
+// Fits the smooth aerodynamic model to the coefficient table (see
+// Physics/aero.h), prints how far the fit is from the table by row of air
+// speed, and prints the coefficients as the initializer for AERO_FIT.
+void run_aero_fit();
+
+// Times a coefficient lookup in the table and in the smooth fit, as scalars
+// and eight lanes at a time, and compares the carries of a set of shots
+// flown with each.
+void run_aero_benchmark();
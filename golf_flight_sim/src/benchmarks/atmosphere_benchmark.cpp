@@ -0,0 +1,185 @@
+#include "atmosphere_benchmark.h"
+#include "../Physics/environments.h"
+#include "../math/stats.h"
+#include "../math/unit_conversion.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const int NUM_RUNS = 10;
+const int NUM_SHOTS = 64;
+
+// Altitudes by temperatures
+const int NUM_ALTITUDES = 8;
+const int NUM_TEMPERATURES = 8;
+
+const float TIMESTEP = 1.0f / 240.0f;
+const vec3 TEE_POSITION(0.0f, 0.0f, 0.0381f);
+const vec3 WIND_VELOCITY(0.0f, 0.0f, 0.0f);
+
+struct Site {
+
+  const char *name;
+  SiteConditions conditions;
+
+};
+
+const Site SITES[] = {
+    {"reference", STANDARD_SITE},
+    {"coast", {0.0f, 15.0f, 0.8f, 0.0f}},
+    {"denver", {1609.0f, 25.0f, 0.3f, 0.0f}},
+    {"high desert", {2400.0f, 32.0f, 0.1f, 0.0f}},
+    {"winter", {0.0f, 2.0f, 0.6f, 0.0f}}};
+
+// Everything from a wedge to a driver, as in the sensitivity benchmark
+std::vector<LaunchConditions<float>> make_shots() {
+
+  std::vector<LaunchConditions<float>> shots(NUM_SHOTS);
+
+  for (int i = 0; i < NUM_SHOTS; i++) {
+
+    shots[i].speed = mph_to_ms(80.0f + static_cast<float>(i % 8) * 12.0f);
+    shots[i].angle = deg_to_rad(8.0f + static_cast<float>(i / 8) * 3.0f);
+    shots[i].heading = deg_to_rad(static_cast<float>(i % 3 - 1) * 2.0f);
+    shots[i].spin_rate = 2000.0f + static_cast<float>(i % 5) * 1000.0f;
+    shots[i].spin_axis = deg_to_rad(static_cast<float>(i % 7 - 3) * 5.0f);
+
+  }
+
+  return shots;
+
+}
+
+// Sea level to 3000 m, freezing to hot
+std::vector<AirConstants<float>> make_environments() {
+
+  std::vector<AirConstants<float>> environments;
+
+  for (int i = 0; i < NUM_ALTITUDES; i++) {
+    for (int j = 0; j < NUM_TEMPERATURES; j++) {
+
+      SiteConditions site;
+      site.altitude = static_cast<float>(i) * 3000.0f / (NUM_ALTITUDES - 1);
+      site.temperature = static_cast<float>(j) * 40.0f / (NUM_TEMPERATURES - 1);
+      site.relative_humidity = 0.5f;
+      site.pressure = 0.0f;
+
+      environments.push_back(get_air_constants(site));
+
+    }
+  }
+
+  return environments;
+
+}
+
+double get_mean(const std::vector<double> &values) {
+
+  double sum = 0.0;
+
+  for (double value : values) {
+    sum += value;
+  }
+
+  return sum / static_cast<double>(values.size());
+
+}
+
+} // namespace
+
+void run_atmosphere_benchmark() {
+
+  // A driver
+  LaunchConditions<float> drive;
+  drive.speed = mph_to_ms(160.0f);
+  drive.angle = deg_to_rad(11.0f);
+  drive.heading = 0.0f;
+  drive.spin_rate = 2600.0f;
+  drive.spin_axis = 0.0f;
+
+  const float coast_carry =
+      get_landing(drive, TEE_POSITION, WIND_VELOCITY,
+                  get_air_constants(SITES[1].conditions),
+                  WindModelType::UNIFORM, IntegratorType::SEMI_IMPLICIT_EULER,
+                  AeroModelType::TABLE, TIMESTEP)
+          .carry;
+
+  std::printf("A 160 mph drive at 11 degrees and 2600 rpm\n");
+  std::printf("%-12s %10s %14s %10s %10s\n", "site", "density",
+              "viscosity", "carry", "vs coast");
+
+  for (const Site &site : SITES) {
+
+    AirProperties air = get_air_properties(site.conditions);
+    Landing landing = get_landing(
+        drive, TEE_POSITION, WIND_VELOCITY, get_air_constants(air),
+        WindModelType::UNIFORM, IntegratorType::SEMI_IMPLICIT_EULER,
+        AeroModelType::TABLE, TIMESTEP);
+
+    std::printf("%-12s %10.4f %14.4g %7.1f yd %+9.1f%%\n", site.name,
+                air.density, air.kinematic_viscosity, m_to_yd(landing.carry),
+                100.0f * (landing.carry / coast_carry - 1.0f));
+
+  }
+
+  std::vector<LaunchConditions<float>> shots = make_shots();
+  std::vector<AirConstants<float>> environments = make_environments();
+
+  const size_t num_environments = environments.size();
+
+  std::vector<Landing> scalar_landings(shots.size() * num_environments);
+  std::vector<Landing> swept_landings;
+
+  std::vector<double> scalar_ns;
+  std::vector<double> swept_ns;
+
+  for (int run = 0; run < NUM_RUNS; run++) {
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (size_t i = 0; i < shots.size(); i++) {
+      for (size_t j = 0; j < num_environments; j++) {
+        scalar_landings[i * num_environments + j] = get_landing(
+            shots[i], TEE_POSITION, WIND_VELOCITY, environments[j],
+            WindModelType::UNIFORM, IntegratorType::SEMI_IMPLICIT_EULER,
+            AeroModelType::TABLE, TIMESTEP);
+      }
+    }
+
+    auto middle = std::chrono::high_resolution_clock::now();
+
+    swept_landings = fly_across_environments(
+        shots, environments, TEE_POSITION, WIND_VELOCITY,
+        WindModelType::UNIFORM, IntegratorType::SEMI_IMPLICIT_EULER, TIMESTEP);
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double, std::nano> scalar_elapsed = middle - start;
+    std::chrono::duration<double, std::nano> swept_elapsed = end - middle;
+
+    double count = static_cast<double>(scalar_landings.size());
+    scalar_ns.push_back(scalar_elapsed.count() / count);
+    swept_ns.push_back(swept_elapsed.count() / count);
+
+  }
+
+  double max_error = 0.0;
+
+  for (size_t i = 0; i < scalar_landings.size(); i++) {
+    max_error = std::fmax(max_error,
+                          std::fabs(scalar_landings[i].carry
+                                    - swept_landings[i].carry));
+  }
+
+  std::printf("%d shots in %d environments, %d runs\n", NUM_SHOTS,
+              static_cast<int>(num_environments), NUM_RUNS);
+  std::printf("one at a time  %9.0f +/- %6.0f ns per landing\n",
+              get_mean(scalar_ns), stdev_s(scalar_ns));
+  std::printf("swept          %9.0f +/- %6.0f ns per landing\n",
+              get_mean(swept_ns), stdev_s(swept_ns));
+  std::printf("max carry difference %.5f yd\n", m_to_yd(max_error));
+
+}
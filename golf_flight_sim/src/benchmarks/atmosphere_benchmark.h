@@ -0,0 +1,6 @@
+#pragma once
+
+// Prints the air and a driver's carry at a few sites, then flies a set of
+// shots through a grid of environments one landing at a time and in the
+// vectorized sweep (see Physics/environments.h), and compares the two.
+void run_atmosphere_benchmark();
@@ -0,0 +1,159 @@
+#include "calibration_benchmark.h"
+#include "../Physics/calibration.h"
+#include "../math/unit_conversion.h"
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int NUM_SHOTS = 96;
+
+// The launch monitor's measurement noise, in meters
+const float CARRY_NOISE = 0.8f;
+const float TOTAL_NOISE = 2.0f;
+const float APEX_NOISE = 0.5f;
+
+// A range session that's slightly off the simulation everywhere: thinner
+// drag, a little less lift, spin that dies off faster and a softer, grabbier
+// green that runs out more slowly
+const PhysicsParameters SESSION_PARAMETERS = {
+    {0.94f, 1.07f, 20.0f, 0.022f, 0.46f, 0.16f}};
+
+// Wedges to drivers with a spread of launches, the way a session goes
+std::vector<MeasuredShot> make_session(std::mt19937 &rng) {
+
+  std::uniform_real_distribution<float> fraction(0.0f, 1.0f);
+  std::normal_distribution<float> noise(0.0f, 1.0f);
+
+  std::vector<MeasuredShot> shots(NUM_SHOTS);
+
+  for (int i = 0; i < NUM_SHOTS; i++) {
+
+    // From a wedge at 0 to a driver at 1
+    float club = fraction(rng);
+
+    LaunchConditions<float> &launch = shots[i].launch;
+    launch.speed = mph_to_ms(95.0f + 75.0f * club + 6.0f * noise(rng));
+    launch.angle = deg_to_rad(28.0f - 16.0f * club + 2.0f * noise(rng));
+    launch.heading = deg_to_rad(3.0f * noise(rng));
+    launch.spin_rate = 8500.0f - 6000.0f * club + 400.0f * noise(rng);
+    launch.spin_axis = deg_to_rad(5.0f * noise(rng));
+
+    ShotOutcome outcome = simulate_shot(launch, SESSION_PARAMETERS);
+
+    shots[i].observed.carry = outcome.carry + CARRY_NOISE * noise(rng);
+    shots[i].observed.total = outcome.total + TOTAL_NOISE * noise(rng);
+    shots[i].observed.apex = outcome.apex + APEX_NOISE * noise(rng);
+
+  }
+
+  return shots;
+
+}
+
+void print_result(const CalibrationResult &result,
+                  const PhysicsParameters *expected) {
+
+  std::printf("%d observations, %d iterations, %d shots flown in %.0f ms "
+              "(%.1f us per shot)\n",
+              result.num_observations, result.iterations,
+              result.num_simulations, result.time_ms,
+              1000.0f * result.time_ms
+                  / static_cast<float>(result.num_simulations));
+  std::printf("rms residual %.3f -> %.3f, rms error carry %.2f yd, total "
+              "%.2f yd, apex %.2f ft\n",
+              result.initial_rms, result.rms, m_to_yd(result.carry_rms),
+              m_to_yd(result.total_rms), m_to_ft(result.apex_rms));
+
+  std::printf("%-16s %12s %12s %12s", "parameter", "initial", "fitted",
+              "uncertainty");
+
+  if (expected != nullptr) {
+    std::printf(" %12s", "expected");
+  }
+
+  std::printf("\n");
+
+  for (int i = 0; i < NUM_CALIBRATION_PARAMETERS; i++) {
+
+    std::printf("%-16s %12.5g %12.5g", CALIBRATION_PARAMETER_NAMES[i],
+                result.initial.values[i], result.parameters.values[i]);
+
+    // Parameters the shots couldn't pin down stay where they started
+    if (result.identified[i]) {
+      std::printf(" %12.2g", result.uncertainties[i]);
+    } else {
+      std::printf(" %12s", "kept");
+    }
+
+    if (expected != nullptr) {
+      std::printf(" %12.5g", expected->values[i]);
+    }
+
+    std::printf("\n");
+
+  }
+
+}
+
+} // namespace
+
+bool run_calibration(const char *shots_path, const char *output_path) {
+
+  std::vector<MeasuredShot> shots;
+
+  if (!load_measured_shots(shots_path, shots)) {
+    std::printf("Couldn't read shots from %s\n", shots_path);
+    return false;
+  }
+
+  std::printf("%d shots from %s\n", static_cast<int>(shots.size()),
+              shots_path);
+
+  CalibrationSettings settings;
+  CalibrationResult result =
+      calibrate(shots, DEFAULT_PHYSICS_PARAMETERS, settings);
+
+  print_result(result, nullptr);
+
+  if (!write_calibration(output_path, result, settings)) {
+    std::printf("Couldn't write %s\n", output_path);
+    return false;
+  }
+
+  std::printf("Wrote %s\n", output_path);
+  return true;
+
+}
+
+void run_calibration_benchmark() {
+
+  std::mt19937 rng(42);
+  std::vector<MeasuredShot> shots = make_session(rng);
+
+  int num_cores = static_cast<int>(std::thread::hardware_concurrency());
+
+  std::printf("%d made up shots, calibrating from the defaults\n", NUM_SHOTS);
+
+  std::vector<int> thread_counts = {1};
+
+  if (num_cores > 1) {
+    thread_counts.push_back(num_cores);
+  }
+
+  for (int num_threads : thread_counts) {
+
+    CalibrationSettings settings;
+    settings.num_threads = num_threads;
+
+    std::printf("\n%d thread%s\n", num_threads, num_threads == 1 ? "" : "s");
+
+    CalibrationResult result =
+        calibrate(shots, DEFAULT_PHYSICS_PARAMETERS, settings);
+    print_result(result, &SESSION_PARAMETERS);
+
+  }
+
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+// Fits every calibration parameter (see Physics/calibration.h) to the shots
+// in a CSV file, prints how the fit went and writes the parameters to
+// output_path. Returns false if either file can't be used.
+bool run_calibration(const char *shots_path, const char *output_path);
+
+// Makes up a launch monitor session from known parameters, with measurement
+// noise, and checks how closely the calibration recovers them from the
+// simulation's defaults, on one thread and on every core. With nothing but
+// the total distance to go on, the bounce and the roll trade off against
+// each other, so the session's shots only identify the firmness of the
+// green. Its friction and roll friction are kept at their defaults.
+void run_calibration_benchmark();
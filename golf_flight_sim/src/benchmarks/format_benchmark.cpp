@@ -0,0 +1,93 @@
+#include "format_benchmark.h"
+#include "../math/stats.h"
+#include "../misc/fixed_string.h"
+#include "../misc/string_operations.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int NUM_RUNS = 10;
+const int NUM_VALUES = 100000;
+
+// Keeps the compiler from optimizing the formatting away
+volatile size_t sink = 0;
+
+template <typename Function>
+std::vector<double> time_runs(const std::vector<float> &values,
+                              Function format) {
+
+  std::vector<double> ns_per_value;
+
+  for (int run = 0; run < NUM_RUNS; run++) {
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (float value : values) {
+      sink = sink + format(value);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::nano> elapsed = end - start;
+
+    ns_per_value.push_back(elapsed.count() / values.size());
+
+  }
+
+  return ns_per_value;
+
+}
+
+void report(const char *name, std::vector<double> &ns_per_value) {
+
+  double mean = 0.0;
+
+  for (double ns : ns_per_value) {
+    mean += ns;
+  }
+
+  mean /= static_cast<double>(ns_per_value.size());
+
+  std::printf("%-32s %8.1f +/- %6.1f ns per label\n", name, mean,
+              stdev_s(ns_per_value));
+
+}
+
+} // namespace
+
+void run_format_benchmark() {
+
+  // Same kind of values the UI shows: FPS, wind speed and ball info
+  std::vector<float> values(NUM_VALUES);
+
+  for (int i = 0; i < NUM_VALUES; i++) {
+    values[i] = static_cast<float>(i % 3000) * 0.137f - 150.0f;
+  }
+
+  std::vector<double> stringstream_ns =
+      time_runs(values, [](float value) {
+        std::string label =
+            "FPS: " + string_ops::float_to_string_formatted(value, 1);
+        return label.size();
+      });
+
+  std::vector<double> to_chars_ns = time_runs(values, [](float value) {
+    char buffer[32];
+    return string_ops::format_fixed(buffer, sizeof(buffer), value, 1);
+  });
+
+  std::vector<double> fixed_string_ns = time_runs(values, [](float value) {
+    FixedString<64> label("FPS: ");
+    label.append_fixed(value, 1);
+    return label.size();
+  });
+
+  std::printf("Formatting %d values, %d runs\n", NUM_VALUES, NUM_RUNS);
+  report("stringstream", stringstream_ns);
+  report("format_fixed (to_chars)", to_chars_ns);
+  report("FixedString label", fixed_string_ns);
+
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Compares string_ops::float_to_string_formatted (stringstream) against the
+// allocation-free string_ops::format_fixed / FixedString path and prints the
+// average time per formatted label.
+void run_format_benchmark();
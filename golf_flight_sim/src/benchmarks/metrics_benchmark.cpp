@@ -0,0 +1,128 @@
+#include "metrics_benchmark.h"
+#include "../Physics/launch.h"
+#include "../Physics/sensitivity.h"
+#include "../Simulation/Simulation.h"
+#include "../math/unit_conversion.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+// Within the simulation's command queue, so they all launch at once
+const int NUM_SHOTS = 1000;
+
+// Shots summarized in full
+const int NUM_PRINTED = 8;
+
+const float TIMESTEP = 1.0f / PHYSICS_STEPS_PER_SECOND;
+const float MAX_TIME = 60.0f; // in seconds
+const vec3 TEE_POSITION(0.0f, 0.0f, TEE_HEIGHT);
+
+// Wedges to drivers, in a fixed spread
+std::vector<LaunchConditions<float>> make_shots() {
+
+  std::vector<LaunchConditions<float>> shots(NUM_SHOTS);
+
+  for (int i = 0; i < NUM_SHOTS; i++) {
+
+    // From a wedge at 0 to a driver at 1
+    float club = static_cast<float>(i % 100) / 99.0f;
+    float spread = static_cast<float>(i / 100) - 4.5f;
+
+    shots[i].speed = mph_to_ms(95.0f + 75.0f * club + spread);
+    shots[i].angle = deg_to_rad(28.0f - 16.0f * club + 0.3f * spread);
+    shots[i].heading = deg_to_rad(0.5f * spread);
+    shots[i].spin_rate = 8500.0f - 6000.0f * club + 80.0f * spread;
+    shots[i].spin_axis = deg_to_rad(spread);
+
+  }
+
+  return shots;
+
+}
+
+} // namespace
+
+void run_metrics_benchmark() {
+
+  std::vector<LaunchConditions<float>> shots = make_shots();
+
+  Simulation simulation(TIMESTEP, Wind(0.0f, 0.0f, false));
+  simulation.set_models(IntegratorType::SEMI_IMPLICIT_EULER,
+                        GroundType::SLOW_GREEN, AeroModelType::TABLE);
+
+  for (const LaunchConditions<float> &shot : shots) {
+
+    FlightState<float> state = get_launch_state(shot, TEE_POSITION);
+    simulation.launch_ball(state.position, state.velocity,
+                           state.rotation_axis, state.launch_spin_rate);
+
+  }
+
+  auto start = std::chrono::high_resolution_clock::now();
+
+  simulation.run_until_resting(MAX_TIME);
+
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::high_resolution_clock::now() - start;
+
+  std::vector<ShotMetrics> metrics;
+  simulation.get_shot_metrics(metrics);
+
+  int num_at_rest = 0;
+
+  for (const ShotMetrics &shot : metrics) {
+    num_at_rest += shot.at_rest ? 1 : 0;
+  }
+
+  std::printf("%d shots run to rest in %.1f ms, %d at rest\n", NUM_SHOTS,
+              elapsed.count(), num_at_rest);
+
+  std::printf("%6s %6s %6s %6s %6s %7s %7s %7s %7s %7s\n", "carry", "total",
+              "apex", "hang", "land", "offline", "bounce", "height",
+              "rollout", "landings");
+  std::printf("%6s %6s %6s %6s %6s %7s %7s %7s %7s\n", "(yd)", "(yd)", "(ft)",
+              "(s)", "(deg)", "(yd)", "(yd)", "(ft)", "(yd)");
+
+  for (int i = 0; i < NUM_PRINTED; i++) {
+
+    const ShotMetrics &shot = metrics[i * NUM_SHOTS / NUM_PRINTED + 50];
+
+    std::printf("%6.1f %6.1f %6.1f %6.2f %6.1f %7.2f %7.2f %7.2f %7.2f %7d\n",
+                m_to_yd(shot.carry), m_to_yd(shot.total),
+                m_to_ft(shot.apex), shot.hang_time,
+                rad_to_deg(shot.descent_angle), m_to_yd(shot.offline),
+                m_to_yd(shot.first_bounce_distance),
+                m_to_ft(shot.first_bounce_height), m_to_yd(shot.roll_out),
+                shot.num_landings);
+
+  }
+
+  // The same flights, landed by the sensitivity mode's interpolation
+  double max_carry_difference = 0.0;
+  double max_hang_difference = 0.0;
+
+  for (int i = 0; i < NUM_SHOTS; i++) {
+
+    Landing landing =
+        get_landing(shots[i], TEE_POSITION, vec3(0.0f, 0.0f, 0.0f),
+                    REFERENCE_AIR, WindModelType::UNIFORM,
+                    IntegratorType::SEMI_IMPLICIT_EULER,
+                    AeroModelType::TABLE, TIMESTEP);
+
+    max_carry_difference =
+        std::fmax(max_carry_difference,
+                  std::fabs(landing.carry - metrics[i].carry));
+    max_hang_difference =
+        std::fmax(max_hang_difference,
+                  std::fabs(landing.flight_time - metrics[i].hang_time));
+
+  }
+
+  std::printf("against the sensitivity mode's landings: carries within %.4f "
+              "yd, hang times within %.5f s\n",
+              m_to_yd(max_carry_difference), max_hang_difference);
+
+}
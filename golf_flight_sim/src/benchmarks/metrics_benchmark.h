@@ -0,0 +1,7 @@
+#pragma once
+
+// Runs a batch of shots to rest headless and prints their summaries from the
+// metrics the kernels accumulate (see Physics/metrics.h), without storing
+// any trajectory. Checks the carries and hang times against the sensitivity
+// mode's interpolated landings.
+void run_metrics_benchmark();
@@ -0,0 +1,105 @@
+#include "obstacle_benchmark.h"
+#include "../Obstacles/Obstacles.h"
+#include "../Physics/constants.h"
+#include "../math/stats.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+const int NUM_RUNS = 10;
+const int NUM_QUERIES = 100000;
+
+// Trees over a square this many meters across
+const float FOREST_SIZE = 1000.0f;
+
+// About as far as a drive goes in one step at 240 Hz
+const vec3 STEP(0.28f, 0.01f, -0.04f);
+
+// Keeps the compiler from optimizing the queries away
+volatile int sink = 0;
+
+Obstacles make_forest(int num_trees, std::mt19937 &rng) {
+
+  std::uniform_real_distribution<float> position(0.0f, FOREST_SIZE);
+  Obstacles forest;
+
+  for (int i = 0; i < num_trees; i++) {
+
+    vec3 base(position(rng), position(rng), 0.0f);
+
+    forest.add_capsule(base, base + vec3(0.0f, 0.0f, 5.0f), 0.25f,
+                       ObstacleMaterial::TREE);
+    forest.add_capsule(base + vec3(0.0f, 0.0f, 8.0f),
+                       base + vec3(0.0f, 0.0f, 8.0f), 3.5f,
+                       ObstacleMaterial::TREE);
+
+  }
+
+  forest.build();
+
+  return forest;
+
+}
+
+} // namespace
+
+void run_obstacle_benchmark() {
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> across(0.0f, FOREST_SIZE);
+  std::uniform_real_distribution<float> height(0.0f, 30.0f);
+
+  std::vector<vec3> starts(NUM_QUERIES);
+
+  for (vec3 &start : starts) {
+    start = vec3(across(rng), across(rng), height(rng));
+  }
+
+  std::printf("%d sweeps of a ball's step, %d runs\n", NUM_QUERIES, NUM_RUNS);
+  std::printf("%8s %8s %22s %8s\n", "trees", "shapes", "time", "hits");
+
+  for (int num_trees = 10; num_trees <= 100000; num_trees *= 10) {
+
+    Obstacles forest = make_forest(num_trees, rng);
+
+    std::vector<double> ns_per_query;
+    int hits = 0;
+
+    for (int run = 0; run < NUM_RUNS; run++) {
+
+      hits = 0;
+
+      auto start = std::chrono::high_resolution_clock::now();
+
+      for (const vec3 &position : starts) {
+        ObstacleHit hit;
+        hits += forest.sweep(position, position + STEP, RADIUS, hit) ? 1 : 0;
+      }
+
+      auto end = std::chrono::high_resolution_clock::now();
+      std::chrono::duration<double, std::nano> elapsed = end - start;
+
+      ns_per_query.push_back(elapsed.count() / NUM_QUERIES);
+
+    }
+
+    sink = sink + hits;
+
+    double mean_ns = 0.0;
+
+    for (double ns : ns_per_query) {
+      mean_ns += ns;
+    }
+
+    mean_ns /= static_cast<double>(ns_per_query.size());
+
+    std::printf("%8d %8d %8.1f +/- %5.1f ns %8d\n", num_trees,
+                static_cast<int>(forest.get_shapes().size()), mean_ns,
+                stdev_s(ns_per_query), hits);
+
+  }
+
+}
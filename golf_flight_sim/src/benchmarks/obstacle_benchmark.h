@@ -0,0 +1,6 @@
+#pragma once
+
+// Times swept-sphere queries for a ball's step against forests of more and
+// more trees, to show the cost growing with the depth of the bounding volume
+// hierarchy rather than with the number of obstacles.
+void run_obstacle_benchmark();
@@ -0,0 +1,216 @@
+#include "precision_benchmark.h"
+#include "../Physics/flight.h"
+#include "../Physics/models.h"
+#include "../math/stats.h"
+#include "../math/unit_conversion.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+const int NUM_RUNS = 10;
+
+// A multiple of 16 so every vector width divides it evenly
+const int NUM_LAUNCHES = 1024;
+
+const float TIMESTEP = 1.0f / 240.0f;
+const int MAX_STEPS = 240 * 30;
+
+// 10 mph crosswind at the reference height
+const vec3 WIND_VELOCITY(0.0f, 4.4704f, 0.0f);
+
+struct Launch {
+
+  vec3 velocity;
+  vec3 rotation_axis;
+  float spin_rate;
+
+};
+
+// Everything from a wedge to a driver, with some side spin
+std::vector<Launch> make_launches() {
+
+  std::vector<Launch> launches(NUM_LAUNCHES);
+
+  for (int i = 0; i < NUM_LAUNCHES; i++) {
+
+    float speed = mph_to_ms(80.0f + static_cast<float>(i % 16) * 6.0f);
+    float angle = deg_to_rad(8.0f + static_cast<float>(i / 16 % 8) * 4.0f);
+    float tilt = deg_to_rad(static_cast<float>(i % 5 - 2) * 5.0f);
+
+    launches[i].velocity = vec3(speed * std::cos(angle), 0.0f,
+                                speed * std::sin(angle));
+    launches[i].rotation_axis =
+        vec3(0.0f, -std::cos(tilt), std::sin(tilt));
+    launches[i].spin_rate = 1500.0f + static_cast<float>(i / 128) * 700.0f;
+
+  }
+
+  return launches;
+
+}
+
+template <typename T> constexpr int get_lanes() {
+
+  if constexpr (std::is_floating_point_v<T>) {
+    return 1;
+  } else {
+    return T::LANES;
+  }
+
+}
+
+template <typename T> T load_lanes(const float *values) {
+
+  if constexpr (std::is_floating_point_v<T>) {
+    return T(values[0]);
+  } else {
+    return T::load(values);
+  }
+
+}
+
+template <typename T> void store_lanes(T value, float *values) {
+
+  if constexpr (std::is_floating_point_v<T>) {
+    values[0] = static_cast<float>(value);
+  } else {
+    value.store(values);
+  }
+
+}
+
+// Loads get_lanes<T>() launches into one state
+template <typename T> FlightState<T> load_launches(const Launch *launches) {
+
+  constexpr int lanes = get_lanes<T>();
+
+  float values[7][lanes];
+
+  for (int i = 0; i < lanes; i++) {
+    values[0][i] = launches[i].velocity.x;
+    values[1][i] = launches[i].velocity.y;
+    values[2][i] = launches[i].velocity.z;
+    values[3][i] = launches[i].rotation_axis.x;
+    values[4][i] = launches[i].rotation_axis.y;
+    values[5][i] = launches[i].rotation_axis.z;
+    values[6][i] = launches[i].spin_rate;
+  }
+
+  FlightState<T> state;
+
+  state.velocity = vec3_t<T>(load_lanes<T>(values[0]), load_lanes<T>(values[1]),
+                             load_lanes<T>(values[2]));
+  state.rotation_axis =
+      vec3_t<T>(load_lanes<T>(values[3]), load_lanes<T>(values[4]),
+                load_lanes<T>(values[5]));
+  state.launch_spin_rate = load_lanes<T>(values[6]);
+  state.elapsed_time = T(0.0f);
+
+  return state;
+
+}
+
+// Flies every launch and returns each one's carry in yards
+template <typename T>
+std::vector<double> fly_launches(const std::vector<Launch> &launches) {
+
+  constexpr int lanes = get_lanes<T>();
+
+  std::vector<double> carries(launches.size());
+
+  for (size_t i = 0; i < launches.size(); i += lanes) {
+
+    FlightState<T> state = load_launches<T>(&launches[i]);
+
+    fly_to_landing<LogWind, SemiImplicitEuler>(
+        state, vec3_t<T>(WIND_VELOCITY), AirConstants<T>(REFERENCE_AIR),
+        T(TIMESTEP), MAX_STEPS);
+
+    float x[lanes];
+    float y[lanes];
+
+    store_lanes(state.position.x, x);
+    store_lanes(state.position.y, y);
+
+    for (int j = 0; j < lanes; j++) {
+      carries[i + j] = m_to_yd(std::sqrt(x[j] * x[j] + y[j] * y[j]));
+    }
+
+  }
+
+  return carries;
+
+}
+
+template <typename T>
+void report(const char *name, const std::vector<Launch> &launches,
+            const std::vector<double> &reference_carries) {
+
+  std::vector<double> carries;
+  std::vector<double> ns_per_ball;
+
+  for (int run = 0; run < NUM_RUNS; run++) {
+
+    auto start = std::chrono::high_resolution_clock::now();
+    carries = fly_launches<T>(launches);
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double, std::nano> elapsed = end - start;
+    ns_per_ball.push_back(elapsed.count() / launches.size());
+
+  }
+
+  double max_error = 0.0;
+  double mean_error = 0.0;
+
+  for (size_t i = 0; i < carries.size(); i++) {
+    double error = std::fabs(carries[i] - reference_carries[i]);
+    max_error = std::fmax(max_error, error);
+    mean_error += error;
+  }
+
+  mean_error /= static_cast<double>(carries.size());
+
+  double mean_ns = 0.0;
+
+  for (double ns : ns_per_ball) {
+    mean_ns += ns;
+  }
+
+  mean_ns /= static_cast<double>(ns_per_ball.size());
+
+  std::printf("%-8s %9.5f %9.5f yd %10.0f +/- %7.0f ns per ball\n", name,
+              mean_error, max_error, mean_ns, stdev_s(ns_per_ball));
+
+}
+
+} // namespace
+
+void run_precision_benchmark() {
+
+  std::vector<Launch> launches = make_launches();
+  std::vector<double> reference_carries = fly_launches<double>(launches);
+
+  double mean_carry = 0.0;
+
+  for (double carry : reference_carries) {
+    mean_carry += carry;
+  }
+
+  mean_carry /= static_cast<double>(reference_carries.size());
+
+  std::printf("%d launches, mean carry %.1f yd, %d runs\n", NUM_LAUNCHES,
+              mean_carry, NUM_RUNS);
+  std::printf("Carry error against double:  mean       max\n");
+
+  report<double>("double", launches, reference_carries);
+  report<float>("float", launches, reference_carries);
+  report<float4>("float4", launches, reference_carries);
+  report<float8>("float8", launches, reference_carries);
+  report<float16>("float16", launches, reference_carries);
+
+}
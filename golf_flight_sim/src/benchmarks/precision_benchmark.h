@@ -0,0 +1,7 @@
+#pragma once
+
+// Flies the same set of launches through the templated flight model (see
+// Physics/flight.h) in double, float and 4/8/16-lane SIMD, and prints how far
+// each one's carry is from the double precision reference along with the
+// time per ball.
+void run_precision_benchmark();
@@ -0,0 +1,70 @@
+#include "putting_benchmark.h"
+#include "../Physics/putting.h"
+#include "../Physics/surfaces.h"
+#include "../math/stats.h"
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int NUM_RUNS = 10;
+
+// Straight out from the ball at the origin, a meter left of the line
+const float HOLE_DISTANCES[] = {3.0f, 6.0f, 10.0f, 16.0f};
+const float HOLE_OFFSET = 1.0f;
+
+} // namespace
+
+void run_putting_benchmark() {
+
+  Terrain green = Terrain::practice_green();
+
+  const float deceleration = make_surface_table<SlowGreen>()
+      .roll_deceleration[static_cast<int>(SurfaceMaterial::GREEN)];
+  const int num_cores =
+      std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+  vec3 start(0.0f, 0.0f, green.get_height(0.0f, 0.0f));
+
+  std::printf("Reading the practice green, %d runs, %d cores\n", NUM_RUNS,
+              num_cores);
+  std::printf("%6s %7s %7s %24s %24s\n", "hole", "putts", "holed",
+              "one thread", "every core");
+
+  for (float distance : HOLE_DISTANCES) {
+
+    vec3 hole(distance, HOLE_OFFSET, green.get_height(distance, HOLE_OFFSET));
+    PuttSweep sweep = get_default_sweep(start, hole, deceleration);
+
+    GreenReading reading;
+    std::vector<double> single_ms;
+    std::vector<double> parallel_ms;
+
+    for (int run = 0; run < NUM_RUNS; run++) {
+
+      reading = read_green(green, start, hole, deceleration, sweep, 1);
+      single_ms.push_back(reading.time_ms);
+
+      reading = read_green(green, start, hole, deceleration, sweep);
+      parallel_ms.push_back(reading.time_ms);
+
+    }
+
+    auto mean = [](const std::vector<double> &values) {
+      double sum = 0.0;
+      for (double value : values) {
+        sum += value;
+      }
+      return sum / static_cast<double>(values.size());
+    };
+
+    std::printf("%4.0f m %7d %7d %9.1f +/- %5.1f ms %9.1f +/- %5.1f ms\n",
+                distance, sweep.num_speeds * sweep.num_aims,
+                reading.num_holed, mean(single_ms), stdev_s(single_ms),
+                mean(parallel_ms), stdev_s(parallel_ms));
+
+  }
+
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Times the green reading solver on the practice green for holes at several
+// distances, on one thread and on every core, against its 100 ms budget for
+// driving the putting overlay.
+void run_putting_benchmark();
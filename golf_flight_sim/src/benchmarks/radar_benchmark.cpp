@@ -0,0 +1,184 @@
+#include "radar_benchmark.h"
+#include "../Physics/calibration.h"
+#include "../Physics/flight.h"
+#include "../Physics/radar.h"
+#include "../Simulation/Simulation.h"
+#include "../math/unit_conversion.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+const int NUM_SHOTS = 32;
+
+// A radar sample every 5 ms for the first second of the flight
+const float SAMPLE_INTERVAL = 0.005f; // in seconds
+const int NUM_SAMPLES = 200;
+
+// The made up flights step ten times finer than the tracker's, so its own
+// integration error counts against it
+const int STEPS_PER_SAMPLE = 12;
+
+const float POSITION_NOISE = 0.02f; // in meters
+
+const vec3 TEE_POSITION(0.0f, 0.0f, TEE_HEIGHT);
+
+// How far into the track the predictions are reported
+const int NUM_CHECKPOINTS = 4;
+const float CHECKPOINTS[NUM_CHECKPOINTS] = {0.25f, 0.5f, 0.75f, 1.0f};
+
+std::vector<LaunchConditions<float>> make_shots(std::mt19937 &rng) {
+
+  std::uniform_real_distribution<float> fraction(0.0f, 1.0f);
+  std::normal_distribution<float> noise(0.0f, 1.0f);
+
+  std::vector<LaunchConditions<float>> shots(NUM_SHOTS);
+
+  for (LaunchConditions<float> &shot : shots) {
+
+    // From a wedge at 0 to a driver at 1
+    float club = fraction(rng);
+
+    shot.speed = mph_to_ms(95.0f + 75.0f * club + 6.0f * noise(rng));
+    shot.angle = deg_to_rad(28.0f - 16.0f * club + 2.0f * noise(rng));
+    shot.heading = deg_to_rad(3.0f * noise(rng));
+    shot.spin_rate = 8500.0f - 6000.0f * club + 400.0f * noise(rng);
+    shot.spin_axis = deg_to_rad(8.0f * noise(rng));
+
+  }
+
+  return shots;
+
+}
+
+std::vector<RadarSample> make_track(const LaunchConditions<float> &shot,
+                                    std::mt19937 &rng) {
+
+  std::normal_distribution<float> noise(0.0f, POSITION_NOISE);
+
+  FlightState<float> state = get_launch_state(shot, TEE_POSITION);
+  const float dt = SAMPLE_INTERVAL / static_cast<float>(STEPS_PER_SAMPLE);
+
+  std::vector<RadarSample> track(NUM_SAMPLES);
+
+  for (int i = 0; i < NUM_SAMPLES; i++) {
+
+    for (int step = 0; step < STEPS_PER_SAMPLE; step++) {
+      step_flight_state<UniformWind, SemiImplicitEuler, SmoothAero>(
+          state, vec3(0.0f, 0.0f, 0.0f), REFERENCE_AIR, dt);
+    }
+
+    track[i].time = static_cast<float>(i + 1) * SAMPLE_INTERVAL;
+    track[i].position =
+        state.position + vec3(noise(rng), noise(rng), noise(rng));
+
+  }
+
+  return track;
+
+}
+
+} // namespace
+
+void run_radar_benchmark() {
+
+  std::mt19937 rng(42);
+  std::vector<LaunchConditions<float>> shots = make_shots(rng);
+
+  TrackerSettings settings;
+  settings.position_noise = POSITION_NOISE;
+
+  double landing_error[NUM_CHECKPOINTS] = {};
+  double total_error[NUM_CHECKPOINTS] = {};
+  double spin_error[NUM_CHECKPOINTS] = {};
+  double axis_error[NUM_CHECKPOINTS] = {};
+
+  std::vector<float> update_ms;
+  int num_iterations = 0;
+
+  // Where each shot really ends up, the way the tracker predicts it
+  Simulation simulation(1.0f / PHYSICS_STEPS_PER_SECOND,
+                        Wind(0.0f, 0.0f, false));
+  std::vector<ShotMetrics> metrics;
+
+  // One tracker for every shot, the way a radar follows a range session,
+  // so only the first updates allocate
+  RadarTrack track;
+
+  for (const LaunchConditions<float> &shot : shots) {
+
+    simulate_shots(simulation, &shot, 1, TEE_POSITION,
+                   DEFAULT_PHYSICS_PARAMETERS, AeroModelType::SMOOTH, metrics);
+
+    vec3 landing = metrics[0].first_landing;
+    float total = metrics[0].total;
+
+    std::vector<RadarSample> samples = make_track(shot, rng);
+
+    track.reset(TEE_POSITION);
+
+    int checkpoint = 0;
+
+    for (const RadarSample &sample : samples) {
+
+      const TrackPrediction &prediction =
+          update_track(track, sample, settings);
+
+      if (!prediction.valid) {
+        continue;
+      }
+
+      update_ms.push_back(prediction.time_ms);
+      num_iterations += prediction.iterations;
+
+      if (checkpoint < NUM_CHECKPOINTS
+          && sample.time >= CHECKPOINTS[checkpoint] - 1e-4f) {
+
+        landing_error[checkpoint] += norm(prediction.landing - landing);
+        total_error[checkpoint] += std::fabs(prediction.total - total);
+        spin_error[checkpoint] +=
+            std::fabs(prediction.launch.spin_rate - shot.spin_rate);
+        axis_error[checkpoint] +=
+            std::fabs(prediction.launch.spin_axis - shot.spin_axis);
+        checkpoint++;
+
+      }
+
+    }
+
+  }
+
+  std::printf("%d shots, radar samples every %.0f ms with %.0f cm noise\n",
+              NUM_SHOTS, SAMPLE_INTERVAL * 1000.0f, POSITION_NOISE * 100.0f);
+  int num_updates = static_cast<int>(update_ms.size());
+  double total_ms = 0.0;
+
+  for (float ms : update_ms) {
+    total_ms += ms;
+  }
+
+  std::sort(update_ms.begin(), update_ms.end());
+
+  std::printf("%d updates, %.2f iterations each\n", num_updates,
+              static_cast<double>(num_iterations) / num_updates);
+  std::printf("%.3f ms on average, %.3f ms at the 99th percentile, %.3f ms "
+              "at most\n",
+              total_ms / num_updates, update_ms[num_updates * 99 / 100],
+              update_ms.back());
+  std::printf("%-8s %16s %16s %14s %14s\n", "track", "landing error",
+              "total error", "spin error", "axis error");
+
+  for (int i = 0; i < NUM_CHECKPOINTS; i++) {
+
+    std::printf("%5.2f s %13.2f yd %13.2f yd %10.0f rpm %10.2f deg\n",
+                CHECKPOINTS[i], m_to_yd(landing_error[i] / NUM_SHOTS),
+                m_to_yd(total_error[i] / NUM_SHOTS),
+                spin_error[i] / NUM_SHOTS,
+                rad_to_deg(axis_error[i] / NUM_SHOTS));
+
+  }
+
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Feeds made up radar tracks of a set of shots, with noise, to the tracker
+// (see Physics/radar.h) a sample at a time, and reports how long an update
+// takes and how far off its predictions are as the track grows.
+void run_radar_benchmark();
@@ -0,0 +1,206 @@
+#include "sensitivity_benchmark.h"
+#include "../Physics/sensitivity.h"
+#include "../math/stats.h"
+#include "../math/unit_conversion.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const int NUM_RUNS = 10;
+const int NUM_LAUNCHES = 64;
+
+const float TIMESTEP = 1.0f / 240.0f;
+const vec3 TEE_POSITION(0.0f, 0.0f, 0.0381f);
+
+// 10 mph crosswind at the reference height
+const vec3 WIND_VELOCITY(0.0f, 4.4704f, 0.0f);
+
+const char *INPUT_NAMES[NUM_LAUNCH_INPUTS] = {"speed", "angle", "heading",
+                                              "spin rate", "spin axis"};
+
+// Finite difference steps. Big enough that the float rounding in the landing
+// doesn't swamp the difference, small enough to stay in one coefficient band
+// most of the time.
+const float INPUT_STEPS[NUM_LAUNCH_INPUTS] = {0.05f, 1e-3f, 1e-3f, 5.0f,
+                                              1e-3f};
+
+// Everything from a wedge to a driver, with some side spin and push
+std::vector<LaunchConditions<float>> make_launches() {
+
+  std::vector<LaunchConditions<float>> launches(NUM_LAUNCHES);
+
+  for (int i = 0; i < NUM_LAUNCHES; i++) {
+
+    launches[i].speed = mph_to_ms(80.0f + static_cast<float>(i % 8) * 12.0f);
+    launches[i].angle = deg_to_rad(8.0f + static_cast<float>(i / 8) * 3.0f);
+    launches[i].heading = deg_to_rad(static_cast<float>(i % 3 - 1) * 2.0f);
+    launches[i].spin_rate = 2000.0f + static_cast<float>(i % 5) * 1000.0f;
+    launches[i].spin_axis = deg_to_rad(static_cast<float>(i % 7 - 3) * 5.0f);
+
+  }
+
+  return launches;
+
+}
+
+float &get_input(LaunchConditions<float> &launch, int input) {
+
+  switch (static_cast<LaunchInput>(input)) {
+  case LaunchInput::SPEED:
+    return launch.speed;
+  case LaunchInput::ANGLE:
+    return launch.angle;
+  case LaunchInput::HEADING:
+    return launch.heading;
+  case LaunchInput::SPIN_RATE:
+    return launch.spin_rate;
+  default:
+    return launch.spin_axis;
+  }
+
+}
+
+Landing fly_launch(const LaunchConditions<float> &launch,
+                   AeroModelType aero_model) {
+  return get_landing(launch, TEE_POSITION, WIND_VELOCITY, REFERENCE_AIR,
+                     WindModelType::LOGARITHMIC,
+                     IntegratorType::SEMI_IMPLICIT_EULER, aero_model,
+                     TIMESTEP);
+}
+
+// The landing plus its carry gradient from central differences, 2N + 1 runs
+Landing get_finite_difference_gradient(const LaunchConditions<float> &launch,
+                                       AeroModelType aero_model,
+                                       float *carry_gradient) {
+
+  Landing landing = fly_launch(launch, aero_model);
+
+  for (int i = 0; i < NUM_LAUNCH_INPUTS; i++) {
+
+    LaunchConditions<float> above = launch;
+    LaunchConditions<float> below = launch;
+
+    get_input(above, i) += INPUT_STEPS[i];
+    get_input(below, i) -= INPUT_STEPS[i];
+
+    carry_gradient[i] = (fly_launch(above, aero_model).carry
+                         - fly_launch(below, aero_model).carry)
+                        / (2.0f * INPUT_STEPS[i]);
+
+  }
+
+  return landing;
+
+}
+
+double get_mean(const std::vector<double> &values) {
+
+  double sum = 0.0;
+
+  for (double value : values) {
+    sum += value;
+  }
+
+  return sum / static_cast<double>(values.size());
+
+}
+
+// The comparison and timings for one aerodynamic model
+void compare_sensitivities(
+    const std::vector<LaunchConditions<float>> &launches,
+    AeroModelType aero_model) {
+
+  std::vector<LaunchSensitivities> sensitivities(NUM_LAUNCHES);
+  std::vector<float> finite_differences(NUM_LAUNCHES * NUM_LAUNCH_INPUTS);
+
+  std::vector<double> dual_us;
+  std::vector<double> finite_difference_us;
+
+  for (int run = 0; run < NUM_RUNS; run++) {
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < NUM_LAUNCHES; i++) {
+      sensitivities[i] = get_launch_sensitivities(
+          launches[i], TEE_POSITION, WIND_VELOCITY, REFERENCE_AIR,
+          WindModelType::LOGARITHMIC, IntegratorType::SEMI_IMPLICIT_EULER,
+          aero_model, TIMESTEP);
+    }
+
+    auto middle = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < NUM_LAUNCHES; i++) {
+      get_finite_difference_gradient(
+          launches[i], aero_model,
+          &finite_differences[i * NUM_LAUNCH_INPUTS]);
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    std::chrono::duration<double, std::micro> dual_elapsed = middle - start;
+    std::chrono::duration<double, std::micro> finite_difference_elapsed =
+        end - middle;
+
+    dual_us.push_back(dual_elapsed.count() / NUM_LAUNCHES);
+    finite_difference_us.push_back(finite_difference_elapsed.count()
+                                   / NUM_LAUNCHES);
+
+  }
+
+  std::printf("d(carry)/d(input), dual numbers against central differences\n");
+  std::printf("%-10s %12s %12s %12s\n", "input", "mean |d|", "mean error",
+              "max error");
+
+  for (int j = 0; j < NUM_LAUNCH_INPUTS; j++) {
+
+    double mean_derivative = 0.0;
+    double mean_error = 0.0;
+    double max_error = 0.0;
+
+    for (int i = 0; i < NUM_LAUNCHES; i++) {
+
+      double derivative = sensitivities[i].gradient[j].carry;
+      double error =
+          std::fabs(derivative - finite_differences[i * NUM_LAUNCH_INPUTS + j]);
+
+      mean_derivative += std::fabs(derivative);
+      mean_error += error;
+      max_error = std::fmax(max_error, error);
+
+    }
+
+    mean_derivative /= NUM_LAUNCHES;
+    mean_error /= NUM_LAUNCHES;
+
+    std::printf("%-10s %12.5g %12.5g %12.5g\n", INPUT_NAMES[j],
+                mean_derivative, mean_error, max_error);
+
+  }
+
+  std::printf("Time per launch:\n");
+  std::printf("dual numbers        %8.1f +/- %6.1f us (1 pass)\n",
+              get_mean(dual_us), stdev_s(dual_us));
+  std::printf("finite differences  %8.1f +/- %6.1f us (%d runs)\n",
+              get_mean(finite_difference_us), stdev_s(finite_difference_us),
+              2 * NUM_LAUNCH_INPUTS + 1);
+
+}
+
+} // namespace
+
+void run_sensitivity_benchmark() {
+
+  std::vector<LaunchConditions<float>> launches = make_launches();
+
+  std::printf("%d launches, %d runs\n", NUM_LAUNCHES, NUM_RUNS);
+
+  std::printf("\nTable aerodynamics\n");
+  compare_sensitivities(launches, AeroModelType::TABLE);
+
+  std::printf("\nSmooth aerodynamics\n");
+  compare_sensitivities(launches, AeroModelType::SMOOTH);
+
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+// Compares the launch sensitivities from the single dual number pass (see
+// Physics/sensitivity.h) with central finite differences, which take 2N + 1
+// runs for N inputs, and prints how far apart the derivatives are and how
+// long each way takes, for both aerodynamic models. With the table the
+// differences mostly come from finite difference steps that cross an edge of
+// the coefficient table, which the derivatives don't see, and the spin rate's
+// derivatives are zero. The smooth model has neither.
+void run_sensitivity_benchmark();
@@ -0,0 +1,307 @@
+#include "simd_math_benchmark.h"
+#include "../math/simd_math.h"
+#include "../math/stats.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const int NUM_RUNS = 10;
+
+// Multiples of 16 so every vector width divides them evenly
+const int NUM_ACCURACY_VALUES = 1 << 20;
+const int NUM_THROUGHPUT_VALUES = 4096;
+const int NUM_THROUGHPUT_PASSES = 256;
+
+// Keeps the compiler from optimizing the evaluations away
+volatile float sink = 0.0f;
+
+/*
+  One struct per function under test: the range it's checked over, the
+  vectorized version, the scalar float libm version it replaces and a double
+  precision reference.
+*/
+
+struct Atan {
+  static constexpr const char *NAME = "atan";
+  static constexpr float LOW = -1e4f, HIGH = 1e4f;
+  static constexpr bool LOG_SPACED = false;
+  template <typename V> static V simd(V x) {
+    return simd_atan(x);
+  }
+  static float libm(float x) {
+    return std::atan(x);
+  }
+  static double reference(double x) {
+    return std::atan(x);
+  }
+};
+
+struct Exp {
+  static constexpr const char *NAME = "exp";
+  static constexpr float LOW = -87.0f, HIGH = 88.0f;
+  static constexpr bool LOG_SPACED = false;
+  template <typename V> static V simd(V x) {
+    return simd_exp(x);
+  }
+  static float libm(float x) {
+    return std::exp(x);
+  }
+  static double reference(double x) {
+    return std::exp(x);
+  }
+};
+
+struct Log {
+  static constexpr const char *NAME = "log";
+  static constexpr float LOW = 1e-30f, HIGH = 1e30f;
+  static constexpr bool LOG_SPACED = true;
+  template <typename V> static V simd(V x) {
+    return simd_log(x);
+  }
+  static float libm(float x) {
+    return std::log(x);
+  }
+  static double reference(double x) {
+    return std::log(x);
+  }
+};
+
+struct Sin {
+  static constexpr const char *NAME = "sin";
+  static constexpr float LOW = -8192.0f, HIGH = 8192.0f;
+  static constexpr bool LOG_SPACED = false;
+  template <typename V> static V simd(V x) {
+    V s, c;
+    simd_sincos(x, s, c);
+    return s;
+  }
+  static float libm(float x) {
+    return std::sin(x);
+  }
+  static double reference(double x) {
+    return std::sin(x);
+  }
+};
+
+struct Cos {
+  static constexpr const char *NAME = "cos";
+  static constexpr float LOW = -8192.0f, HIGH = 8192.0f;
+  static constexpr bool LOG_SPACED = false;
+  template <typename V> static V simd(V x) {
+    V s, c;
+    simd_sincos(x, s, c);
+    return c;
+  }
+  static float libm(float x) {
+    return std::cos(x);
+  }
+  static double reference(double x) {
+    return std::cos(x);
+  }
+};
+
+// Both outputs of sincos, for timing against separate sin and cos calls
+struct SinCos {
+  static constexpr const char *NAME = "sincos";
+  static constexpr float LOW = -8192.0f, HIGH = 8192.0f;
+  static constexpr bool LOG_SPACED = false;
+  template <typename V> static V simd(V x) {
+    V s, c;
+    simd_sincos(x, s, c);
+    return s + c;
+  }
+  static float libm(float x) {
+    return std::sin(x) + std::cos(x);
+  }
+};
+
+template <typename Function> std::vector<float> make_inputs(int count) {
+
+  std::vector<float> inputs(count);
+
+  for (int i = 0; i < count; i++) {
+
+    double t = static_cast<double>(i) / (count - 1);
+
+    if (Function::LOG_SPACED) {
+      double log_low = std::log(static_cast<double>(Function::LOW));
+      double log_high = std::log(static_cast<double>(Function::HIGH));
+      inputs[i] =
+          static_cast<float>(std::exp(log_low + t * (log_high - log_low)));
+    } else {
+      inputs[i] = static_cast<float>(Function::LOW
+                                     + t * (Function::HIGH - Function::LOW));
+    }
+
+  }
+
+  return inputs;
+
+}
+
+template <typename V, typename Function>
+void evaluate(const std::vector<float> &inputs, std::vector<float> &outputs) {
+
+  for (size_t i = 0; i < inputs.size(); i += V::LANES) {
+    Function::template simd<V>(V::load(&inputs[i])).store(&outputs[i]);
+  }
+
+}
+
+// Distance from the exact result in units of the spacing between floats at
+// the exact result
+double get_ulp_error(float result, double exact) {
+
+  float exact_float = std::fabs(static_cast<float>(exact));
+  double ulp = std::nextafter(exact_float, INFINITY) - exact_float;
+
+  return std::fabs(result - exact) / ulp;
+
+}
+
+template <typename Function> void report_accuracy() {
+
+  std::vector<float> inputs = make_inputs<Function>(NUM_ACCURACY_VALUES);
+  std::vector<float> outputs_4(inputs.size());
+  std::vector<float> outputs_8(inputs.size());
+  std::vector<float> outputs_16(inputs.size());
+
+  evaluate<float4, Function>(inputs, outputs_4);
+  evaluate<float8, Function>(inputs, outputs_8);
+  evaluate<float16, Function>(inputs, outputs_16);
+
+  // Every width runs the same operations, so the results should be identical
+  size_t bytes = inputs.size() * sizeof(float);
+  bool widths_match =
+      std::memcmp(outputs_4.data(), outputs_8.data(), bytes) == 0
+      && std::memcmp(outputs_4.data(), outputs_16.data(), bytes) == 0;
+
+  double max_ulp_error = 0.0;
+  double max_abs_error = 0.0;
+
+  for (size_t i = 0; i < inputs.size(); i++) {
+
+    double exact = Function::reference(inputs[i]);
+
+    max_ulp_error = std::fmax(max_ulp_error,
+                              get_ulp_error(outputs_4[i], exact));
+    max_abs_error = std::fmax(max_abs_error, std::fabs(outputs_4[i] - exact));
+
+  }
+
+  std::printf("%-8s [%9.3g, %9.3g] %8.2f ulp %10.2e abs%s\n", Function::NAME,
+              Function::LOW, Function::HIGH, max_ulp_error, max_abs_error,
+              widths_match ? "" : "  (widths disagree!)");
+
+}
+
+template <typename Evaluate>
+std::vector<double> time_runs(const std::vector<float> &inputs,
+                              std::vector<float> &outputs, Evaluate evaluate) {
+
+  std::vector<double> ns_per_value;
+
+  for (int run = 0; run < NUM_RUNS; run++) {
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int pass = 0; pass < NUM_THROUGHPUT_PASSES; pass++) {
+      evaluate(inputs, outputs);
+      sink = sink + outputs[pass];
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::nano> elapsed = end - start;
+
+    ns_per_value.push_back(
+        elapsed.count()
+        / (static_cast<double>(inputs.size()) * NUM_THROUGHPUT_PASSES));
+
+  }
+
+  return ns_per_value;
+
+}
+
+void report_throughput(const char *name, std::vector<double> &ns_per_value,
+                       double libm_mean) {
+
+  double mean = 0.0;
+
+  for (double ns : ns_per_value) {
+    mean += ns;
+  }
+
+  mean /= static_cast<double>(ns_per_value.size());
+
+  std::printf("  %-10s %7.2f +/- %5.2f ns per value %6.1fx\n", name, mean,
+              stdev_s(ns_per_value), libm_mean / mean);
+
+}
+
+template <typename Function> void report_throughput() {
+
+  std::vector<float> inputs = make_inputs<Function>(NUM_THROUGHPUT_VALUES);
+  std::vector<float> outputs(inputs.size());
+
+  std::vector<double> libm_ns = time_runs(
+      inputs, outputs,
+      [](const std::vector<float> &in, std::vector<float> &out) {
+        for (size_t i = 0; i < in.size(); i++) {
+          out[i] = Function::libm(in[i]);
+        }
+      });
+
+  std::vector<double> simd_4_ns =
+      time_runs(inputs, outputs, evaluate<float4, Function>);
+  std::vector<double> simd_8_ns =
+      time_runs(inputs, outputs, evaluate<float8, Function>);
+  std::vector<double> simd_16_ns =
+      time_runs(inputs, outputs, evaluate<float16, Function>);
+
+  double libm_mean = 0.0;
+
+  for (double ns : libm_ns) {
+    libm_mean += ns;
+  }
+
+  libm_mean /= static_cast<double>(libm_ns.size());
+
+  std::printf("%s\n", Function::NAME);
+  report_throughput("libm", libm_ns, libm_mean);
+  report_throughput("float4", simd_4_ns, libm_mean);
+  report_throughput("float8", simd_8_ns, libm_mean);
+  report_throughput("float16", simd_16_ns, libm_mean);
+
+}
+
+} // namespace
+
+void run_simd_math_benchmark() {
+
+#if defined(MATH_AVX)
+  std::printf("float8: AVX\n");
+#else
+  std::printf("float8: two float4s\n");
+#endif
+
+  std::printf("\nAccuracy against double precision libm, %d values\n",
+              NUM_ACCURACY_VALUES);
+  report_accuracy<Atan>();
+  report_accuracy<Exp>();
+  report_accuracy<Log>();
+  report_accuracy<Sin>();
+  report_accuracy<Cos>();
+
+  std::printf("\nThroughput, %d values x %d passes, %d runs\n",
+              NUM_THROUGHPUT_VALUES, NUM_THROUGHPUT_PASSES, NUM_RUNS);
+  report_throughput<Atan>();
+  report_throughput<Exp>();
+  report_throughput<Log>();
+  report_throughput<SinCos>();
+
+}
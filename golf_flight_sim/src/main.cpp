@@ -4,7 +4,21 @@
 //#define _CRTDBG_MAP_ALLOC
 //#include <crtdbg.h>
 #include "Application.h"
+#include "./benchmarks/aero_benchmark.h"
+#include "./benchmarks/atmosphere_benchmark.h"
+#include "./benchmarks/calibration_benchmark.h"
+#include "./benchmarks/format_benchmark.h"
+#include "./benchmarks/metrics_benchmark.h"
+#include "./benchmarks/obstacle_benchmark.h"
+#include "./benchmarks/precision_benchmark.h"
+#include "./benchmarks/putting_benchmark.h"
+#include "./benchmarks/radar_benchmark.h"
+#include "./benchmarks/sensitivity_benchmark.h"
+#include "./benchmarks/simd_math_benchmark.h"
+#include "./Terrain/terrain_file.h"
 #include "./tracy/tracy/Tracy.hpp"
+#include <cstdio>
+#include <cstring>
 
 // TODO: Make a release .exe and a Linux build as well.
 // TODO: v2.0: Render the game in 3D! :D
@@ -27,6 +41,96 @@ int main(int argc, char *args[]) {
 
   //// start the clock for the overall benchmarking session
   // auto benchmark_start = std::chrono::high_resolution_clock::now();
+
+  // Command line benchmarks run headless and exit
+  if (argc > 1 && std::strcmp(args[1], "--benchmark-format") == 0) {
+    run_format_benchmark();
+    return 0;
+  }
+
+  if (argc > 1 && std::strcmp(args[1], "--benchmark-simd-math") == 0) {
+    run_simd_math_benchmark();
+    return 0;
+  }
+
+  if (argc > 1 && std::strcmp(args[1], "--benchmark-precision") == 0) {
+    run_precision_benchmark();
+    return 0;
+  }
+
+  if (argc > 1 && std::strcmp(args[1], "--benchmark-sensitivity") == 0) {
+    run_sensitivity_benchmark();
+    return 0;
+  }
+
+  if (argc > 1 && std::strcmp(args[1], "--benchmark-obstacles") == 0) {
+    run_obstacle_benchmark();
+    return 0;
+  }
+
+  if (argc > 1 && std::strcmp(args[1], "--benchmark-putting") == 0) {
+    run_putting_benchmark();
+    return 0;
+  }
+
+  if (argc > 1 && std::strcmp(args[1], "--benchmark-atmosphere") == 0) {
+    run_atmosphere_benchmark();
+    return 0;
+  }
+
+  if (argc > 1 && std::strcmp(args[1], "--benchmark-aero") == 0) {
+    run_aero_benchmark();
+    return 0;
+  }
+
+  // Fits the smooth aerodynamic model to the coefficient table and prints
+  // the coefficients for Physics/aero.cpp
+  if (argc > 1 && std::strcmp(args[1], "--fit-aero") == 0) {
+    run_aero_fit();
+    return 0;
+  }
+
+  if (argc > 1 && std::strcmp(args[1], "--benchmark-metrics") == 0) {
+    run_metrics_benchmark();
+    return 0;
+  }
+
+  if (argc > 1 && std::strcmp(args[1], "--benchmark-radar") == 0) {
+    run_radar_benchmark();
+    return 0;
+  }
+
+  if (argc > 1 && std::strcmp(args[1], "--benchmark-calibration") == 0) {
+    run_calibration_benchmark();
+    return 0;
+  }
+
+  // Fits the physics parameters to a launch monitor session and writes them
+  // to the given path, or calibration.txt
+  if (argc > 2 && std::strcmp(args[1], "--calibrate") == 0) {
+
+    const char *output_path = argc > 3 ? args[3] : "calibration.txt";
+
+    return run_calibration(args[2], output_path) ? 0 : 1;
+
+  }
+
+  // Writes the example course for the streamed terrain, to the given path
+  // or where the app looks for it
+  if (argc > 1 && std::strcmp(args[1], "--write-course") == 0) {
+
+    const char *path = argc > 2 ? args[2] : EXAMPLE_COURSE_PATH;
+
+    if (!write_example_course(path)) {
+      std::printf("Couldn't write %s\n", path);
+      return 1;
+    }
+
+    std::printf("Wrote %s\n", path);
+    return 0;
+
+  }
+
   Application app;
 
   app.initialize();
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "math_inline.h"
+#include "vec3.h"
+#include <cmath>
+
+/*
+  3D vector over any scalar type T with the arithmetic operators: double, or
+  one of the SIMD vectors in simd.h, in which case it holds one 3D vector per
+  lane.
+
+  Code templated on the scalar type spells its vectors vec3_t<T>. That is the
+  padded vec3 for float, so the float instantiation of the physics runs on the
+  same vec3 code as the rest of the simulation.
+*/
+
+template <typename T> struct basic_vec3 {
+
+  T x, y, z;
+
+  MATH_INLINE basic_vec3() : x(0.0f), y(0.0f), z(0.0f) {}
+  MATH_INLINE basic_vec3(T x, T y, T z) : x(x), y(y), z(z) {}
+
+  // Broadcasts a float vector, e.g. a constant like BALL_WEIGHT
+  MATH_INLINE explicit basic_vec3(vec3 v) : x(v.x), y(v.y), z(v.z) {}
+
+  MATH_INLINE T dot(basic_vec3 v) const {
+    return (x * v.x) + (y * v.y) + (z * v.z);
+  }
+
+  MATH_INLINE basic_vec3 cross(basic_vec3 v) const {
+    return basic_vec3((y * v.z) - (z * v.y), (z * v.x) - (x * v.z),
+                      (x * v.y) - (y * v.x));
+  }
+
+  MATH_INLINE basic_vec3 operator+(basic_vec3 v) const {
+    return basic_vec3(x + v.x, y + v.y, z + v.z);
+  }
+
+  MATH_INLINE basic_vec3 operator-(basic_vec3 v) const {
+    return basic_vec3(x - v.x, y - v.y, z - v.z);
+  }
+
+  MATH_INLINE basic_vec3 operator*(T n) const {
+    return basic_vec3(x * n, y * n, z * n);
+  }
+
+  MATH_INLINE basic_vec3 operator/(T n) const {
+    return *this * (T(1.0f) / n);
+  }
+
+  MATH_INLINE basic_vec3 &operator+=(basic_vec3 v) {
+    return *this = *this + v;
+  }
+
+  MATH_INLINE basic_vec3 &operator-=(basic_vec3 v) {
+    return *this = *this - v;
+  }
+
+  MATH_INLINE basic_vec3 &operator*=(T n) {
+    return *this = *this * n;
+  }
+
+  MATH_INLINE basic_vec3 &operator/=(T n) {
+    return *this = *this / n;
+  }
+
+};
+
+template <typename T> MATH_INLINE basic_vec3<T> operator-(basic_vec3<T> v) {
+  return basic_vec3<T>(-v.x, -v.y, -v.z);
+}
+
+template <typename T> MATH_INLINE T norm(basic_vec3<T> v) {
+
+  using std::sqrt;
+
+  return sqrt(v.dot(v));
+
+}
+
+template <typename T> struct vec3_type {
+  using type = basic_vec3<T>;
+};
+
+template <> struct vec3_type<float> {
+  using type = vec3;
+};
+
+template <typename T> using vec3_t = typename vec3_type<T>::type;
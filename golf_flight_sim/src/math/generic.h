@@ -0,0 +1,79 @@
+#pragma once
+
+#include "basic_vec3.h"
+#include "simd_math.h"
+#include "vec3.h"
+
+/*
+  One spelling for the operations the templated physics needs, whether the
+  scalar type is float, double or one of the SIMD vectors. Comparisons give a
+  bool for the scalars and a mask for the vectors, and select(), any() and
+  gather() accept either.
+
+  Templates call the libm functions unqualified after a using-declaration
+  (using std::exp; exp(x)), which picks std::exp for the scalars and the
+  overloads below for the vectors.
+*/
+
+MATH_INLINE float select(bool mask, float a, float b) {
+  return mask ? a : b;
+}
+
+MATH_INLINE double select(bool mask, double a, double b) {
+  return mask ? a : b;
+}
+
+MATH_INLINE vec3 select(bool mask, vec3 a, vec3 b) {
+  return mask ? a : b;
+}
+
+template <typename Mask, typename T>
+MATH_INLINE basic_vec3<T> select(Mask mask, basic_vec3<T> a, basic_vec3<T> b) {
+  return basic_vec3<T>(select(mask, a.x, b.x), select(mask, a.y, b.y),
+                       select(mask, a.z, b.z));
+}
+
+MATH_INLINE bool any(bool mask) {
+  return mask;
+}
+
+// table[index], per lane for the vectors. index holds whole numbers.
+MATH_INLINE float gather(const float *table, float index) {
+  return table[static_cast<int>(index)];
+}
+
+MATH_INLINE double gather(const float *table, double index) {
+  return table[static_cast<int>(index)];
+}
+
+template <typename V> MATH_INLINE V gather(const float *table, V index) {
+
+  float indices[V::LANES];
+  float values[V::LANES];
+
+  index.store(indices);
+
+  for (int i = 0; i < V::LANES; i++) {
+    values[i] = table[static_cast<int>(indices[i])];
+  }
+
+  return V::load(values);
+
+}
+
+#define GENERIC_SIMD_MATH(V)                                                   \
+  MATH_INLINE V exp(V x) {                                                     \
+    return simd_exp(x);                                                        \
+  }                                                                            \
+  MATH_INLINE V log(V x) {                                                     \
+    return simd_log(x);                                                        \
+  }                                                                            \
+  MATH_INLINE V atan(V x) {                                                    \
+    return simd_atan(x);                                                       \
+  }
+
+GENERIC_SIMD_MATH(float4)
+GENERIC_SIMD_MATH(float8)
+GENERIC_SIMD_MATH(float16)
+
+#undef GENERIC_SIMD_MATH
@@ -1,8 +1,11 @@
 #pragma once
 
 #include "../math/vec2.h"
+#include <cmath>
+#include <utility>
+#include <vector>
 
-vec2 solve_y_linear(vec2 a, vec2 b, float x) {
+constexpr vec2 solve_y_linear(vec2 a, vec2 b, float x) {
 
   float dx = b.x - a.x;
   float dy = b.y - a.y;
@@ -15,4 +18,51 @@ vec2 solve_y_linear(vec2 a, vec2 b, float x) {
 
   return result;
 
-}
\ No newline at end of file
+}
+
+// Solves the n by n system a x = b in place by Gaussian elimination with
+// partial pivoting, leaving x in b
+inline void solve_linear_system(std::vector<double> &a, std::vector<double> &b,
+                                int n) {
+
+  for (int i = 0; i < n; i++) {
+
+    int pivot = i;
+
+    for (int r = i + 1; r < n; r++) {
+      if (std::fabs(a[r * n + i]) > std::fabs(a[pivot * n + i])) {
+        pivot = r;
+      }
+    }
+
+    for (int c = 0; c < n; c++) {
+      std::swap(a[i * n + c], a[pivot * n + c]);
+    }
+    std::swap(b[i], b[pivot]);
+
+    for (int r = i + 1; r < n; r++) {
+
+      double factor = a[r * n + i] / a[i * n + i];
+
+      for (int c = i; c < n; c++) {
+        a[r * n + c] -= factor * a[i * n + c];
+      }
+      b[r] -= factor * b[i];
+
+    }
+
+  }
+
+  for (int i = n - 1; i >= 0; i--) {
+
+    double sum = b[i];
+
+    for (int c = i + 1; c < n; c++) {
+      sum -= a[i * n + c] * b[c];
+    }
+
+    b[i] = sum / a[i * n + i];
+
+  }
+
+}
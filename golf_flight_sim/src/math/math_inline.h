@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cmath>
+
+/*
+  Shared configuration for the header-only math: instruction set detection
+  and forced inlining.
+*/
+
+#if defined(__SSE2__) || defined(_M_X64)                                      \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MATH_SSE2
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MATH_AVX
+#endif
+#elif (defined(__ARM_NEON) && defined(__aarch64__)) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MATH_NEON
+#endif
+
+#if defined(_MSC_VER)
+#define MATH_INLINE __forceinline
+#else
+#define MATH_INLINE inline __attribute__((always_inline))
+#endif
+
+// Fully unrolls the short fixed length loop that follows. MSVC has no such
+// pragma, so there it's left to the optimizer.
+#if defined(__clang__) || defined(__GNUC__)
+#define MATH_UNROLL _Pragma("GCC unroll 16")
+#else
+#define MATH_UNROLL
+#endif
+
+// 1 / sqrt(x) from the hardware estimate plus one Newton-Raphson step, which
+// brings the ~12 bit estimate up to ~22 bits.
+MATH_INLINE float fast_rsqrt(float x) {
+
+#if defined(MATH_SSE2)
+  float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+  return y * (1.5f - 0.5f * x * y * y);
+#elif defined(MATH_NEON)
+  // NEON's estimate is only ~8 bits, so it takes two steps
+  float y = vrsqrtes_f32(x);
+  y *= vrsqrtss_f32(x * y, y);
+  return y * vrsqrtss_f32(x * y, y);
+#else
+  return 1.0f / std::sqrt(x);
+#endif
+
+}
@@ -0,0 +1,552 @@
+#pragma once
+
+#include "math_inline.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+/*
+  Small float vectors for the batched physics kernels.
+
+  float4 is backed by SSE2 on x86-64, NEON on ARM64 and plain arrays
+  everywhere else. float8 is a native AVX register when the build enables AVX
+  and a pair of float4s otherwise, and float16 is always a pair of float8s.
+  All three share the same set of operations, so kernels (and the
+  transcendentals in simd_math.h) are written once as templates over the
+  vector type and compile on every target.
+
+  Comparisons return a mask (all bits set in the lanes where the comparison is
+  true), which select() uses to blend two results instead of branching.
+*/
+
+struct float4 {
+
+#if defined(MATH_SSE2)
+  __m128 v;
+  float4() : v(_mm_setzero_ps()) {}
+  explicit float4(__m128 v) : v(v) {}
+  explicit float4(float f) : v(_mm_set1_ps(f)) {}
+
+  static float4 load(const float *p) {
+    return float4(_mm_loadu_ps(p));
+  }
+  void store(float *p) const {
+    _mm_storeu_ps(p, v);
+  }
+#elif defined(MATH_NEON)
+  float32x4_t v;
+  float4() : v(vdupq_n_f32(0.0f)) {}
+  explicit float4(float32x4_t v) : v(v) {}
+  explicit float4(float f) : v(vdupq_n_f32(f)) {}
+
+  static float4 load(const float *p) {
+    return float4(vld1q_f32(p));
+  }
+  void store(float *p) const {
+    vst1q_f32(p, v);
+  }
+#else
+  float v[4];
+  float4() : v{0.0f, 0.0f, 0.0f, 0.0f} {}
+  explicit float4(float f) : v{f, f, f, f} {}
+
+  static float4 load(const float *p) {
+    float4 r;
+    std::memcpy(r.v, p, sizeof(r.v));
+    return r;
+  }
+  void store(float *p) const {
+    std::memcpy(p, v, sizeof(v));
+  }
+#endif
+
+  static constexpr int LANES = 4;
+
+};
+
+#if defined(MATH_SSE2)
+
+inline float4 operator+(float4 a, float4 b) {
+  return float4(_mm_add_ps(a.v, b.v));
+}
+inline float4 operator-(float4 a, float4 b) {
+  return float4(_mm_sub_ps(a.v, b.v));
+}
+inline float4 operator*(float4 a, float4 b) {
+  return float4(_mm_mul_ps(a.v, b.v));
+}
+inline float4 operator/(float4 a, float4 b) {
+  return float4(_mm_div_ps(a.v, b.v));
+}
+inline float4 operator-(float4 a) {
+  return float4(_mm_xor_ps(a.v, _mm_set1_ps(-0.0f)));
+}
+
+inline float4 operator<(float4 a, float4 b) {
+  return float4(_mm_cmplt_ps(a.v, b.v));
+}
+inline float4 operator<=(float4 a, float4 b) {
+  return float4(_mm_cmple_ps(a.v, b.v));
+}
+inline float4 operator>(float4 a, float4 b) {
+  return float4(_mm_cmpgt_ps(a.v, b.v));
+}
+inline float4 operator&(float4 a, float4 b) {
+  return float4(_mm_and_ps(a.v, b.v));
+}
+inline float4 operator|(float4 a, float4 b) {
+  return float4(_mm_or_ps(a.v, b.v));
+}
+
+// Lanes of a where mask is set, lanes of b everywhere else
+inline float4 select(float4 mask, float4 a, float4 b) {
+  return float4(_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)));
+}
+
+inline float4 abs(float4 a) {
+  return float4(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v));
+}
+inline float4 min(float4 a, float4 b) {
+  return float4(_mm_min_ps(a.v, b.v));
+}
+inline float4 max(float4 a, float4 b) {
+  return float4(_mm_max_ps(a.v, b.v));
+}
+inline float4 sqrt(float4 a) {
+  return float4(_mm_sqrt_ps(a.v));
+}
+
+// Rounds to the nearest integer (ties to even)
+inline float4 round(float4 a) {
+  return float4(_mm_cvtepi32_ps(_mm_cvtps_epi32(a.v)));
+}
+
+// Whether any lane of a mask is set
+inline bool any(float4 mask) {
+  return _mm_movemask_ps(mask.v) != 0;
+}
+
+// Lanes where the integer value of a has any of the given bits set, as a mask.
+// a has to hold whole numbers.
+inline float4 test_bits(float4 a, int bits) {
+  __m128i i = _mm_and_si128(_mm_cvtps_epi32(a.v), _mm_set1_epi32(bits));
+  __m128i is_clear = _mm_cmpeq_epi32(i, _mm_setzero_si128());
+  return float4(_mm_castsi128_ps(_mm_xor_si128(is_clear, _mm_set1_epi32(-1))));
+}
+
+// 2^n for whole numbers n in [-126, 127], built directly in the exponent field
+inline float4 pow2(float4 n) {
+  __m128i biased = _mm_add_epi32(_mm_cvtps_epi32(n.v), _mm_set1_epi32(127));
+  return float4(_mm_castsi128_ps(_mm_slli_epi32(biased, 23)));
+}
+
+// Splits positive normal numbers like std::frexp: returns the mantissa in
+// [0.5, 1) and sets exponent so that a = mantissa * 2^exponent.
+inline float4 frexp(float4 a, float4 &exponent) {
+  __m128i bits = _mm_castps_si128(a.v);
+  __m128i biased = _mm_srli_epi32(bits, 23);
+  biased = _mm_sub_epi32(biased, _mm_set1_epi32(126));
+  exponent = float4(_mm_cvtepi32_ps(biased));
+  __m128i mantissa = _mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF));
+  mantissa = _mm_or_si128(mantissa, _mm_set1_epi32(0x3F000000));
+  return float4(_mm_castsi128_ps(mantissa));
+}
+
+#elif defined(MATH_NEON)
+
+inline float4 operator+(float4 a, float4 b) {
+  return float4(vaddq_f32(a.v, b.v));
+}
+inline float4 operator-(float4 a, float4 b) {
+  return float4(vsubq_f32(a.v, b.v));
+}
+inline float4 operator*(float4 a, float4 b) {
+  return float4(vmulq_f32(a.v, b.v));
+}
+inline float4 operator/(float4 a, float4 b) {
+  return float4(vdivq_f32(a.v, b.v));
+}
+inline float4 operator-(float4 a) {
+  return float4(vnegq_f32(a.v));
+}
+
+inline float4 operator<(float4 a, float4 b) {
+  return float4(vreinterpretq_f32_u32(vcltq_f32(a.v, b.v)));
+}
+inline float4 operator<=(float4 a, float4 b) {
+  return float4(vreinterpretq_f32_u32(vcleq_f32(a.v, b.v)));
+}
+inline float4 operator>(float4 a, float4 b) {
+  return float4(vreinterpretq_f32_u32(vcgtq_f32(a.v, b.v)));
+}
+inline float4 operator&(float4 a, float4 b) {
+  return float4(vreinterpretq_f32_u32(
+      vandq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v))));
+}
+inline float4 operator|(float4 a, float4 b) {
+  return float4(vreinterpretq_f32_u32(
+      vorrq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v))));
+}
+
+inline float4 select(float4 mask, float4 a, float4 b) {
+  return float4(vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v));
+}
+
+inline float4 abs(float4 a) {
+  return float4(vabsq_f32(a.v));
+}
+inline float4 min(float4 a, float4 b) {
+  return float4(vminq_f32(a.v, b.v));
+}
+inline float4 max(float4 a, float4 b) {
+  return float4(vmaxq_f32(a.v, b.v));
+}
+inline float4 sqrt(float4 a) {
+  return float4(vsqrtq_f32(a.v));
+}
+
+inline float4 round(float4 a) {
+  return float4(vrndnq_f32(a.v));
+}
+
+inline bool any(float4 mask) {
+  return vmaxvq_u32(vreinterpretq_u32_f32(mask.v)) != 0;
+}
+
+inline float4 test_bits(float4 a, int bits) {
+  int32x4_t i = vcvtnq_s32_f32(a.v);
+  return float4(vreinterpretq_f32_u32(vtstq_s32(i, vdupq_n_s32(bits))));
+}
+
+inline float4 pow2(float4 n) {
+  int32x4_t biased = vaddq_s32(vcvtnq_s32_f32(n.v), vdupq_n_s32(127));
+  return float4(vreinterpretq_f32_s32(vshlq_n_s32(biased, 23)));
+}
+
+inline float4 frexp(float4 a, float4 &exponent) {
+  uint32x4_t bits = vreinterpretq_u32_f32(a.v);
+  int32x4_t biased = vreinterpretq_s32_u32(vshrq_n_u32(bits, 23));
+  exponent = float4(vcvtq_f32_s32(vsubq_s32(biased, vdupq_n_s32(126))));
+  uint32x4_t mantissa = vorrq_u32(vandq_u32(bits, vdupq_n_u32(0x007FFFFF)),
+                                  vdupq_n_u32(0x3F000000));
+  return float4(vreinterpretq_f32_u32(mantissa));
+}
+
+#else
+
+namespace simd_detail {
+
+inline float mask_from_bool(bool b) {
+  uint32_t bits = b ? 0xFFFFFFFFu : 0u;
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+inline uint32_t bits_of(float f) {
+  uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  return bits;
+}
+
+inline float float_from_bits(uint32_t bits) {
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+} // namespace simd_detail
+
+#define SIMD_SCALAR_BINARY(op, expr)                                           \
+  inline float4 op(float4 a, float4 b) {                                       \
+    float4 r;                                                                  \
+    for (int i = 0; i < 4; i++) {                                              \
+      r.v[i] = expr;                                                           \
+    }                                                                          \
+    return r;                                                                  \
+  }
+
+SIMD_SCALAR_BINARY(operator+, a.v[i] + b.v[i])
+SIMD_SCALAR_BINARY(operator-, a.v[i] - b.v[i])
+SIMD_SCALAR_BINARY(operator*, a.v[i] * b.v[i])
+SIMD_SCALAR_BINARY(operator/, a.v[i] / b.v[i])
+SIMD_SCALAR_BINARY(operator<, simd_detail::mask_from_bool(a.v[i] < b.v[i]))
+SIMD_SCALAR_BINARY(operator<=, simd_detail::mask_from_bool(a.v[i] <= b.v[i]))
+SIMD_SCALAR_BINARY(operator>, simd_detail::mask_from_bool(a.v[i] > b.v[i]))
+SIMD_SCALAR_BINARY(operator&, simd_detail::float_from_bits(
+                                  simd_detail::bits_of(a.v[i])
+                                  & simd_detail::bits_of(b.v[i])))
+SIMD_SCALAR_BINARY(operator|, simd_detail::float_from_bits(
+                                  simd_detail::bits_of(a.v[i])
+                                  | simd_detail::bits_of(b.v[i])))
+SIMD_SCALAR_BINARY(min, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+SIMD_SCALAR_BINARY(max, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+
+#undef SIMD_SCALAR_BINARY
+
+inline float4 operator-(float4 a) {
+  return float4(0.0f) - a;
+}
+
+inline float4 select(float4 mask, float4 a, float4 b) {
+  float4 r;
+  for (int i = 0; i < 4; i++) {
+    r.v[i] = simd_detail::bits_of(mask.v[i]) ? a.v[i] : b.v[i];
+  }
+  return r;
+}
+
+inline float4 abs(float4 a) {
+  float4 r;
+  for (int i = 0; i < 4; i++) {
+    r.v[i] = std::fabs(a.v[i]);
+  }
+  return r;
+}
+inline float4 sqrt(float4 a) {
+  float4 r;
+  for (int i = 0; i < 4; i++) {
+    r.v[i] = std::sqrt(a.v[i]);
+  }
+  return r;
+}
+inline float4 round(float4 a) {
+  float4 r;
+  for (int i = 0; i < 4; i++) {
+    r.v[i] = std::nearbyint(a.v[i]);
+  }
+  return r;
+}
+inline bool any(float4 mask) {
+  for (int i = 0; i < 4; i++) {
+    if (simd_detail::bits_of(mask.v[i])) {
+      return true;
+    }
+  }
+  return false;
+}
+inline float4 test_bits(float4 a, int bits) {
+  float4 r;
+  for (int i = 0; i < 4; i++) {
+    r.v[i] = simd_detail::mask_from_bool(static_cast<int>(a.v[i]) & bits);
+  }
+  return r;
+}
+inline float4 pow2(float4 n) {
+  float4 r;
+  for (int i = 0; i < 4; i++) {
+    uint32_t biased = static_cast<uint32_t>(static_cast<int>(n.v[i]) + 127);
+    r.v[i] = simd_detail::float_from_bits(biased << 23);
+  }
+  return r;
+}
+inline float4 frexp(float4 a, float4 &exponent) {
+  float4 r;
+  for (int i = 0; i < 4; i++) {
+    uint32_t bits = simd_detail::bits_of(a.v[i]);
+    exponent.v[i] = static_cast<float>(static_cast<int>(bits >> 23) - 126);
+    r.v[i] = simd_detail::float_from_bits((bits & 0x007FFFFFu) | 0x3F000000u);
+  }
+  return r;
+}
+
+#endif
+
+/*
+  Wider vectors made of two narrower ones. Every operation is applied to both
+  halves, which the compiler interleaves, so a pair still keeps both halves'
+  registers busy.
+*/
+
+template <typename Half> struct float_pair {
+
+  Half lo, hi;
+
+  float_pair() {}
+  float_pair(Half lo, Half hi) : lo(lo), hi(hi) {}
+  explicit float_pair(float f) : lo(f), hi(f) {}
+
+  static float_pair load(const float *p) {
+    return float_pair(Half::load(p), Half::load(p + Half::LANES));
+  }
+  void store(float *p) const {
+    lo.store(p);
+    hi.store(p + Half::LANES);
+  }
+
+  static constexpr int LANES = 2 * Half::LANES;
+
+};
+
+#define SIMD_PAIR_UNARY(op)                                                    \
+  template <typename Half>                                                     \
+  inline float_pair<Half> op(float_pair<Half> a) {                             \
+    return float_pair<Half>(op(a.lo), op(a.hi));                               \
+  }
+
+#define SIMD_PAIR_BINARY(op)                                                   \
+  template <typename Half>                                                     \
+  inline float_pair<Half> op(float_pair<Half> a, float_pair<Half> b) {         \
+    return float_pair<Half>(op(a.lo, b.lo), op(a.hi, b.hi));                   \
+  }
+
+SIMD_PAIR_BINARY(operator+)
+SIMD_PAIR_BINARY(operator-)
+SIMD_PAIR_BINARY(operator*)
+SIMD_PAIR_BINARY(operator/)
+SIMD_PAIR_BINARY(operator<)
+SIMD_PAIR_BINARY(operator<=)
+SIMD_PAIR_BINARY(operator>)
+SIMD_PAIR_BINARY(operator&)
+SIMD_PAIR_BINARY(operator|)
+SIMD_PAIR_BINARY(min)
+SIMD_PAIR_BINARY(max)
+SIMD_PAIR_UNARY(operator-)
+SIMD_PAIR_UNARY(abs)
+SIMD_PAIR_UNARY(sqrt)
+SIMD_PAIR_UNARY(round)
+SIMD_PAIR_UNARY(pow2)
+
+#undef SIMD_PAIR_UNARY
+#undef SIMD_PAIR_BINARY
+
+template <typename Half>
+inline float_pair<Half> select(float_pair<Half> mask, float_pair<Half> a,
+                               float_pair<Half> b) {
+  return float_pair<Half>(select(mask.lo, a.lo, b.lo),
+                          select(mask.hi, a.hi, b.hi));
+}
+
+template <typename Half> inline bool any(float_pair<Half> mask) {
+  return any(mask.lo) || any(mask.hi);
+}
+
+template <typename Half>
+inline float_pair<Half> test_bits(float_pair<Half> a, int bits) {
+  return float_pair<Half>(test_bits(a.lo, bits), test_bits(a.hi, bits));
+}
+
+template <typename Half>
+inline float_pair<Half> frexp(float_pair<Half> a, float_pair<Half> &exponent) {
+  return float_pair<Half>(frexp(a.lo, exponent.lo), frexp(a.hi, exponent.hi));
+}
+
+#if defined(MATH_AVX)
+
+/*
+  Native 8-wide vector for builds with AVX enabled. AVX1 has no 256-bit integer
+  instructions, so the few operations that work on the bit pattern (test_bits,
+  pow2 and the exponent in frexp) run on the two 128-bit halves.
+*/
+
+struct float8 {
+
+  __m256 v;
+  float8() : v(_mm256_setzero_ps()) {}
+  explicit float8(__m256 v) : v(v) {}
+  explicit float8(float f) : v(_mm256_set1_ps(f)) {}
+  float8(float4 lo, float4 hi)
+      : v(_mm256_insertf128_ps(_mm256_castps128_ps256(lo.v), hi.v, 1)) {}
+
+  static float8 load(const float *p) {
+    return float8(_mm256_loadu_ps(p));
+  }
+  void store(float *p) const {
+    _mm256_storeu_ps(p, v);
+  }
+
+  float4 lo() const {
+    return float4(_mm256_castps256_ps128(v));
+  }
+  float4 hi() const {
+    return float4(_mm256_extractf128_ps(v, 1));
+  }
+
+  static constexpr int LANES = 8;
+
+};
+
+inline float8 operator+(float8 a, float8 b) {
+  return float8(_mm256_add_ps(a.v, b.v));
+}
+inline float8 operator-(float8 a, float8 b) {
+  return float8(_mm256_sub_ps(a.v, b.v));
+}
+inline float8 operator*(float8 a, float8 b) {
+  return float8(_mm256_mul_ps(a.v, b.v));
+}
+inline float8 operator/(float8 a, float8 b) {
+  return float8(_mm256_div_ps(a.v, b.v));
+}
+inline float8 operator-(float8 a) {
+  return float8(_mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)));
+}
+
+inline float8 operator<(float8 a, float8 b) {
+  return float8(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ));
+}
+inline float8 operator<=(float8 a, float8 b) {
+  return float8(_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ));
+}
+inline float8 operator>(float8 a, float8 b) {
+  return float8(_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ));
+}
+inline float8 operator&(float8 a, float8 b) {
+  return float8(_mm256_and_ps(a.v, b.v));
+}
+inline float8 operator|(float8 a, float8 b) {
+  return float8(_mm256_or_ps(a.v, b.v));
+}
+
+// Same and/andnot/or blend as float4. GCC turns _mm256_blendv_ps on a
+// comparison result into per-lane branches.
+inline float8 select(float8 mask, float8 a, float8 b) {
+  return float8(
+      _mm256_or_ps(_mm256_and_ps(mask.v, a.v), _mm256_andnot_ps(mask.v, b.v)));
+}
+
+inline float8 abs(float8 a) {
+  return float8(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v));
+}
+inline float8 min(float8 a, float8 b) {
+  return float8(_mm256_min_ps(a.v, b.v));
+}
+inline float8 max(float8 a, float8 b) {
+  return float8(_mm256_max_ps(a.v, b.v));
+}
+inline float8 sqrt(float8 a) {
+  return float8(_mm256_sqrt_ps(a.v));
+}
+inline float8 round(float8 a) {
+  return float8(
+      _mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+}
+
+inline bool any(float8 mask) {
+  return _mm256_movemask_ps(mask.v) != 0;
+}
+
+inline float8 test_bits(float8 a, int bits) {
+  return float8(test_bits(a.lo(), bits), test_bits(a.hi(), bits));
+}
+inline float8 pow2(float8 n) {
+  return float8(pow2(n.lo()), pow2(n.hi()));
+}
+inline float8 frexp(float8 a, float8 &exponent) {
+
+  float4 exponent_lo, exponent_hi;
+  float8 mantissa(frexp(a.lo(), exponent_lo), frexp(a.hi(), exponent_hi));
+  exponent = float8(exponent_lo, exponent_hi);
+
+  return mantissa;
+
+}
+
+#else
+
+using float8 = float_pair<float4>;
+
+#endif
+
+// No build configuration enables AVX-512, so 16 lanes are always two float8s
+using float16 = float_pair<float8>;
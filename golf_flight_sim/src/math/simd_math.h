@@ -0,0 +1,164 @@
+#pragma once
+
+#include "simd.h"
+
+/*
+  Vectorized atan, exp, log and sincos for the batched kernels, so they don't
+  drop back to scalar libm calls lane by lane. Each function is a template
+  over the vector type and works for float4, float8 and float16.
+
+  The reductions and polynomials are the single precision ones from Cephes.
+  Max errors measured against double precision libm by the
+  --benchmark-simd-math command (see benchmarks/simd_math_benchmark.h), the
+  same for every vector width and backend:
+
+    simd_atan    [-1e4, 1e4]       1.44 ulp
+    simd_exp     [-87, 88]         0.98 ulp
+    simd_log     [1e-30, 1e30]     0.79 ulp
+    simd_sincos  [-8192, 8192]     7.7e-8 absolute
+
+  sin and cos stay within 7.7e-8 of the exact value everywhere, but close to
+  their zeros at large |x| that is up to 52 ulp of the (tiny) result, since
+  the argument reduction is only done in float.
+
+  Inputs outside these ranges are handled as documented on each function
+  rather than following IEEE to the letter.
+*/
+
+// Arc tangent. Reduces |x| to [0, tan(pi/8)] using atan(x) = pi/4 +
+// atan((x - 1) / (x + 1)) and atan(x) = pi/2 - atan(1/x).
+template <typename V> inline V simd_atan(V x) {
+
+  const V zero(0.0f);
+  const V one(1.0f);
+  const V tan_3_pi_8(2.414213562373095f);
+  const V tan_pi_8(0.4142135623730950f);
+
+  V abs_x = abs(x);
+  V is_large = abs_x > tan_3_pi_8;
+  V is_medium = abs_x > tan_pi_8;
+
+  V offset = select(is_large, V(1.5707963267948966f),
+                    select(is_medium, V(0.7853981633974483f), zero));
+  V r = select(is_large, -one / abs_x,
+               select(is_medium, (abs_x - one) / (abs_x + one), abs_x));
+
+  V r_sq = r * r;
+
+  V p(8.05374449538e-2f);
+  p = p * r_sq + V(-1.38776856032e-1f);
+  p = p * r_sq + V(1.99777106478e-1f);
+  p = p * r_sq + V(-3.33329491539e-1f);
+  V y = offset + (p * r_sq * r + r);
+
+  return select(x < zero, -y, y);
+
+}
+
+// e^x. Inputs are clamped to [-87.33, 88.3], so large negative inputs give
+// the smallest normal float instead of underflowing and large positive ones
+// give about 2e38 instead of infinity.
+template <typename V> inline V simd_exp(V x) {
+
+  x = min(max(x, V(-87.33654f)), V(88.3f));
+
+  // x = n * ln(2) + r, with ln(2) split in two so r stays exact
+  V n = round(x * V(1.44269504088896341f));
+  V r = x - n * V(0.693359375f);
+  r = r - n * V(-2.12194440e-4f);
+
+  V r_sq = r * r;
+
+  V p(1.9875691500e-4f);
+  p = p * r + V(1.3981999507e-3f);
+  p = p * r + V(8.3334519073e-3f);
+  p = p * r + V(4.1665795894e-2f);
+  p = p * r + V(1.6666665459e-1f);
+  p = p * r + V(5.0000001201e-1f);
+  p = p * r_sq + r + V(1.0f);
+
+  return p * pow2(n);
+
+}
+
+// Natural logarithm for positive normal floats. Returns -inf for zero and NaN
+// for negative inputs. Denormals and infinity aren't handled.
+template <typename V> inline V simd_log(V x) {
+
+  const V one(1.0f);
+
+  // x = m * 2^e with m in [sqrt(2)/2, sqrt(2)), then log(x) = log(m) + e *
+  // ln(2) where log(m) = log(1 + f) is a polynomial in f = m - 1.
+  V e;
+  V m = frexp(x, e);
+  V is_small = m < V(0.707106781186547524f);
+  e = e - (is_small & one);
+  V f = select(is_small, m + m, m) - one;
+
+  V f_sq = f * f;
+
+  V p(7.0376836292e-2f);
+  p = p * f + V(-1.1514610310e-1f);
+  p = p * f + V(1.1676998740e-1f);
+  p = p * f + V(-1.2420140846e-1f);
+  p = p * f + V(1.4249322787e-1f);
+  p = p * f + V(-1.6668057665e-1f);
+  p = p * f + V(2.0000714765e-1f);
+  p = p * f + V(-2.4999993993e-1f);
+  p = p * f + V(3.3333331174e-1f);
+
+  // ln(2) split in two like in simd_exp
+  V y = p * f_sq * f + e * V(-2.12194440e-4f);
+  y = y - V(0.5f) * f_sq;
+  V result = f + y + e * V(0.693359375f);
+
+  result = select(x <= V(0.0f), V(-INFINITY), result);
+
+  return select(x < V(0.0f), V(NAN), result);
+
+}
+
+// Sine and cosine of x in one go. Reduces x to [-pi/4, pi/4] around the
+// nearest multiple of pi/2 and evaluates the minimax polynomials from
+// Cephes' sinf/cosf there. The three part reduction loses accuracy past
+// |x| = 8192.
+template <typename V> inline void simd_sincos(V x, V &s, V &c) {
+
+  const V two_over_pi(0.63661977236758134f);
+
+  // Cody-Waite split of pi/2 so the reduction stays accurate
+  const V pi_2_hi(1.5703125f);
+  const V pi_2_mid(4.837512969970703125e-4f);
+  const V pi_2_lo(7.54978995489188216e-8f);
+
+  V quadrant = round(x * two_over_pi);
+
+  V r = x - quadrant * pi_2_hi;
+  r = r - quadrant * pi_2_mid;
+  r = r - quadrant * pi_2_lo;
+
+  V r_sq = r * r;
+
+  V sin_r(-1.9515295891e-4f);
+  sin_r = sin_r * r_sq + V(8.3321608736e-3f);
+  sin_r = sin_r * r_sq + V(-1.6666654611e-1f);
+  sin_r = sin_r * r_sq * r + r;
+
+  V cos_r(2.443315711809948e-5f);
+  cos_r = cos_r * r_sq + V(-1.388731625493765e-3f);
+  cos_r = cos_r * r_sq + V(4.166664568298827e-2f);
+  cos_r = cos_r * r_sq * r_sq - V(0.5f) * r_sq + V(1.0f);
+
+  // Quadrants 1 and 3 swap sine and cosine
+  V swap = test_bits(quadrant, 1);
+  V sin_x = select(swap, cos_r, sin_r);
+  V cos_x = select(swap, sin_r, cos_r);
+
+  // Sine is negative in quadrants 2 and 3, cosine in 1 and 2
+  V sin_negative = test_bits(quadrant, 2);
+  V cos_negative = test_bits(quadrant + V(1.0f), 2);
+
+  s = select(sin_negative, -sin_x, sin_x);
+  c = select(cos_negative, -cos_x, cos_x);
+
+}
@@ -30,6 +30,17 @@ inline float m_to_yd(float m) {
   return m * 1.09361f;
 }
 
+inline float yd_to_m(float yd) {
+  return yd * 0.9144f;
+}
+
 inline float m_to_ft(float m) {
   return m * 3.28084f;
-}
\ No newline at end of file
+}
+inline float ft_to_m(float ft) {
+  return ft * 0.3048f;
+}
+
+inline float f_to_c(float f) {
+  return (f - 32.0f) * 0.5555556f;
+}
@@ -1,25 +1,55 @@
 #pragma once
 
+#include "math_inline.h"
+
+// Header-only and constexpr for the same reasons as vec3. Only used for
+// screen space drawing, so it's left as plain scalar code.
 struct vec2 {
 
   float x, y;
 
-  vec2();
-  vec2(float x, float y);
+  MATH_INLINE constexpr vec2() : x(0.0f), y(0.0f) {}
+  MATH_INLINE constexpr vec2(float x, float y) : x(x), y(y) {}
+
+  MATH_INLINE constexpr void zero() {
+    x = 0.0f;
+    y = 0.0f;
+  }
+
+  MATH_INLINE constexpr vec2 perp() const {
+    return vec2(y, -x);
+  }
+
+  MATH_INLINE constexpr vec2 operator+(vec2 v) const {
+    return vec2(x + v.x, y + v.y);
+  }
+
+  MATH_INLINE constexpr vec2 operator-(vec2 v) const {
+    return vec2(x - v.x, y - v.y);
+  }
+
+  MATH_INLINE constexpr vec2 operator*(float n) const {
+    return vec2(x * n, y * n);
+  }
+
+  MATH_INLINE constexpr vec2 operator/(float n) const {
+    return vec2(x / n, y / n);
+  }
+
+  MATH_INLINE constexpr vec2 &operator+=(vec2 v) {
+    return *this = *this + v;
+  }
 
-  ~vec2() = default;
+  MATH_INLINE constexpr vec2 &operator-=(vec2 v) {
+    return *this = *this - v;
+  }
 
-  void zero();
-  vec2 perp() const;
-  
-  vec2 operator+(vec2 v) const;
-  vec2 operator-(vec2 v) const;
-  vec2 operator*(float n) const;
-  vec2 operator/(float n) const;
+  MATH_INLINE constexpr vec2 &operator*=(float n) {
+    return *this = *this * n;
+  }
 
-  vec2 &operator+=(vec2 v);
-  vec2 &operator-=(vec2 v);
-  vec2 &operator*=(float n);
-  vec2 &operator/=(float n);
+  MATH_INLINE constexpr vec2 &operator/=(float n) {
+    return *this = *this / n;
+  }
 
-};
\ No newline at end of file
+};
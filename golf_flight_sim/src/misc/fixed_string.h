@@ -0,0 +1,72 @@
+#pragma once
+
+#include "string_operations.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+/*
+  Small string stored inline in a fixed size buffer. Used for the UI labels
+  that get rewritten every frame, so updating them never touches the heap.
+  Anything that doesn't fit is truncated.
+*/
+
+template <size_t CAPACITY> class FixedString {
+private:
+  static_assert(CAPACITY > 1, "FixedString needs room for a terminator");
+
+  char data[CAPACITY];
+  size_t length;
+
+public:
+  FixedString() : length(0) {
+    data[0] = '\0';
+  }
+
+  FixedString(std::string_view str) : length(0) {
+    data[0] = '\0';
+    append(str);
+  }
+
+  FixedString &operator=(std::string_view str) {
+    clear();
+    return append(str);
+  }
+
+  void clear() {
+    length = 0;
+    data[0] = '\0';
+  }
+
+  FixedString &append(std::string_view str) {
+    size_t count = std::min(str.size(), CAPACITY - 1 - length);
+    std::memcpy(data + length, str.data(), count);
+    length += count;
+    data[length] = '\0';
+    return *this;
+  }
+
+  FixedString &append_fixed(float f, int precision) {
+    length += string_ops::format_fixed(data + length, CAPACITY - length, f,
+                                       precision);
+    return *this;
+  }
+
+  FixedString &append_int(long long i) {
+    length += string_ops::format_int(data + length, CAPACITY - length, i);
+    return *this;
+  }
+
+  const char *c_str() const {
+    return data;
+  }
+
+  size_t size() const {
+    return length;
+  }
+
+  std::string_view view() const {
+    return std::string_view(data, length);
+  }
+};
@@ -0,0 +1,156 @@
+#include "mapped_file.h"
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile() {
+
+  this->data = nullptr;
+  this->size = 0;
+  this->file_handle = INVALID_HANDLE_VALUE;
+  this->mapping_handle = nullptr;
+
+}
+
+bool MappedFile::open(const char *path) {
+
+  close();
+
+  file_handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+  LARGE_INTEGER file_size;
+
+  if (file_handle == INVALID_HANDLE_VALUE
+      || !GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0) {
+    close();
+    return false;
+  }
+
+  mapping_handle =
+      CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+  if (mapping_handle == nullptr) {
+    close();
+    return false;
+  }
+
+  data = static_cast<const uint8_t *>(
+      MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+
+  if (data == nullptr) {
+    close();
+    return false;
+  }
+
+  size = static_cast<size_t>(file_size.QuadPart);
+
+  return true;
+
+}
+
+void MappedFile::close() {
+
+  if (data != nullptr) {
+    UnmapViewOfFile(data);
+  }
+
+  if (mapping_handle != nullptr) {
+    CloseHandle(mapping_handle);
+  }
+
+  if (file_handle != INVALID_HANDLE_VALUE) {
+    CloseHandle(file_handle);
+  }
+
+  data = nullptr;
+  size = 0;
+  file_handle = INVALID_HANDLE_VALUE;
+  mapping_handle = nullptr;
+
+}
+
+#else
+
+MappedFile::MappedFile() {
+
+  this->data = nullptr;
+  this->size = 0;
+  this->file_descriptor = -1;
+
+}
+
+bool MappedFile::open(const char *path) {
+
+  close();
+
+  file_descriptor = ::open(path, O_RDONLY);
+
+  struct stat file_status;
+
+  if (file_descriptor < 0 || fstat(file_descriptor, &file_status) != 0
+      || file_status.st_size == 0) {
+    close();
+    return false;
+  }
+
+  size = static_cast<size_t>(file_status.st_size);
+
+  void *mapping =
+      mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+
+  if (mapping == MAP_FAILED) {
+    close();
+    return false;
+  }
+
+  data = static_cast<const uint8_t *>(mapping);
+
+  return true;
+
+}
+
+void MappedFile::close() {
+
+  if (data != nullptr) {
+    munmap(const_cast<uint8_t *>(data), size);
+  }
+
+  if (file_descriptor >= 0) {
+    ::close(file_descriptor);
+  }
+
+  data = nullptr;
+  size = 0;
+  file_descriptor = -1;
+
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+bool MappedFile::is_open() const {
+  return data != nullptr;
+}
+
+const uint8_t *MappedFile::get_data() const {
+  return data;
+}
+
+size_t MappedFile::get_size() const {
+  return size;
+}
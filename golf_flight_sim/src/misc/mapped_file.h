@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+  A whole file mapped read-only into memory. Nothing is read when it's
+  opened; the OS pages the file in as it's touched, so touching it can block
+  on the disk.
+*/
+class MappedFile {
+private:
+  const uint8_t *data;
+  size_t size;
+
+#if defined(_WIN32)
+  void *file_handle;
+  void *mapping_handle;
+#else
+  int file_descriptor;
+#endif
+
+public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  // Returns false if the file can't be opened or is empty
+  bool open(const char *path);
+  void close();
+
+  bool is_open() const;
+  const uint8_t *get_data() const;
+  size_t get_size() const;
+
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+/*
+  Fixed capacity lock-free queue for one producer thread and one consumer
+  thread. CAPACITY has to be a power of two.
+*/
+
+template <typename T, uint32_t CAPACITY> class SPSCQueue {
+private:
+  static_assert((CAPACITY & (CAPACITY - 1)) == 0,
+                "SPSCQueue capacity must be a power of two");
+
+  T items[CAPACITY];
+
+  // Keep the indices on separate cache lines so the two threads don't fight
+  // over the same line.
+  alignas(64) std::atomic<uint32_t> head{0};
+  alignas(64) std::atomic<uint32_t> tail{0};
+
+public:
+  // Returns false if the queue is full.
+  bool push(const T &item) {
+    uint32_t current_head = head.load(std::memory_order_relaxed);
+
+    if (current_head - tail.load(std::memory_order_acquire) >= CAPACITY) {
+      return false;
+    }
+
+    items[current_head & (CAPACITY - 1)] = item;
+    head.store(current_head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Returns false if the queue is empty.
+  bool pop(T &item) {
+    uint32_t current_tail = tail.load(std::memory_order_relaxed);
+
+    if (current_tail == head.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    // Moved out, so an item that owns something doesn't keep it alive in
+    // the queue until the slot is reused
+    item = std::move(items[current_tail & (CAPACITY - 1)]);
+    tail.store(current_tail + 1, std::memory_order_release);
+    return true;
+  }
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <charconv>
+#include <cstddef>
 #include <iomanip>
 #include <sstream>
 #include <string>
@@ -13,4 +15,47 @@ inline std::string float_to_string_formatted(float f, int precision) {
   return stream.str();
 }
 
+// Allocation-free alternative to float_to_string_formatted for per-frame
+// paths. Writes the value with a fixed number of decimals into the caller's
+// buffer and null terminates it. Returns the number of characters written
+// (not counting the terminator), or 0 if the buffer is too small.
+inline size_t format_fixed(char *buffer, size_t buffer_size, float f,
+                           int precision) {
+
+  if (buffer_size == 0) {
+    return 0;
+  }
+
+  std::to_chars_result result =
+      std::to_chars(buffer, buffer + buffer_size - 1, f,
+                    std::chars_format::fixed, precision);
+
+  if (result.ec != std::errc()) {
+    buffer[0] = '\0';
+    return 0;
+  }
+
+  *result.ptr = '\0';
+  return static_cast<size_t>(result.ptr - buffer);
+}
+
+// Same as format_fixed, for integers.
+inline size_t format_int(char *buffer, size_t buffer_size, long long i) {
+
+  if (buffer_size == 0) {
+    return 0;
+  }
+
+  std::to_chars_result result =
+      std::to_chars(buffer, buffer + buffer_size - 1, i);
+
+  if (result.ec != std::errc()) {
+    buffer[0] = '\0';
+    return 0;
+  }
+
+  *result.ptr = '\0';
+  return static_cast<size_t>(result.ptr - buffer);
+}
+
 } // namespace string_ops
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/*
+  Lock-free triple buffer for handing the latest state from one producer
+  thread to one consumer thread.
+
+  The producer always owns a back buffer and the consumer always owns a front
+  buffer; the third one sits in the middle. publish() swaps the back buffer
+  into the middle and flags it as fresh, acquire() swaps the middle into the
+  front if a fresh one is waiting. Neither side ever blocks, and the consumer
+  always sees the most recently published value.
+*/
+
+template <typename T> class TripleBuffer {
+private:
+  static const uint8_t INDEX_MASK = 0x3;
+  static const uint8_t FRESH_BIT = 0x4;
+
+  T buffers[3];
+
+  // Index of the middle buffer plus the fresh bit
+  std::atomic<uint8_t> middle;
+
+  uint8_t back;
+  uint8_t front;
+
+public:
+  TripleBuffer() : middle(1), back(0), front(2) {}
+
+  // Producer side: the buffer to fill in before calling publish()
+  T &get_back() {
+    return buffers[back];
+  }
+
+  void publish() {
+    uint8_t previous = middle.exchange(static_cast<uint8_t>(back | FRESH_BIT),
+                                       std::memory_order_acq_rel);
+    back = previous & INDEX_MASK;
+  }
+
+  // Consumer side: returns the newest published buffer. The reference stays
+  // valid until the next call to acquire().
+  const T &acquire() {
+    if (middle.load(std::memory_order_relaxed) & FRESH_BIT) {
+      uint8_t previous =
+          middle.exchange(front, std::memory_order_acq_rel);
+      front = previous & INDEX_MASK;
+    }
+    return buffers[front];
+  }
+};